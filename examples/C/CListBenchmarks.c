@@ -0,0 +1,524 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L // sched_yield
+#endif
+
+#include "CCollections/CList.h"
+#include "CCollections/CSortedList.h"
+#include "CCollections/CCapacityProfile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#if defined(_WIN32)
+    #ifndef WIN32_LEAN_AND_MEAN
+    #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+    typedef HANDLE BenchThread;
+    #define benchYield() SwitchToThread()
+#else
+    #include <pthread.h>
+    #include <sched.h>
+    typedef pthread_t BenchThread;
+    #define benchYield() sched_yield()
+#endif
+
+static double benchSeconds(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// previous clistFindIndex, one memcmp per item
+static uint32_t benchFindIndexLoop(CList* list, void* item)
+{
+    uint8_t* itr = (uint8_t*)clistBegin(list);
+    uint8_t* end = (uint8_t*)clistEnd(list);
+    uint32_t stride = list->Stride;
+    for (uint32_t i = 0; itr != end; itr += stride, ++i)
+    {
+        if (memcmp(itr, item, stride) == 0)
+        {
+            return i;
+        }
+    }
+    return CCOLLECTION_ERROR;
+}
+
+// previous clistFindZeroIndex, bytes or'ed one at a time
+static uint32_t benchFindZeroIndexLoop(CList* list)
+{
+    uint8_t* itr = (uint8_t*)clistBegin(list);
+    uint8_t* end = (uint8_t*)clistEnd(list);
+    uint32_t stride = list->Stride;
+    for (uint32_t i = 0; itr != end; itr += stride, ++i)
+    {
+        uint8_t bytesOr = 0;
+        for (uint8_t* byte = itr, *byteEnd = itr + stride; byte != byteEnd; ++byte)
+        {
+            bytesOr |= *byte;
+        }
+        if (bytesOr == 0)
+        {
+            return i;
+        }
+    }
+    return CCOLLECTION_ERROR;
+}
+
+static const char* benchLevelName(uint32_t level)
+{
+    switch (level)
+    {
+    case CSIMD_LEVEL_SSE2: return "sse2";
+    case CSIMD_LEVEL_AVX2: return "avx2";
+    case CSIMD_LEVEL_AVX512: return "avx512";
+    default: return "scalar";
+    }
+}
+
+// 100k items of nonzero bytes, searched item and zero item at the end so every find scans the whole list
+static void benchFind(uint32_t stride)
+{
+    const uint32_t count = 100000;
+    const uint32_t repeats = 50;
+    CList list = clistCreate(stride, count);
+    uint8_t item[64];
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        for (uint32_t b = 0; b < stride; ++b)
+        {
+            item[b] = (uint8_t)((i * 31 + b * 7) % 254 + 2);
+        }
+        clistAdd(&list, item);
+    }
+    memset(clistItemAt(&list, count - 2), 0, stride);
+    uint8_t* last = (uint8_t*)clistLast(&list);
+    memset(last, 1, stride);
+    memcpy(item, last, stride);
+
+    volatile uint32_t sink = 0;
+    double t0 = benchSeconds();
+    for (uint32_t r = 0; r < repeats; ++r)
+        sink += benchFindIndexLoop(&list, item);
+    double findLoop = benchSeconds() - t0;
+    t0 = benchSeconds();
+    for (uint32_t r = 0; r < repeats; ++r)
+        sink += benchFindZeroIndexLoop(&list);
+    double zeroLoop = benchSeconds() - t0;
+    printf("stride %2u  loop    find %7.3f ms  zero %7.3f ms\n", stride, findLoop * 1e3 / repeats, zeroLoop * 1e3 / repeats);
+
+    const uint32_t detected = csimdLevel();
+    for (uint32_t level = CSIMD_LEVEL_SCALAR; level <= detected; ++level)
+    {
+        csimdSetLevel(level);
+        t0 = benchSeconds();
+        for (uint32_t r = 0; r < repeats; ++r)
+            sink += clistFindIndex(&list, item);
+        double find = benchSeconds() - t0;
+        t0 = benchSeconds();
+        for (uint32_t r = 0; r < repeats; ++r)
+            sink += clistFindZeroIndex(&list);
+        double zero = benchSeconds() - t0;
+        printf("stride %2u  %-7s find %7.3f ms  zero %7.3f ms\n", stride, benchLevelName(level), find * 1e3 / repeats, zero * 1e3 / repeats);
+    }
+    csimdSetLevel(detected);
+    clistFree(&list);
+    (void)sink;
+}
+
+// previous growth, heap realloc copies the whole list on every doubling
+static void benchGrowHeapCopy(CList* list)
+{
+    uint32_t capacity = list->Capacity * 2;
+    uint8_t* data = (uint8_t*)_mm_malloc((size_t)list->Stride * capacity, CCOLLECTIONS_ALIGNMENT);
+    memcpy(data, list->Data, (size_t)list->Stride * list->Count);
+    _mm_free(list->Data);
+    list->Data = data;
+    list->Capacity = capacity;
+}
+
+// append 512 MB of 16 byte items one at a time, worst single append is the stall a frame would see
+static void benchGrowth(void)
+{
+    const uint32_t count = 32u << 20;
+    uint32_t item[4] = { 0 };
+    for (uint32_t pass = 0; pass < 2; ++pass)
+    {
+        CList list;
+        list.Count = 0;
+        list.Capacity = 1024;
+        list.Stride = sizeof(item);
+        list.Allocator = NULL;
+        list.Data = (uint8_t*)_mm_malloc((size_t)list.Stride * list.Capacity, CCOLLECTIONS_ALIGNMENT);
+        double worst = 0.0;
+        double t0 = benchSeconds();
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            item[0] = i;
+            if (list.Count == list.Capacity)
+            {
+                double g0 = benchSeconds();
+                if (pass == 0)
+                    benchGrowHeapCopy(&list);
+                else
+                    clistEnsureCapacity(&list, list.Count + 1);
+                double g = benchSeconds() - g0;
+                worst = g > worst ? g : worst;
+            }
+            clistAdd(&list, item);
+        }
+        double total = benchSeconds() - t0;
+        printf("grow 512 MB  %-7s total %8.1f ms  worst grow %7.2f ms\n", pass == 0 ? "copy" : "grow", total * 1e3, worst * 1e3);
+        if (pass == 0)
+            _mm_free(list.Data);
+        else
+            clistFree(&list);
+    }
+}
+
+// warm up 64 lists to random peaks twice - the first run records a capacity profile and saves it,
+// the second loads it and reserves each list once at its recorded peak
+static void benchCapacityProfile(void)
+{
+    enum { listCount = 64 };
+    const char* path = "clist_capacity_profile.txt";
+    uint32_t item[4] = { 0 };
+    uint32_t peaks[listCount];
+    uint32_t state = 0x9E3779B9u;
+    for (uint32_t i = 0; i < listCount; ++i)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        peaks[i] = 1000 + state % 200000;
+    }
+
+    for (uint32_t pass = 0; pass < 2; ++pass)
+    {
+        CList profile = ccapacityprofileCreate(listCount);
+        if (pass == 1 && ccapacityprofileLoad(&profile, path) == 0)
+        {
+            printf("capacity profile  load failed\n");
+            ccapacityprofileFree(&profile);
+            return;
+        }
+        CList lists[listCount];
+        double t0 = benchSeconds();
+        for (uint32_t i = 0; i < listCount; ++i)
+        {
+            lists[i] = clistCreate(sizeof(item), ccapacityprofileCapacity(&profile, i, 16));
+            ccapacityprofileRecordList(&profile, i, &lists[i]);
+            for (uint32_t n = 0; n < peaks[i]; ++n)
+            {
+                item[0] = n;
+                if (lists[i].Count == lists[i].Capacity)
+                {
+                    clistEnsureCapacity(&lists[i], lists[i].Count + 1);
+                    ccapacityprofileRecordList(&profile, i, &lists[i]);
+                }
+                clistAdd(&lists[i], item);
+            }
+            ccapacityprofileRecordList(&profile, i, &lists[i]);
+        }
+        double total = benchSeconds() - t0;
+
+        CSize growths = 0;
+        for (uint32_t i = 0; i < listCount; ++i)
+        {
+            growths += ccapacityprofileFind(&profile, i)->GrowthCount;
+            clistFree(&lists[i]);
+        }
+        printf("capacity profile  %-8s total %7.2f ms  growths %u\n", pass == 0 ? "record" : "reserved", total * 1e3, (uint32_t)growths);
+        if (pass == 0 && ccapacityprofileSave(&profile, path) == 0)
+        {
+            printf("capacity profile  save failed\n");
+            ccapacityprofileFree(&profile);
+            return;
+        }
+        ccapacityprofileFree(&profile);
+    }
+    remove(path);
+}
+
+// 100k lists of 6 items, as per entity inventories - build, sum and free heap lists versus inline lists
+static void benchInline(void)
+{
+    const uint32_t lists = 100000;
+    const uint32_t items = 6;
+    typedef CLIST_INLINE(uint32_t, 8) InlineList;
+    CList* heap = (CList*)malloc(sizeof(CList) * lists);
+    InlineList* inl = (InlineList*)malloc(sizeof(InlineList) * lists);
+    volatile uint32_t sink = 0;
+    for (uint32_t pass = 0; pass < 2; ++pass)
+    {
+        double t0 = benchSeconds();
+        for (uint32_t l = 0; l < lists; ++l)
+        {
+            CList* list = &heap[l];
+            if (pass == 1)
+            {
+                clistAllocInline(&inl[l]);
+                list = &inl[l].List;
+            }
+            else
+            {
+                clistAlloc(list, sizeof(uint32_t), 8);
+            }
+            for (uint32_t i = 0; i < items; ++i)
+            {
+                uint32_t item = l + i;
+                clistAdd(list, &item);
+            }
+        }
+        double build = benchSeconds() - t0;
+        t0 = benchSeconds();
+        uint32_t sum = 0;
+        for (uint32_t l = 0; l < lists; ++l)
+        {
+            CList* list = pass == 1 ? &inl[l].List : &heap[l];
+            for (uint32_t* itr = (uint32_t*)clistBegin(list), *end = (uint32_t*)clistEnd(list); itr != end; ++itr)
+                sum += *itr;
+        }
+        double iterate = benchSeconds() - t0;
+        for (uint32_t l = 0; l < lists; ++l)
+            clistFree(pass == 1 ? &inl[l].List : &heap[l]);
+        sink += sum;
+        printf("100k small   %-7s build %7.2f ms  iterate %7.2f ms\n", pass == 0 ? "heap" : "inline", build * 1e3, iterate * 1e3);
+    }
+    free(inl);
+    free(heap);
+    (void)sink;
+}
+
+#define BENCH_APPEND_THREADS 4
+#define BENCH_APPEND_ITEMS (1u << 22)
+
+typedef struct BenchAppender
+{
+    CList* list;
+    volatile uint32_t* lock;
+    // per thread list for the merge pass
+    CList local;
+    uint32_t mode;
+    uint32_t first;
+} BenchAppender;
+
+#if defined(_WIN32)
+static DWORD WINAPI benchAppendThread(LPVOID arg)
+#else
+static void* benchAppendThread(void* arg)
+#endif
+{
+    BenchAppender* appender = (BenchAppender*)arg;
+    const uint32_t count = BENCH_APPEND_ITEMS / BENCH_APPEND_THREADS;
+    for (uint32_t i = appender->first; i < appender->first + count; ++i)
+    {
+        if (appender->mode == 0)
+        {
+            while (catomicExchange32(appender->lock, 1))
+                benchYield();
+            clistAddGrow(appender->list, &i);
+            catomicStore32(appender->lock, 0);
+        }
+        else if (appender->mode == 1)
+        {
+            clistAddGrow(&appender->local, &i);
+        }
+        else
+        {
+            clistAddConcurrent(appender->list, &i);
+        }
+    }
+    return 0;
+}
+
+// 4 threads append 4M 4 byte items to one list - spin locked clistAddGrow, per thread lists merged after, concurrent append
+static void benchConcurrentAppend(void)
+{
+    static const char* names[3] = { "locked", "merged", "atomic" };
+    for (uint32_t mode = 0; mode < 3; ++mode)
+    {
+        CList list;
+        volatile uint32_t lock = 0;
+        BenchThread threads[BENCH_APPEND_THREADS];
+        BenchAppender appenders[BENCH_APPEND_THREADS];
+        if (mode == 2)
+            clistAllocConcurrent(&list, sizeof(uint32_t), BENCH_APPEND_ITEMS);
+        else
+            clistAlloc(&list, sizeof(uint32_t), 1024);
+        double t0 = benchSeconds();
+        for (uint32_t t = 0; t < BENCH_APPEND_THREADS; ++t)
+        {
+            appenders[t].list = &list;
+            appenders[t].lock = &lock;
+            appenders[t].mode = mode;
+            appenders[t].first = t * (BENCH_APPEND_ITEMS / BENCH_APPEND_THREADS);
+            if (mode == 1)
+                clistAlloc(&appenders[t].local, sizeof(uint32_t), 1024);
+#if defined(_WIN32)
+            threads[t] = CreateThread(NULL, 0, benchAppendThread, &appenders[t], 0, NULL);
+#else
+            pthread_create(&threads[t], NULL, benchAppendThread, &appenders[t]);
+#endif
+        }
+        for (uint32_t t = 0; t < BENCH_APPEND_THREADS; ++t)
+        {
+#if defined(_WIN32)
+            WaitForSingleObject(threads[t], INFINITE);
+            CloseHandle(threads[t]);
+#else
+            pthread_join(threads[t], NULL);
+#endif
+            if (mode == 1)
+            {
+                clistAddRangeGrow(&list, appenders[t].local.Data, appenders[t].local.Count);
+                clistFree(&appenders[t].local);
+            }
+        }
+        double seconds = benchSeconds() - t0;
+        printf("append 4x1M  %-7s total %8.2f ms  %s\n", names[mode], seconds * 1e3, list.Count == BENCH_APPEND_ITEMS ? "ok" : "LOST ITEMS");
+        clistFree(&list);
+    }
+}
+
+typedef struct BenchSortItem
+{
+    uint32_t key;
+    uint32_t value;
+} BenchSortItem;
+
+static int benchSortCompare(const void* a, const void* b)
+{
+    const uint32_t keyA = ((const BenchSortItem*)a)->key;
+    const uint32_t keyB = ((const BenchSortItem*)b)->key;
+    return (keyA > keyB) - (keyA < keyB);
+}
+
+static int benchSortCompareContext(const void* a, const void* b, void* context)
+{
+    (void)context;
+    return benchSortCompare(a, b);
+}
+
+// 4M random 8 byte items sorted by a 4 byte key - qsort, comparator sorts and radix sorts
+static void benchSort(void)
+{
+    static const char* names[6] = { "qsort", "intro", "stable", "radix", "radix/mt", "stable/mt" };
+    const uint32_t count = 1u << 22;
+    CList list = clistCreate(sizeof(BenchSortItem), count);
+    for (uint32_t method = 0; method < 6; ++method)
+    {
+        uint32_t seed = 12345;
+        list.Count = 0;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            BenchSortItem item = { seed, i };
+            clistAdd(&list, &item);
+        }
+        double t0 = benchSeconds();
+        switch (method)
+        {
+        case 0: qsort(list.Data, list.Count, list.Stride, benchSortCompare); break;
+        case 1: clistSort(&list, benchSortCompareContext, NULL); break;
+        case 2: clistSortStable(&list, benchSortCompareContext, NULL); break;
+        case 3: clistSortRadix(&list, 0, sizeof(uint32_t), CLIST_SORT_KEY_UINT); break;
+        case 4: clistSortRadixParallel(&list, 0, sizeof(uint32_t), CLIST_SORT_KEY_UINT, 0); break;
+        default: clistSortStableParallel(&list, benchSortCompareContext, NULL, 0); break;
+        }
+        double seconds = benchSeconds() - t0;
+        uint32_t bSorted = 1;
+        for (uint32_t i = 1; i < count; ++i)
+            bSorted &= benchSortCompare(clistItemAt(&list, i - 1), clistItemAt(&list, i)) <= 0;
+        printf("sort 4M      %-9s %8.2f ms  %s\n", names[method], seconds * 1e3, bSorted ? "ok" : "NOT SORTED");
+    }
+    clistFree(&list);
+}
+
+// previous sorted insert, binary search then shift the tail per item
+static void benchSortedInsertLoop(CList* list, BenchSortItem* items, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        CSize index = clistSortedUpperBound(list, &items[i], benchSortCompareContext, NULL);
+        clistEnsureCapacity(list, list->Count + 1);
+        uint8_t* dst = list->Data + (size_t)index * list->Stride;
+        memmove(dst + list->Stride, dst, (size_t)(list->Count - index) * list->Stride);
+        memcpy(dst, &items[i], list->Stride);
+        ++list->Count;
+    }
+}
+
+// previous remove, binary search then shift the tail per item
+static void benchSortedRemoveLoop(CList* list, BenchSortItem* items, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        CSize index = clistSortedFindIndex(list, &items[i], benchSortCompareContext, NULL);
+        if (index != CCOLLECTION_NOT_FOUND)
+            clistRemoveAt(list, index);
+    }
+}
+
+// 1M item sorted index, one frame of 10k random inserts then 10k removes
+static void benchSortedList(void)
+{
+    const uint32_t count = 1u << 20;
+    const uint32_t batch = 10000;
+    BenchSortItem* items = (BenchSortItem*)malloc(sizeof(BenchSortItem) * batch);
+    for (uint32_t pass = 0; pass < 2; ++pass)
+    {
+        CList list = clistCreate(sizeof(BenchSortItem), count + batch);
+        uint32_t seed = 777;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            BenchSortItem item = { seed, i };
+            clistAdd(&list, &item);
+        }
+        clistSortRadix(&list, 0, sizeof(uint32_t), CLIST_SORT_KEY_UINT);
+        for (uint32_t i = 0; i < batch; ++i)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            items[i].key = seed;
+            items[i].value = i;
+        }
+        double t0 = benchSeconds();
+        if (pass == 0)
+            benchSortedInsertLoop(&list, items, batch);
+        else
+            clistSortedInsertRange(&list, items, batch, benchSortCompareContext, NULL);
+        double insert = benchSeconds() - t0;
+        t0 = benchSeconds();
+        if (pass == 0)
+            benchSortedRemoveLoop(&list, items, batch);
+        else
+            clistSortedRemoveRange(&list, items, batch, benchSortCompareContext, NULL);
+        double remove = benchSeconds() - t0;
+        uint32_t bSorted = list.Count == count;
+        for (uint32_t i = 1; i < list.Count; ++i)
+            bSorted &= benchSortCompare(clistItemAt(&list, i - 1), clistItemAt(&list, i)) <= 0;
+        printf("sorted 1M    %-7s insert 10k %8.2f ms  remove 10k %8.2f ms  %s\n", pass == 0 ? "loop" : "batch", insert * 1e3, remove * 1e3,
+            bSorted ? "ok" : "NOT SORTED");
+        clistFree(&list);
+    }
+    free(items);
+}
+
+int main(void)
+{
+    benchSortedList();
+    benchSort();
+    benchConcurrentAppend();
+    benchInline();
+    benchCapacityProfile();
+    benchGrowth();
+    const uint32_t strides[] = { 1, 2, 4, 8, 16, 32, 12 };
+    for (uint32_t i = 0; i < sizeof(strides) / sizeof(strides[0]); ++i)
+    {
+        benchFind(strides[i]);
+    }
+    return 0;
+}
@@ -0,0 +1,289 @@
+
+#include "CCollections/CEntityComponentSystem.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <assert.h>
+
+typedef struct Position { float x, y, z, w; } Position;
+typedef struct Velocity { float x, y, z, w; } Velocity;
+typedef struct Health { int current, max; } Health;
+typedef struct Stunned { float seconds; } Stunned;
+
+enum EComponentIds
+{
+    ePositionId,
+    eVelocityId,
+    eHealthId,
+    eStunnedId
+};
+
+enum EQueryIds
+{
+    ePositionVelocityQueryId,
+    eHealthQueryId,
+    ePositionQueryId
+};
+
+static double benchSeconds(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// queries of EQueryIds
+static void benchCreateQueries(EcsInstance* instance)
+{
+    ecsCreateQuery(instance, 2, ePositionId, eVelocityId);
+    ecsCreateQuery(instance, 1, eHealthId);
+    ecsCreateQuery(instance, 1, ePositionId);
+}
+
+// world of 3 archetypes, entities spread evenly
+static void benchCreateWorld(EcsInstance* instance, uint entityCount)
+{
+    EcsComponentDesc moving[3] = { { ePositionId, sizeof(Position), sizeof(float) }, { eVelocityId, sizeof(Velocity), sizeof(float) }, { eHealthId, sizeof(Health), 0 } };
+    EcsComponentDesc still[2] = { { ePositionId, sizeof(Position), sizeof(float) }, { eHealthId, sizeof(Health), 0 } };
+    EcsComponentDesc props[1] = { { ePositionId, sizeof(Position), sizeof(float) } };
+    uint archIds[3];
+    archIds[0] = ecsCreateArchetype(instance, 3, moving, entityCount / 3);
+    archIds[1] = ecsCreateArchetype(instance, 2, still, entityCount / 3);
+    archIds[2] = ecsCreateArchetype(instance, 1, props, entityCount / 3);
+    benchCreateQueries(instance);
+
+    ecsReserveEntityCapacity(instance, entityCount);
+    for (uint i = 0; i < entityCount; ++i)
+    {
+        uint entityId = ecsCreateEntity(instance, archIds[i % 3]);
+        Position position = { (float)i, 0.0f, 0.0f, 1.0f };
+        ecsStoreComponentToEntityId(instance, entityId, ePositionId, &position);
+    }
+}
+
+// one pass over all positions, touches every page of the column
+static float benchIteratePositions(EcsInstance* instance)
+{
+    float sum = 0.0f;
+    void* components[1];
+    EcsQueryIterator itr = ecsCreateQueryIterator(instance, ePositionQueryId);
+    while (ecsIterateQuery(&itr, components))
+    {
+        sum += *(float*)components[0];
+    }
+    return sum;
+}
+
+// ecsLoadInstance against rebuilding the world with ecsCreateEntity
+// loaded columns are mapped in place, the first pass over them pays for reading the pages
+static void benchSaveLoad(void)
+{
+    const char* path = "EcsBenchmark.ecs";
+    printf("%12s %12s %12s %12s %18s %18s\n", "entities", "create ms", "save ms", "load ms", "created pass ms", "loaded pass ms");
+    for (uint entityCount = 1000; entityCount <= 4000000; entityCount *= 4)
+    {
+        EcsInstance created = ecsCreateInstance();
+        double t0 = benchSeconds();
+        benchCreateWorld(&created, entityCount);
+        double t1 = benchSeconds();
+        uint bSaved = ecsSaveInstance(&created, path);
+        double t2 = benchSeconds();
+        EcsInstance loaded = ecsCreateInstance();
+        uint bLoaded = ecsLoadInstance(&loaded, path);
+        double t3 = benchSeconds();
+        float createdSum = benchIteratePositions(&created);
+        double t4 = benchSeconds();
+        float loadedSum = benchIteratePositions(&loaded);
+        double t5 = benchSeconds();
+        assert(bSaved && bLoaded && createdSum == loadedSum);
+        (void)bSaved; (void)bLoaded; (void)createdSum; (void)loadedSum;
+
+        printf("%12u %12.2f %12.2f %12.2f %18.2f %18.2f\n", entityCount, (t1 - t0) * 1e3, (t2 - t1) * 1e3, (t3 - t2) * 1e3, (t4 - t3) * 1e3, (t5 - t4) * 1e3);
+    }
+    remove(path);
+}
+
+// ecsEncodeDelta and ecsApplyDelta throughput with a fraction of positions written each frame
+static void benchDelta(void)
+{
+    const uint entityCount = 1000000;
+    const uint frameCount = 16;
+    printf("%12s %12s %14s %14s %14s\n", "changed %", "delta KB", "encode MB/s", "apply MB/s", "column MB");
+    for (uint changedPercent = 1; changedPercent <= 100; changedPercent *= 10)
+    {
+        EcsInstance source = ecsCreateInstance();
+        EcsInstance replica = ecsCreateInstance();
+        ecsCreateSparseComponent(&source, eStunnedId, sizeof(Stunned));
+        ecsCreateSparseComponent(&replica, eStunnedId, sizeof(Stunned));
+        ecsEnableDelta(&source);
+        ecsEnableDelta(&replica);
+        benchCreateWorld(&source, entityCount);
+        // sparse add through the generic add replicates as a sparse event
+        ecsAddComponentToEntity(&source, 0, eStunnedId, sizeof(Stunned));
+        size_t size;
+        const void* delta = ecsEncodeDelta(&source, &size);
+        uint bApplied = ecsApplyDelta(&replica, delta, size);
+        assert(bApplied && ecsGetSparseComponent(&replica, 0, eStunnedId));
+        // queries need the archetypes, which the first delta creates
+        benchCreateQueries(&replica);
+
+        // bytes of changed chunks scanned by the encoder, not the size of the delta
+        const uint changedCount = entityCount / 100 * changedPercent;
+        const uint step = entityCount / changedCount;
+        double encodeSeconds = 0.0, applySeconds = 0.0;
+        size_t deltaBytes = 0;
+        for (uint frame = 0; frame < frameCount; ++frame)
+        {
+            for (uint i = 0; i < changedCount; ++i)
+            {
+                uint entityId = i * step + frame % step;
+                Position position = { (float)frame, (float)i, 0.0f, 1.0f };
+                ecsStoreComponentToEntityId(&source, entityId, ePositionId, &position);
+            }
+            double t0 = benchSeconds();
+            delta = ecsEncodeDelta(&source, &size);
+            double t1 = benchSeconds();
+            bApplied &= ecsApplyDelta(&replica, delta, size);
+            double t2 = benchSeconds();
+            encodeSeconds += t1 - t0;
+            applySeconds += t2 - t1;
+            deltaBytes += size;
+        }
+        assert(bApplied && benchIteratePositions(&source) == benchIteratePositions(&replica));
+        (void)bApplied;
+
+        const double columnMB = (double)entityCount * sizeof(Position) / (1024.0 * 1024.0);
+        printf("%12u %12.1f %14.1f %14.1f %14.1f\n", changedPercent, deltaBytes / 1024.0 / frameCount, columnMB * frameCount / encodeSeconds, columnMB * frameCount / applySeconds, columnMB);
+    }
+}
+
+// ecsExportQuery against pulling components out entity by entity
+static void benchExport(void)
+{
+    const uint entityCount = 5000000;
+    EcsInstance instance = ecsCreateInstance();
+    benchCreateWorld(&instance, entityCount);
+
+    const uint rowCount = ecsGetQueryEntityCount(&instance, ePositionQueryId);
+    Position* positions = (Position*)malloc(sizeof(Position) * rowCount);
+    uint* entityIds = (uint*)malloc(sizeof(uint) * rowCount);
+    memset(positions, 0, sizeof(Position) * rowCount);
+    memset(entityIds, 0, sizeof(uint) * rowCount);
+
+    // second pass of each, the first pays for faulting in pages
+    void* columns[1] = { positions };
+    uint exported = 0;
+    double exportSeconds = 0.0, perEntitySeconds = 0.0;
+    for (uint pass = 0; pass < 2; ++pass)
+    {
+        double t0 = benchSeconds();
+        exported = ecsExportQuery(&instance, ePositionQueryId, columns, entityIds, rowCount);
+        double t1 = benchSeconds();
+        for (uint i = 0; i < rowCount; ++i)
+        {
+            ecsLoadComponentFromEntityId(&instance, i, ePositionId, &positions[i]);
+        }
+        double t2 = benchSeconds();
+        exportSeconds = t1 - t0;
+        perEntitySeconds = t2 - t1;
+    }
+    assert(exported == rowCount);
+    (void)exported;
+
+    const double exportedMB = (double)rowCount * (sizeof(Position) + sizeof(uint)) / (1024.0 * 1024.0);
+    printf("%12s %12s %14s %18s\n", "rows", "export ms", "export MB/s", "per entity ms");
+    printf("%12u %12.2f %14.1f %18.2f\n", rowCount, exportSeconds * 1e3, exportedMB / exportSeconds, perEntitySeconds * 1e3);
+    free(positions);
+    free(entityIds);
+}
+
+static void benchMoveCallback(void** components)
+{
+    Position* position = (Position*)components[0];
+    const Velocity* velocity = (const Velocity*)components[1];
+    position->x += velocity->x;
+    position->y += velocity->y;
+}
+
+// per-entity query iteration over AoS columns, best of 10 passes
+static void benchIterate(void)
+{
+    const uint entityCount = 2000000;
+    EcsInstance instance = ecsCreateInstance();
+    EcsComponentDesc moving[2] = { { ePositionId, sizeof(Position), 0 }, { eVelocityId, sizeof(Velocity), 0 } };
+    EcsComponentDesc tagged[3] = { { ePositionId, sizeof(Position), 0 }, { eVelocityId, sizeof(Velocity), 0 }, { eHealthId, sizeof(Health), 0 } };
+    uint archIds[2];
+    archIds[0] = ecsCreateArchetype(&instance, 2, moving, entityCount / 2);
+    archIds[1] = ecsCreateArchetype(&instance, 3, tagged, entityCount / 2);
+    uint queryId = ecsCreateQuery(&instance, 2, ePositionId, eVelocityId);
+    ecsReserveEntityCapacity(&instance, entityCount);
+    for (uint i = 0; i < entityCount; ++i)
+    {
+        uint entityId = ecsCreateEntity(&instance, archIds[i & 1]);
+        Velocity velocity = { 1.0f, 1.0f, 0.0f, 0.0f };
+        ecsStoreComponentToEntityId(&instance, entityId, eVelocityId, &velocity);
+    }
+
+    double callbackSeconds = 1e9, iteratorSeconds = 1e9;
+    void* components[2];
+    for (uint pass = 0; pass < 10; ++pass)
+    {
+        double t0 = benchSeconds();
+        ecsIterateQueryCallback(&instance, queryId, benchMoveCallback);
+        double t1 = benchSeconds();
+        EcsQueryIterator itr = ecsCreateQueryIterator(&instance, queryId);
+        while (ecsIterateQuery(&itr, components))
+        {
+            benchMoveCallback(components);
+        }
+        double t2 = benchSeconds();
+        callbackSeconds = t1 - t0 < callbackSeconds ? t1 - t0 : callbackSeconds;
+        iteratorSeconds = t2 - t1 < iteratorSeconds ? t2 - t1 : iteratorSeconds;
+    }
+    printf("%12s %12s %12s\n", "entities", "callback ms", "iterator ms");
+    printf("%12u %12.2f %12.2f\n", entityCount, callbackSeconds * 1e3, iteratorSeconds * 1e3);
+}
+
+// worst frame of spawning into one archetype, growing at once against incremental growth
+static void benchGrowth(void)
+{
+    const uint frameCount = 200;
+    const uint spawnCount = 20000;
+    printf("%12s %12s %14s %14s\n", "step KB", "entities", "worst frame ms", "total ms");
+    for (size_t stepBytes = 0; stepBytes <= 16 * 1024 * 1024; stepBytes = stepBytes ? stepBytes * 4 : 1024 * 1024)
+    {
+        EcsInstance instance = ecsCreateInstance();
+        EcsComponentDesc moving[3] = { { ePositionId, sizeof(Position), 0 }, { eVelocityId, sizeof(Velocity), 0 }, { eHealthId, sizeof(Health), 0 } };
+        uint archId = ecsCreateArchetype(&instance, 3, moving, 0);
+        ecsReserveEntityCapacity(&instance, frameCount * spawnCount);
+        ecsEnableIncrementalGrowth(&instance, stepBytes);
+
+        double worstSeconds = 0.0, totalSeconds = 0.0;
+        for (uint frame = 0; frame < frameCount; ++frame)
+        {
+            double t0 = benchSeconds();
+            for (uint i = 0; i < spawnCount; ++i)
+            {
+                uint entityId = ecsCreateEntity(&instance, archId);
+                Position position = { (float)i, (float)frame, 0.0f, 1.0f };
+                ecsStoreComponentToEntityId(&instance, entityId, ePositionId, &position);
+            }
+            ecsStepIncrementalGrowth(&instance);
+            double t1 = benchSeconds();
+            worstSeconds = t1 - t0 > worstSeconds ? t1 - t0 : worstSeconds;
+            totalSeconds += t1 - t0;
+        }
+        printf("%12u %12u %14.2f %14.2f\n", (uint)(stepBytes / 1024), frameCount * spawnCount, worstSeconds * 1e3, totalSeconds * 1e3);
+    }
+}
+
+int main(void)
+{
+    benchSaveLoad();
+    benchDelta();
+    benchExport();
+    benchIterate();
+    benchGrowth();
+    return 0;
+}
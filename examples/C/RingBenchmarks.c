@@ -0,0 +1,192 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L // sched_yield
+#endif
+
+#include "CCollections/CRingBuffer.h"
+#include <stdio.h>
+#include <time.h>
+
+#if defined(_WIN32)
+    #ifndef WIN32_LEAN_AND_MEAN
+    #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+    typedef HANDLE BenchThread;
+    #define benchYield() SwitchToThread()
+#else
+    #include <pthread.h>
+    #include <sched.h>
+    typedef pthread_t BenchThread;
+    #define benchYield() sched_yield()
+#endif
+
+#define BENCH_MAX_THREADS 8
+#define BENCH_CAPACITY 4096
+#define BENCH_MAX_BATCH 64
+
+static double benchSeconds(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+typedef struct BenchQueue
+{
+    CSpscRing Spsc;
+    CMpmcRing Mpmc;
+    uint32_t bMpmc;
+    uint32_t batch;
+    // items per producer, values 1..itemsPerProducer so consumers can sum them
+    uint32_t itemsPerProducer;
+    uint32_t consumerCount;
+    volatile uint32_t consumed;
+} BenchQueue;
+
+typedef struct BenchWorker
+{
+    BenchQueue* queue;
+    uint64_t sum;
+} BenchWorker;
+
+static CSize benchPush(BenchQueue* queue, uint64_t* items, CSize count)
+{
+    return queue->bMpmc ? cmpmcringPushRange(&queue->Mpmc, items, count) : cspscringPushRange(&queue->Spsc, items, count);
+}
+
+static CSize benchPop(BenchQueue* queue, uint64_t* items, CSize count)
+{
+    return queue->bMpmc ? cmpmcringPopRange(&queue->Mpmc, items, count) : cspscringPopRange(&queue->Spsc, items, count);
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI benchProducer(LPVOID arg)
+#else
+static void* benchProducer(void* arg)
+#endif
+{
+    BenchWorker* worker = (BenchWorker*)arg;
+    BenchQueue* queue = worker->queue;
+    uint64_t items[BENCH_MAX_BATCH];
+    uint64_t next = 1;
+    while (next <= queue->itemsPerProducer)
+    {
+        CSize count = queue->itemsPerProducer - next + 1;
+        count = count < queue->batch ? count : queue->batch;
+        for (CSize i = 0; i < count; ++i)
+            items[i] = next + i;
+        CSize pushed = 0;
+        while (pushed < count)
+        {
+            CSize n = benchPush(queue, items + pushed, count - pushed);
+            if (n == 0)
+                benchYield();
+            pushed += n;
+        }
+        next += count;
+    }
+    return 0;
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI benchConsumer(LPVOID arg)
+#else
+static void* benchConsumer(void* arg)
+#endif
+{
+    BenchWorker* worker = (BenchWorker*)arg;
+    BenchQueue* queue = worker->queue;
+    const uint32_t total = queue->itemsPerProducer * queue->consumerCount;
+    uint64_t items[BENCH_MAX_BATCH];
+    while (catomicLoad32(&queue->consumed) < total)
+    {
+        CSize n = benchPop(queue, items, queue->batch);
+        if (n == 0)
+        {
+            benchYield();
+            continue;
+        }
+        for (CSize i = 0; i < n; ++i)
+            worker->sum += items[i];
+        catomicFetchAdd32(&queue->consumed, (uint32_t)n);
+    }
+    return 0;
+}
+
+static void benchStart(BenchThread* thread, BenchWorker* worker, uint32_t bProducer)
+{
+#if defined(_WIN32)
+    *thread = CreateThread(NULL, 0, bProducer ? benchProducer : benchConsumer, worker, 0, NULL);
+#else
+    pthread_create(thread, NULL, bProducer ? benchProducer : benchConsumer, worker);
+#endif
+}
+
+static void benchJoin(BenchThread thread)
+{
+#if defined(_WIN32)
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+#else
+    pthread_join(thread, NULL);
+#endif
+}
+
+// threadCount producers and threadCount consumers move itemsPerProducer 8 byte items each
+static void benchRing(uint32_t bMpmc, uint32_t threadCount, uint32_t batch, uint32_t itemsPerProducer)
+{
+    BenchQueue queue;
+    memset(&queue, 0, sizeof(queue));
+    queue.bMpmc = bMpmc;
+    queue.batch = batch;
+    queue.itemsPerProducer = itemsPerProducer;
+    queue.consumerCount = threadCount;
+    if (bMpmc)
+        cmpmcringAlloc(&queue.Mpmc, sizeof(uint64_t), BENCH_CAPACITY);
+    else
+        cspscringAlloc(&queue.Spsc, sizeof(uint64_t), BENCH_CAPACITY);
+
+    BenchThread threads[BENCH_MAX_THREADS * 2];
+    BenchWorker workers[BENCH_MAX_THREADS * 2];
+    memset(workers, 0, sizeof(workers));
+    double t0 = benchSeconds();
+    for (uint32_t i = 0; i < threadCount * 2; ++i)
+    {
+        workers[i].queue = &queue;
+        benchStart(&threads[i], &workers[i], i < threadCount);
+    }
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < threadCount * 2; ++i)
+    {
+        benchJoin(threads[i]);
+        sum += workers[i].sum;
+    }
+    double seconds = benchSeconds() - t0;
+
+    const uint64_t expected = (uint64_t)itemsPerProducer * (itemsPerProducer + 1) / 2 * threadCount;
+    const double items = (double)itemsPerProducer * threadCount;
+    printf("%s  %u:%u  batch %2u  %8.2f Mitems/s  %s\n", bMpmc ? "mpmc" : "spsc", threadCount, threadCount, batch,
+        items / seconds * 1e-6, sum == expected ? "ok" : "LOST ITEMS");
+    if (bMpmc)
+        cmpmcringFree(&queue.Mpmc);
+    else
+        cspscringFree(&queue.Spsc);
+}
+
+int main(void)
+{
+    const uint32_t items = 1u << 22;
+    const uint32_t batches[] = { 1, 16, BENCH_MAX_BATCH };
+    for (uint32_t b = 0; b < sizeof(batches) / sizeof(batches[0]); ++b)
+    {
+        benchRing(0, 1, batches[b], items);
+    }
+    for (uint32_t threads = 1; threads <= BENCH_MAX_THREADS; threads *= 2)
+    {
+        for (uint32_t b = 0; b < sizeof(batches) / sizeof(batches[0]); ++b)
+        {
+            benchRing(1, threads, batches[b], items / threads);
+        }
+    }
+    return 0;
+}
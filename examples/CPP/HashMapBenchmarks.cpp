@@ -0,0 +1,184 @@
+#include "CCollections/CHashMap.h"
+#include <unordered_map>
+#include <vector>
+#include <stdio.h>
+#include <time.h>
+
+static double benchSeconds()
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint64_t benchRandom(uint64_t* state)
+{
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+struct BenchResult
+{
+    double insert;
+    double insertRange;
+    double findHit;
+    double findMiss;
+    double churn;
+    uint64_t sum;
+};
+
+// count random 8 byte keys to 8 byte values - hits are looked up in a different order than inserted, misses are all absent
+static BenchResult benchCHashMap(const std::vector<uint64_t>& keys, const std::vector<uint64_t>& hits, const std::vector<uint64_t>& misses, uint32_t bRange)
+{
+    const CSize count = (CSize)keys.size();
+    BenchResult result = {};
+    CHashMap map;
+    chashmapAlloc(&map, sizeof(uint64_t), sizeof(uint64_t), 0);
+
+    double t0 = benchSeconds();
+    for (CSize i = 0; i < count; ++i)
+        chashmapInsert(&map, &keys[i], &keys[i]);
+    result.insert = benchSeconds() - t0;
+
+    chashmapFree(&map);
+    chashmapAlloc(&map, sizeof(uint64_t), sizeof(uint64_t), 0);
+    t0 = benchSeconds();
+    if (bRange)
+    {
+        chashmapInsertRange(&map, keys.data(), keys.data(), count);
+    }
+    else
+    {
+        chashmapReserve(&map, count);
+        for (CSize i = 0; i < count; ++i)
+            chashmapInsert(&map, &keys[i], &keys[i]);
+    }
+    result.insertRange = benchSeconds() - t0;
+
+    std::vector<void*> values(count);
+    t0 = benchSeconds();
+    if (bRange)
+    {
+        chashmapFindRange(&map, hits.data(), count, values.data());
+        for (CSize i = 0; i < count; ++i)
+            result.sum += *(uint64_t*)values[i];
+    }
+    else
+    {
+        for (CSize i = 0; i < count; ++i)
+            result.sum += *(uint64_t*)chashmapFind(&map, &hits[i]);
+    }
+    result.findHit = benchSeconds() - t0;
+
+    t0 = benchSeconds();
+    if (bRange)
+    {
+        result.sum += chashmapFindRange(&map, misses.data(), count, values.data());
+    }
+    else
+    {
+        for (CSize i = 0; i < count; ++i)
+            result.sum += chashmapFind(&map, &misses[i]) != NULL;
+    }
+    result.findMiss = benchSeconds() - t0;
+
+    // remove one key and add another at a steady count
+    t0 = benchSeconds();
+    for (CSize i = 0; i < count; ++i)
+    {
+        chashmapRemove(&map, &keys[i]);
+        chashmapInsert(&map, &misses[i], &misses[i]);
+    }
+    result.churn = benchSeconds() - t0;
+    result.sum += map.Base.Count;
+
+    chashmapFree(&map);
+    return result;
+}
+
+static BenchResult benchUnorderedMap(const std::vector<uint64_t>& keys, const std::vector<uint64_t>& hits, const std::vector<uint64_t>& misses)
+{
+    const size_t count = keys.size();
+    BenchResult result = {};
+    std::unordered_map<uint64_t, uint64_t> map;
+
+    double t0 = benchSeconds();
+    for (size_t i = 0; i < count; ++i)
+        map[keys[i]] = keys[i];
+    result.insert = benchSeconds() - t0;
+
+    std::unordered_map<uint64_t, uint64_t>().swap(map);
+    t0 = benchSeconds();
+    map.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+        map.emplace(keys[i], keys[i]);
+    result.insertRange = benchSeconds() - t0;
+
+    t0 = benchSeconds();
+    for (size_t i = 0; i < count; ++i)
+        result.sum += map.find(hits[i])->second;
+    result.findHit = benchSeconds() - t0;
+
+    t0 = benchSeconds();
+    for (size_t i = 0; i < count; ++i)
+        result.sum += map.find(misses[i]) != map.end();
+    result.findMiss = benchSeconds() - t0;
+
+    t0 = benchSeconds();
+    for (size_t i = 0; i < count; ++i)
+    {
+        map.erase(keys[i]);
+        map.emplace(misses[i], misses[i]);
+    }
+    result.churn = benchSeconds() - t0;
+    result.sum += map.size();
+    return result;
+}
+
+static void benchPrint(const char* name, size_t count, const BenchResult& result, uint64_t expected)
+{
+    const double ns = 1e9 / (double)count;
+    printf("%-9s %8zu  insert %6.1f  reserved %6.1f  hit %6.1f  miss %6.1f  churn %6.1f ns  %s\n", name, count,
+        result.insert * ns, result.insertRange * ns, result.findHit * ns, result.findMiss * ns, result.churn * ns,
+        result.sum == expected ? "ok" : "WRONG SUM");
+}
+
+// CHashMap single and range calls against std::unordered_map, ns per key
+static void benchHashMaps(size_t count)
+{
+    uint64_t state = 0x9E3779B97F4A7C15ull ^ count;
+    std::vector<uint64_t> keys(count);
+    std::vector<uint64_t> misses(count);
+    // hit keys are odd and miss keys even, so no miss is ever present
+    for (size_t i = 0; i < count; ++i)
+    {
+        keys[i] = benchRandom(&state) | 1;
+        misses[i] = benchRandom(&state) & ~1ull;
+    }
+    std::vector<uint64_t> hits(keys);
+    for (size_t i = count; i > 1; --i)
+    {
+        const size_t j = (size_t)(benchRandom(&state) % i);
+        const uint64_t tmp = hits[i - 1];
+        hits[i - 1] = hits[j];
+        hits[j] = tmp;
+    }
+
+    const BenchResult reference = benchUnorderedMap(keys, hits, misses);
+    benchPrint("std", count, reference, reference.sum);
+    benchPrint("chashmap", count, benchCHashMap(keys, hits, misses, 0), reference.sum);
+    benchPrint("range", count, benchCHashMap(keys, hits, misses, 1), reference.sum);
+}
+
+int main()
+{
+    const size_t counts[] = { 1000, 100000, 4000000 };
+    for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); ++i)
+    {
+        benchHashMaps(counts[i]);
+    }
+    return 0;
+}
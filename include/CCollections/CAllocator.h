@@ -0,0 +1,107 @@
+// MIT License - CCollections
+// Copyright(c) 2020 Dante Falcone (dantefalcone@gmail.com)
+#pragma once
+#include "CTypes.h"
+#include "CVirtualMemory.h"
+#include <string.h>
+#include <malloc.h>
+#include <assert.h>
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <mm_malloc.h> // _mm_malloc outside of MSVC malloc.h
+#endif
+
+/*  CAllocator
+
+    Allocation hook for containers - set the default with callocatorSetDefault or pass one to the *Ex alloc functions
+    A container keeps the allocator it was allocated with, NULL is the built-in aligned heap
+    Alignment follows size: cache line for small containers, page for large and huge page for very large
+*/
+
+#if defined(_MSC_VER)
+    #define CCOLLECTIONS_SELECTANY __declspec(selectany)
+#else
+    #define CCOLLECTIONS_SELECTANY __attribute__((weak))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+// default allocator of new containers, one instance shared by all translation units
+CCOLLECTIONS_SELECTANY const CAllocator* ccollectionsDefaultAllocator = NULL;
+
+static inline const CAllocator* callocatorDefault(void);
+// NULL restores the built-in aligned heap, containers already allocated keep their allocator
+static inline void callocatorSetDefault(const CAllocator* allocator);
+static inline size_t callocatorAlignment(size_t size);
+static inline void* callocatorAlloc(const CAllocator* allocator, size_t size);
+// copies usedSize bytes if the allocator cannot realloc
+static inline void* callocatorRealloc(const CAllocator* allocator, void* ptr, size_t oldSize, size_t newSize, size_t usedSize);
+static inline void callocatorFree(const CAllocator* allocator, void* ptr, size_t size);
+
+
+
+const CAllocator* callocatorDefault(void)
+{
+    return ccollectionsDefaultAllocator;
+}
+
+void callocatorSetDefault(const CAllocator* allocator)
+{
+    ccollectionsDefaultAllocator = allocator;
+}
+
+size_t callocatorAlignment(size_t size)
+{
+    const size_t hugeBytes = CCOLLECTIONS_HUGE_PAGE_BYTES;
+    if (hugeBytes && size >= hugeBytes)
+    {
+        return CCOLLECTIONS_HUGE_PAGE_ALIGNMENT;
+    }
+    return size >= CCOLLECTIONS_ALIGNMENT ? CCOLLECTIONS_ALIGNMENT : CCOLLECTIONS_CACHE_LINE_ALIGNMENT;
+}
+
+void* callocatorAlloc(const CAllocator* allocator, size_t size)
+{
+    const size_t alignment = callocatorAlignment(size);
+    if (allocator)
+    {
+        return allocator->Alloc(allocator->Context, size, alignment);
+    }
+    void* ptr = _mm_malloc(size, alignment);
+    if (ptr && alignment == CCOLLECTIONS_HUGE_PAGE_ALIGNMENT)
+    {
+        cvmAdviseHugePages(ptr, size);
+    }
+    return ptr;
+}
+
+void* callocatorRealloc(const CAllocator* allocator, void* ptr, size_t oldSize, size_t newSize, size_t usedSize)
+{
+    if (allocator && allocator->Realloc)
+    {
+        return allocator->Realloc(allocator->Context, ptr, oldSize, newSize, callocatorAlignment(newSize));
+    }
+    void* newPtr = callocatorAlloc(allocator, newSize);
+    if (newPtr == NULL)
+    {
+        return NULL;
+    }
+    memcpy(newPtr, ptr, usedSize < newSize ? usedSize : newSize);
+    callocatorFree(allocator, ptr, oldSize);
+    return newPtr;
+}
+
+void callocatorFree(const CAllocator* allocator, void* ptr, size_t size)
+{
+    if (allocator)
+    {
+        allocator->Free(allocator->Context, ptr, size);
+        return;
+    }
+    _mm_free(ptr);
+}
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
@@ -16,11 +16,11 @@ extern "C" {
 
 
 // size of arrays capacity (including array headers)
-static inline uint32_t carraylistSizeOfCapacity(CArrayList* list);
+static inline size_t carraylistSizeOfCapacity(CArrayList* list);
 // size of arrays count (including array headers)
-static inline uint32_t carraylistSizeOfArrays(CArrayList* list);
+static inline size_t carraylistSizeOfArrays(CArrayList* list);
 // size of arrays raw data (without array headers)
-static inline uint32_t carraylistSizeOfData(CArrayList* list);
+static inline size_t carraylistSizeOfData(CArrayList* list);
 
 static inline void* carraylistBegin(CArrayList* list);
 static inline void* carraylistEnd(CArrayList* list);
@@ -31,63 +31,68 @@ static inline CArrayHeader* carraylistNext(CArrayList* list, CArrayHeader* itr);
 // ! get the raw data from array header
 static inline void* carraylistData(CArrayHeader* itr);
 // ! get size of item type within arrays
-static inline uint32_t carraylistItemStride(CArrayList* list);
-
-static inline CArrayList carraylistCreate(uint32_t arrayItemStride, uint32_t arrayItemCapacity, uint32_t listCapacity);
-static inline void carraylistAlloc(CArrayList* list, uint32_t arrayItemStride, uint32_t arrayItemCapacity, uint32_t listCapacity);
-static inline void carraylistRealloc(CArrayList* list, uint32_t newListCapacity);
+static inline CSize carraylistItemStride(CArrayList* list);
+
+static inline CArrayList carraylistCreate(CSize arrayItemStride, CSize arrayItemCapacity, CSize listCapacity);
+static inline void carraylistAlloc(CArrayList* list, CSize arrayItemStride, CSize arrayItemCapacity, CSize listCapacity);
+// allocate from allocator instead of the default, NULL for the built-in aligned heap
+static inline void carraylistAllocEx(CArrayList* list, CSize arrayItemStride, CSize arrayItemCapacity, CSize listCapacity, const CAllocator* allocator);
+static inline void carraylistRealloc(CArrayList* list, CSize newListCapacity);
+// realloc only if list capacity (n-arrays) is less than minListCapacity
+static inline void carraylistReserve(CArrayList* list, CSize minListCapacity);
 static inline void carraylistFree(CArrayList* list);
 // zero all raw data
 static inline void carraylistZeroMem(CArrayList* list);
 // grow capacity
-static inline void carraylistGrow(CArrayList* list, uint32_t numNewItems);
+static inline void carraylistGrow(CArrayList* list, CSize numNewItems);
 // grow capacity and zero new raw data
-static inline void carraylistGrowZero(CArrayList* list, uint32_t numNewItems);
+static inline void carraylistGrowZero(CArrayList* list, CSize numNewItems);
 // shrink capacity
-static inline void carraylistShrink(CArrayList* list, uint32_t numLessItems);
+static inline void carraylistShrink(CArrayList* list, CSize numLessItems);
 
 // !
-static inline uint32_t carraylistAddArray(CArrayList* list);
+static inline CSize carraylistAddArray(CArrayList* list);
 // !
-static inline uint32_t carraylistAddArrayRange(CArrayList* list, uint32_t arraysCount);
+static inline CSize carraylistAddArrayRange(CArrayList* list, CSize arraysCount);
 // ! get the array header at array index
-static inline CArrayHeader* carraylistArrayAt(CArrayList* list, uint32_t index);
+static inline CArrayHeader* carraylistArrayAt(CArrayList* list, CSize index);
 
 // ! add item to array at index
-static inline void carraylistAddItem(CArrayList* list, uint32_t arrayIndex, void* item);
+static inline void carraylistAddItem(CArrayList* list, CSize arrayIndex, void* item);
 // ! add items to array at index
-static inline void carraylistAddItemRange(CArrayList* list, uint32_t arrayIndex, void* items, uint32_t itemsCount);
+static inline void carraylistAddItemRange(CArrayList* list, CSize arrayIndex, void* items, CSize itemsCount);
 // get the raw data at an array index
-static inline void* carraylistItemAt(CArrayList* list, uint32_t arrayIndex, uint32_t itemIndex);
+static inline void* carraylistItemAt(CArrayList* list, CSize arrayIndex, CSize itemIndex);
 
 
-static inline void carraylistInsertItemAt(CArrayList* list, uint32_t arrayIndex, void* item, uint32_t insertItemIndex);
-static inline void carraylistInsertItemRangeAt(CArrayList* list, uint32_t arrayIndex, void* items, uint32_t itemsCount, uint32_t insertItemsIndex);
-static inline void carraylistZeroItemAt(CArrayList* list, uint32_t arrayIndex, uint32_t itemIndex);
-static inline void carraylistZeroItemRangeAt(CArrayList* list, uint32_t arrayIndex, uint32_t itemsCount, uint32_t itemsIndex);
-static inline uint32_t carraylistFindItemIndex(CArrayList* list, uint32_t arrayIndex, void* item);
-static inline uint32_t carraylistFindItemZeroIndex(CArrayList* list, uint32_t arrayIndex);
+static inline void carraylistInsertItemAt(CArrayList* list, CSize arrayIndex, void* item, CSize insertItemIndex);
+static inline void carraylistInsertItemRangeAt(CArrayList* list, CSize arrayIndex, void* items, CSize itemsCount, CSize insertItemsIndex);
+static inline void carraylistZeroItemAt(CArrayList* list, CSize arrayIndex, CSize itemIndex);
+static inline void carraylistZeroItemRangeAt(CArrayList* list, CSize arrayIndex, CSize itemsCount, CSize itemsIndex);
+// both return CCOLLECTION_NOT_FOUND if none
+static inline CSize carraylistFindItemIndex(CArrayList* list, CSize arrayIndex, void* item);
+static inline CSize carraylistFindItemZeroIndex(CArrayList* list, CSize arrayIndex);
 
-static inline void carraylistRemoveArrayAt(CArrayList* list, uint32_t arrayIndex);
-static inline void carraylistRemoveItemAt(CArrayList* list, uint32_t arrayIndex, uint32_t itemIndex);
-static inline void carraylistRemoveItemRangeAt(CArrayList* list, uint32_t arrayIndex, uint32_t itemsIndex, uint32_t itemsCount);
-static inline void carraylistRemoveItem(CArrayList* list, uint32_t arrayIndex, void* item);
+static inline void carraylistRemoveArrayAt(CArrayList* list, CSize arrayIndex);
+static inline void carraylistRemoveItemAt(CArrayList* list, CSize arrayIndex, CSize itemIndex);
+static inline void carraylistRemoveItemRangeAt(CArrayList* list, CSize arrayIndex, CSize itemsIndex, CSize itemsCount);
+static inline void carraylistRemoveItem(CArrayList* list, CSize arrayIndex, void* item);
 
 
-inline uint32_t carraylistSizeOfCapacity(CArrayList* list)
+inline size_t carraylistSizeOfCapacity(CArrayList* list)
 {
     return clistSizeOfCapacity(list);
 }
 
-inline uint32_t carraylistSizeOfArrays(CArrayList* list)
+inline size_t carraylistSizeOfArrays(CArrayList* list)
 {
     return clistSizeOfItems(list);
 }
 
-inline uint32_t carraylistSizeOfData(CArrayList* list)
+inline size_t carraylistSizeOfData(CArrayList* list)
 {
-    uint32_t itemStride = ((CArrayHeader*)list->Data[0])->Stride;
-    uint32_t size = itemStride * list->Count;
+    CSize itemStride = ((CArrayHeader*)list->Data[0])->Stride;
+    size_t size = (size_t)itemStride * list->Count;
     return size;
 }
 
@@ -123,24 +128,29 @@ inline void* carraylistData(CArrayHeader* itr)
     return (void*)data;
 }
 
-inline uint32_t carraylistItemStride(CArrayList* list)
+inline CSize carraylistItemStride(CArrayList* list)
 {
     CArrayHeader* header = (CArrayHeader*)list->Data;
     return header->Stride;
 }
 
-inline CArrayList carraylistCreate(uint32_t arrayItemStride, uint32_t arrayItemCapacity, uint32_t listCapacity)
+inline CArrayList carraylistCreate(CSize arrayItemStride, CSize arrayItemCapacity, CSize listCapacity)
 {
     CArrayList list;
     carraylistAlloc(&list, arrayItemStride, arrayItemCapacity, listCapacity);
     return list;
 }
 
-inline void carraylistAlloc(CArrayList* list, uint32_t arrayItemStride, uint32_t arrayItemCapacity, uint32_t listCapacity)
+inline void carraylistAlloc(CArrayList* list, CSize arrayItemStride, CSize arrayItemCapacity, CSize listCapacity)
 {
-    uint32_t arraySize = arrayItemStride * arrayItemCapacity;
-    uint32_t listStride = (uint32_t)sizeof(CArrayHeader) + arraySize;
-    clistAlloc(list, listStride, listCapacity);
+    carraylistAllocEx(list, arrayItemStride, arrayItemCapacity, listCapacity, callocatorDefault());
+}
+
+inline void carraylistAllocEx(CArrayList* list, CSize arrayItemStride, CSize arrayItemCapacity, CSize listCapacity, const CAllocator* allocator)
+{
+    CSize arraySize = arrayItemStride * arrayItemCapacity;
+    CSize listStride = (CSize)sizeof(CArrayHeader) + arraySize;
+    clistAllocEx(list, listStride, listCapacity, allocator);
 
     // init headers
     CArrayHeader  ref; ref.Count = 0u; ref.Capacity = arrayItemCapacity; ref.Stride = arrayItemStride; ref.UserData = 0u;
@@ -153,7 +163,7 @@ inline void carraylistAlloc(CArrayList* list, uint32_t arrayItemStride, uint32_t
     }
 }
 
-inline void carraylistRealloc(CArrayList* list, uint32_t newListCapacity)
+inline void carraylistRealloc(CArrayList* list, CSize newListCapacity)
 {
     clistRealloc(list, newListCapacity);
 
@@ -176,7 +186,7 @@ void carraylistFree(CArrayList* list)
 inline void carraylistZeroMem(CArrayList* list)
 {
     CArrayHeader* itr = (CArrayHeader*)clistEnd(list);
-    uint32_t capsize = itr->Stride * itr->Capacity;
+    CSize capsize = itr->Stride * itr->Capacity;
     CArrayHeader* end = (CArrayHeader*)clistCapacityEnd(list);
     while (itr != end)
     {
@@ -185,16 +195,24 @@ inline void carraylistZeroMem(CArrayList* list)
     }
 }
 
-inline void carraylistGrow(CArrayList* list, uint32_t numNewItems)
+inline void carraylistReserve(CArrayList* list, CSize minListCapacity)
+{
+    if (minListCapacity > list->Capacity)
+    {
+        carraylistRealloc(list, minListCapacity);
+    }
+}
+
+inline void carraylistGrow(CArrayList* list, CSize numNewItems)
 {
-    uint32_t newcapacity = list->Capacity + numNewItems;
+    CSize newcapacity = list->Capacity + numNewItems;
     carraylistRealloc(list, newcapacity);
 }
 
-inline void carraylistGrowZero(CArrayList* list, uint32_t numNewItems)
+inline void carraylistGrowZero(CArrayList* list, CSize numNewItems)
 {
     CArrayHeader* itr = (CArrayHeader*)clistCapacityEnd(list);
-    uint32_t capsize = itr->Stride * itr->Capacity;
+    CSize capsize = itr->Stride * itr->Capacity;
     carraylistGrow(list, numNewItems);
     CArrayHeader* end = (CArrayHeader*)clistCapacityEnd(list);
     while (itr != end)
@@ -204,73 +222,73 @@ inline void carraylistGrowZero(CArrayList* list, uint32_t numNewItems)
     }
 }
 
-inline void carraylistShrink(CArrayList* list, uint32_t numLessItems)
+inline void carraylistShrink(CArrayList* list, CSize numLessItems)
 {
-    uint32_t newcapacity = list->Capacity - numLessItems;
+    CSize newcapacity = list->Capacity - numLessItems;
     carraylistRealloc(list, newcapacity);
 }
 
 // returns new list index
-uint32_t carraylistAddArray(CArrayList* list)
+CSize carraylistAddArray(CArrayList* list)
 {
-    uint32_t index = list->Count;
+    CSize index = list->Count;
     clistGrow(list, 1);
     ++list->Count;
     return index;
 }
 
 // returns first new list index, increment index per list
-uint32_t carraylistAddArrayRange(CArrayList* list, uint32_t arraysCount)
+CSize carraylistAddArrayRange(CArrayList* list, CSize arraysCount)
 {
-    uint32_t index = list->Count;
+    CSize index = list->Count;
     clistGrow(list, arraysCount);
     list->Count += arraysCount;
     return index;
 }
 
-inline CArrayHeader* carraylistArrayAt(CArrayList* list, uint32_t index)
+inline CArrayHeader* carraylistArrayAt(CArrayList* list, CSize index)
 {
     CArrayHeader* header = (CArrayHeader*)clistItemAt(list, index);
     return header;
 }
 
-void carraylistAddItem(CArrayList* list, uint32_t arrayIndex, void* item)
+void carraylistAddItem(CArrayList* list, CSize arrayIndex, void* item)
 {
     CArrayHeader* header = (CArrayHeader*)clistItemAt(list, arrayIndex);
-    uint8_t* data = (uint8_t*)header + (uint32_t)sizeof(CArrayHeader);
+    uint8_t* data = (uint8_t*)header + (CSize)sizeof(CArrayHeader);
     assert(header->Count + 1 <= header->Capacity);
     uint8_t* dst = data + header->Count;
-    uint32_t cpysize = header->Stride;
+    CSize cpysize = header->Stride;
     memcpy(dst, item, cpysize);
     ++header->Count;
 }
 
-void carraylistAddItemRange(CArrayList* list, uint32_t arrayIndex, void* items, uint32_t itemsCount)
+void carraylistAddItemRange(CArrayList* list, CSize arrayIndex, void* items, CSize itemsCount)
 {
     CArrayHeader* header = (CArrayHeader*)clistItemAt(list, arrayIndex);
-    uint8_t* data = (uint8_t*)header + (uint32_t)sizeof(CArrayHeader);
+    uint8_t* data = (uint8_t*)header + (CSize)sizeof(CArrayHeader);
     assert(header->Count + itemsCount <= header->Capacity);
     uint8_t* dst = data + header->Count;
-    uint32_t cpysize = header->Stride * itemsCount;
+    CSize cpysize = header->Stride * itemsCount;
     memcpy(dst, items, cpysize);
     header->Count += itemsCount;
 }
 
-inline void* carraylistItemAt(CArrayList* list, uint32_t arrayIndex, uint32_t itemIndex)
+inline void* carraylistItemAt(CArrayList* list, CSize arrayIndex, CSize itemIndex)
 {
     CArrayHeader* header = carraylistArrayAt(list, arrayIndex);
     uint8_t* data = (uint8_t*)header + sizeof(CArrayHeader);
-    uint32_t offset = header->Stride * itemIndex;
+    CSize offset = header->Stride * itemIndex;
     return data + offset;
 }
 
-inline void carraylistInsertItemAt(CArrayList* list, uint32_t arrayIndex, void* item, uint32_t insertItemIndex)
+inline void carraylistInsertItemAt(CArrayList* list, CSize arrayIndex, void* item, CSize insertItemIndex)
 {
     CArrayHeader* header = carraylistArrayAt(list, arrayIndex);
     uint8_t* data = (uint8_t*)carraylistData(header);
 
-    uint32_t stride = header->Stride;
-    uint32_t insoff = stride * insertItemIndex;
+    CSize stride = header->Stride;
+    CSize insoff = stride * insertItemIndex;
     uint8_t* insdst = data + insoff;
     uint8_t* movdst = insdst + stride;
     uint8_t* end = data + header->Count;
@@ -280,14 +298,14 @@ inline void carraylistInsertItemAt(CArrayList* list, uint32_t arrayIndex, void*
     assert(header->Count <= header->Capacity && "CArray out of bounds");
 }
 
-inline void carraylistInsertItemRangeAt(CArrayList* list, uint32_t arrayIndex, void* items, uint32_t itemsCount, uint32_t insertItemsIndex)
+inline void carraylistInsertItemRangeAt(CArrayList* list, CSize arrayIndex, void* items, CSize itemsCount, CSize insertItemsIndex)
 {
     CArrayHeader* header = carraylistArrayAt(list, arrayIndex);
     uint8_t* data = (uint8_t*)carraylistData(header);
 
-    uint32_t stride = header->Stride;
-    uint32_t itemsSize = stride * itemsCount;
-    uint32_t insoff = stride * insertItemsIndex;
+    CSize stride = header->Stride;
+    CSize itemsSize = stride * itemsCount;
+    CSize insoff = stride * insertItemsIndex;
     uint8_t* insdst = data + insoff;
     uint8_t* movdst = insdst + itemsSize;
     uint8_t* end = data + header->Count;
@@ -297,56 +315,56 @@ inline void carraylistInsertItemRangeAt(CArrayList* list, uint32_t arrayIndex, v
     assert(header->Count <= header->Capacity && "CArray out of bounds");
 }
 
-inline void carraylistZeroItemAt(CArrayList* list, uint32_t arrayIndex, uint32_t itemIndex)
+inline void carraylistZeroItemAt(CArrayList* list, CSize arrayIndex, CSize itemIndex)
 {
     CArrayHeader* header = carraylistArrayAt(list, arrayIndex);
     uint8_t* data = (uint8_t*)carraylistData(header);
-    uint32_t stride = header->Stride;
-    uint32_t off = stride * itemIndex;
+    CSize stride = header->Stride;
+    CSize off = stride * itemIndex;
     uint8_t* dst = data + off;
     memset(dst, 0, stride);
 }
 
-inline void carraylistZeroItemRangeAt(CArrayList* list, uint32_t arrayIndex, uint32_t itemsCount, uint32_t itemsIndex)
+inline void carraylistZeroItemRangeAt(CArrayList* list, CSize arrayIndex, CSize itemsCount, CSize itemsIndex)
 {
     CArrayHeader* header = carraylistArrayAt(list, arrayIndex);
     uint8_t* data = (uint8_t*)carraylistData(header);
-    uint32_t stride = header->Stride;
-    uint32_t size = stride * itemsCount;
-    uint32_t off = stride * itemsIndex;
+    CSize stride = header->Stride;
+    CSize size = stride * itemsCount;
+    CSize off = stride * itemsIndex;
     uint8_t* dst = data + off;
     memset(dst, 0, size);
 }
 
-inline uint32_t carraylistFindItemIndex(CArrayList* list, uint32_t arrayIndex, void* item)
+inline CSize carraylistFindItemIndex(CArrayList* list, CSize arrayIndex, void* item)
 {
     CArrayHeader* header = carraylistArrayAt(list, arrayIndex);
     uint8_t* data = (uint8_t*)carraylistData(header);
-    uint32_t stride = header->Stride;
-    uint32_t capsize = stride * header->Capacity;
+    CSize stride = header->Stride;
+    CSize capsize = stride * header->Capacity;
 
     uint8_t* itr = data;
     uint8_t* end = data + capsize;
-    for (uint32_t i = 0; itr != end; itr += stride, ++i)
+    for (CSize i = 0; itr != end; itr += stride, ++i)
     {
         if (memcmp(itr, item, stride) == 0)
         {
             return i;
         }
     }
-    return CCOLLECTION_ERROR;
+    return CCOLLECTION_NOT_FOUND;
 }
 
-inline uint32_t carraylistFindItemZeroIndex(CArrayList* list, uint32_t arrayIndex)
+inline CSize carraylistFindItemZeroIndex(CArrayList* list, CSize arrayIndex)
 {
     CArrayHeader* header = carraylistArrayAt(list, arrayIndex);
     uint8_t* data = (uint8_t*)carraylistData(header);
-    uint32_t stride = header->Stride;
-    uint32_t capsize = stride * header->Capacity;
+    CSize stride = header->Stride;
+    CSize capsize = stride * header->Capacity;
 
     uint8_t* itr = data;
     uint8_t* end = data + capsize;
-    for (uint32_t i = 0; itr != end; itr += stride, ++i)
+    for (CSize i = 0; itr != end; itr += stride, ++i)
     {
         uint8_t bytesOr = 0;
         for (uint8_t* byte = itr, *byteEnd = itr + stride; byte != byteEnd; ++byte)
@@ -358,10 +376,10 @@ inline uint32_t carraylistFindItemZeroIndex(CArrayList* list, uint32_t arrayInde
             return i;
         }
     }
-    return CCOLLECTION_ERROR;
+    return CCOLLECTION_NOT_FOUND;
 }
 
-inline void carraylistRemoveArrayAt(CArrayList* list, uint32_t arrayIndex)
+inline void carraylistRemoveArrayAt(CArrayList* list, CSize arrayIndex)
 {
     CArrayHeader* lastheader = (CArrayHeader*)carraylistLast(list);
     CArrayHeader* remheader = (CArrayHeader*)carraylistArrayAt(list, arrayIndex);
@@ -369,13 +387,13 @@ inline void carraylistRemoveArrayAt(CArrayList* list, uint32_t arrayIndex)
     --list->Count;
 }
 
-inline void carraylistRemoveItemAt(CArrayList* list, uint32_t arrayIndex, uint32_t itemIndex)
+inline void carraylistRemoveItemAt(CArrayList* list, CSize arrayIndex, CSize itemIndex)
 {
     CArrayHeader* header = carraylistArrayAt(list, arrayIndex);
     uint8_t* data = (uint8_t*)carraylistData(header);
-    uint32_t stride = header->Stride;
-    uint32_t capsize = stride * header->Capacity;
-    uint32_t off = stride * itemIndex;
+    CSize stride = header->Stride;
+    CSize capsize = stride * header->Capacity;
+    CSize off = stride * itemIndex;
     uint8_t* dst = data + off;
     uint8_t* src = dst + stride;
     uint8_t* end = data + capsize;
@@ -383,14 +401,14 @@ inline void carraylistRemoveItemAt(CArrayList* list, uint32_t arrayIndex, uint32
     --header->Count;
 }
 
-inline void carraylistRemoveItemRangeAt(CArrayList* list, uint32_t arrayIndex, uint32_t itemsIndex, uint32_t itemsCount)
+inline void carraylistRemoveItemRangeAt(CArrayList* list, CSize arrayIndex, CSize itemsIndex, CSize itemsCount)
 {
     CArrayHeader* header = carraylistArrayAt(list, arrayIndex);
     uint8_t* data = (uint8_t*)carraylistData(header);
-    uint32_t stride = header->Stride;
-    uint32_t capsize = stride * header->Capacity;
-    uint32_t remsize = stride * itemsCount;
-    uint32_t off = stride * itemsIndex;
+    CSize stride = header->Stride;
+    CSize capsize = stride * header->Capacity;
+    CSize remsize = stride * itemsCount;
+    CSize off = stride * itemsIndex;
     uint8_t* dst = data + off;
     uint8_t* src = dst + remsize;
     uint8_t* end = data + capsize;
@@ -398,16 +416,16 @@ inline void carraylistRemoveItemRangeAt(CArrayList* list, uint32_t arrayIndex, u
     header->Count -= itemsCount;
 }
 
-inline void carraylistRemoveItem(CArrayList* list, uint32_t arrayIndex, void* item)
+inline void carraylistRemoveItem(CArrayList* list, CSize arrayIndex, void* item)
 {
     CArrayHeader* header = carraylistArrayAt(list, arrayIndex);
     uint8_t* data = (uint8_t*)carraylistData(header);
-    uint32_t stride = header->Stride;
-    uint32_t capsize = stride * header->Capacity;
+    CSize stride = header->Stride;
+    CSize capsize = stride * header->Capacity;
 
     uint8_t* itr = data;
     uint8_t* end = data + capsize;
-    for (uint32_t i = 0; itr != end; itr += stride, ++i)
+    for (CSize i = 0; itr != end; itr += stride, ++i)
     {
         if (memcmp(itr, item, stride) == 0)
         {
@@ -0,0 +1,177 @@
+// MIT License - CCollections
+// Copyright(c) 2020 Dante Falcone (dantefalcone@gmail.com)
+#pragma once
+#include <stdint.h>
+
+/*  CAtomic
+
+    Minimal sequentially consistent atomics on plain integers, for lock-free containers
+    Acquire/release loads and stores for single writer indices, where a full barrier per operation is too slow
+    MSVC interlocked intrinsics, GCC/Clang __atomic builtins
+*/
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+static inline uint32_t catomicLoad32(volatile uint32_t* ptr);
+static inline void catomicStore32(volatile uint32_t* ptr, uint32_t value);
+// returns value before add
+static inline uint32_t catomicFetchAdd32(volatile uint32_t* ptr, uint32_t value);
+// returns value before exchange
+static inline uint32_t catomicExchange32(volatile uint32_t* ptr, uint32_t value);
+// returns 1 and stores desired if *ptr == expected, else returns 0
+static inline uint32_t catomicCompareExchange32(volatile uint32_t* ptr, uint32_t expected, uint32_t desired);
+static inline uint64_t catomicLoad64(volatile uint64_t* ptr);
+// returns value before add
+static inline uint64_t catomicFetchAdd64(volatile uint64_t* ptr, uint64_t value);
+// returns 1 and stores desired if *ptr == expected, else returns 0
+static inline uint32_t catomicCompareExchange64(volatile uint64_t* ptr, uint64_t expected, uint64_t desired);
+// later loads and stores are not moved before it
+static inline uint32_t catomicLoadAcquire32(volatile uint32_t* ptr);
+// earlier loads and stores are not moved after it
+static inline void catomicStoreRelease32(volatile uint32_t* ptr, uint32_t value);
+
+
+#if defined(_MSC_VER)
+
+uint32_t catomicLoad32(volatile uint32_t* ptr)
+{
+    return (uint32_t)_InterlockedOr((volatile long*)ptr, 0);
+}
+
+void catomicStore32(volatile uint32_t* ptr, uint32_t value)
+{
+    _InterlockedExchange((volatile long*)ptr, (long)value);
+}
+
+uint32_t catomicFetchAdd32(volatile uint32_t* ptr, uint32_t value)
+{
+    return (uint32_t)_InterlockedExchangeAdd((volatile long*)ptr, (long)value);
+}
+
+uint32_t catomicExchange32(volatile uint32_t* ptr, uint32_t value)
+{
+    return (uint32_t)_InterlockedExchange((volatile long*)ptr, (long)value);
+}
+
+uint32_t catomicCompareExchange32(volatile uint32_t* ptr, uint32_t expected, uint32_t desired)
+{
+    return (uint32_t)_InterlockedCompareExchange((volatile long*)ptr, (long)desired, (long)expected) == expected;
+}
+
+uint64_t catomicLoad64(volatile uint64_t* ptr)
+{
+    return (uint64_t)_InterlockedCompareExchange64((volatile long long*)ptr, 0, 0);
+}
+
+uint64_t catomicFetchAdd64(volatile uint64_t* ptr, uint64_t value)
+{
+#if defined(_M_IX86)
+    uint64_t expected = catomicLoad64(ptr);
+    while (!catomicCompareExchange64(ptr, expected, expected + value))
+    {
+        expected = catomicLoad64(ptr);
+    }
+    return expected;
+#else
+    return (uint64_t)_InterlockedExchangeAdd64((volatile long long*)ptr, (long long)value);
+#endif
+}
+
+uint32_t catomicCompareExchange64(volatile uint64_t* ptr, uint64_t expected, uint64_t desired)
+{
+    return (uint64_t)_InterlockedCompareExchange64((volatile long long*)ptr, (long long)desired, (long long)expected) == expected;
+}
+
+#if defined(_M_ARM64)
+
+uint32_t catomicLoadAcquire32(volatile uint32_t* ptr)
+{
+    return (uint32_t)__ldar32((volatile unsigned __int32*)ptr);
+}
+
+void catomicStoreRelease32(volatile uint32_t* ptr, uint32_t value)
+{
+    __stlr32((volatile unsigned __int32*)ptr, value);
+}
+
+#else
+
+// x86 loads are acquire and stores are release, only the compiler needs fencing
+uint32_t catomicLoadAcquire32(volatile uint32_t* ptr)
+{
+    uint32_t value = *ptr;
+    _ReadWriteBarrier();
+    return value;
+}
+
+void catomicStoreRelease32(volatile uint32_t* ptr, uint32_t value)
+{
+    _ReadWriteBarrier();
+    *ptr = value;
+}
+
+#endif // _M_ARM64
+
+#else
+
+uint32_t catomicLoad32(volatile uint32_t* ptr)
+{
+    return __atomic_load_n(ptr, __ATOMIC_SEQ_CST);
+}
+
+void catomicStore32(volatile uint32_t* ptr, uint32_t value)
+{
+    __atomic_store_n(ptr, value, __ATOMIC_SEQ_CST);
+}
+
+uint32_t catomicFetchAdd32(volatile uint32_t* ptr, uint32_t value)
+{
+    return __atomic_fetch_add(ptr, value, __ATOMIC_SEQ_CST);
+}
+
+uint32_t catomicExchange32(volatile uint32_t* ptr, uint32_t value)
+{
+    return __atomic_exchange_n(ptr, value, __ATOMIC_SEQ_CST);
+}
+
+uint32_t catomicCompareExchange32(volatile uint32_t* ptr, uint32_t expected, uint32_t desired)
+{
+    return __atomic_compare_exchange_n(ptr, &expected, desired, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST) ? 1u : 0u;
+}
+
+uint64_t catomicLoad64(volatile uint64_t* ptr)
+{
+    return __atomic_load_n(ptr, __ATOMIC_SEQ_CST);
+}
+
+uint64_t catomicFetchAdd64(volatile uint64_t* ptr, uint64_t value)
+{
+    return __atomic_fetch_add(ptr, value, __ATOMIC_SEQ_CST);
+}
+
+uint32_t catomicCompareExchange64(volatile uint64_t* ptr, uint64_t expected, uint64_t desired)
+{
+    return __atomic_compare_exchange_n(ptr, &expected, desired, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST) ? 1u : 0u;
+}
+
+uint32_t catomicLoadAcquire32(volatile uint32_t* ptr)
+{
+    return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+void catomicStoreRelease32(volatile uint32_t* ptr, uint32_t value)
+{
+    __atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+}
+
+#endif // _MSC_VER
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
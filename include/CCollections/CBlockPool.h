@@ -2,6 +2,7 @@
 // Copyright(c) 2020 Dante Falcone (dantefalcone@gmail.com)
 #pragma once
 #include "CTypes.h"
+#include "CAllocator.h"
 #include <malloc.h>
 #include <string.h>
 #include <assert.h>
@@ -13,7 +14,27 @@
 // - backed by single memory allocation pool
 // - reallocation of mempory pool on growth by power of 2
 
-inline void cblockpoolAlloc(CBlockPool* pool, uint32_t blockStride, uint32_t blockCapacity, uint32_t itemStride)
+static inline void cblockpoolAllocEx(CBlockPool* pool, CSize blockStride, CSize blockCapacity, CSize itemStride, const CAllocator* allocator);
+static inline void cblockpoolAlloc(CBlockPool* pool, CSize blockStride, CSize blockCapacity, CSize itemStride);
+static inline void cblockpoolFree(CBlockPool* pool);
+static inline CBlockHeader* cblockpoolBegin(CBlockPool* pool);
+static inline CBlockHeader* cblockpoolLast(CBlockPool* pool);
+static inline CBlockHeader* cblockpoolEnd(CBlockPool* pool);
+static inline CBlockHeader* cblockpoolNext(CBlockPool* pool, CBlockHeader* block);
+static inline CBlockHeader* cblockpoolPrev(CBlockPool* pool, CBlockHeader* block);
+static inline CBlockHeader* cblockpoolBlockAtOffset(CBlockPool* pool, CSize offset);
+static inline CSize cblockpoolOffsetOfBlock(CBlockPool* pool, CBlockHeader* block);
+static inline void* cblockpoolItemAtBlock(CBlockPool* pool, CBlockHeader* block, CSize index);
+static inline CBlockHeader* cblockpoolAdd(CBlockPool* pool);
+static inline void cblockpoolRemove(CBlockPool* pool, CSize blockOffset);
+static inline CSize cblockpoolAddAt(CBlockPool* pool, CSize blockOffset);
+static inline void* cblockpoolItemAt(CBlockPool* pool, CSize blockOffset, CSize itemIndex);
+static inline void cblockpoolAddItemAt(CBlockPool* pool, CSize blockOffset, void* item);
+static inline void* cblockpoolPopBackItemAt(CBlockPool* pool, CSize blockOffset);
+static inline void cblockpoolRemoveItemAtIndex(CBlockPool* pool, CSize blockOffset, CSize index);
+
+
+inline void cblockpoolAllocEx(CBlockPool* pool, CSize blockStride, CSize blockCapacity, CSize itemStride, const CAllocator* allocator)
 {
     // alloc memory
     blockStride += sizeof(CBlockHeader);
@@ -24,15 +45,16 @@ inline void cblockpoolAlloc(CBlockPool* pool, uint32_t blockStride, uint32_t blo
     pool->Base.Count = 0;
     pool->Base.Capacity = blockCapacity;
     pool->Base.Stride = blockStride;
-    uint32_t size = blockCapacity * blockStride;
-    pool->Base.Data = (uint8_t*)_mm_malloc(size, CCOLLECTIONS_ALIGNMENT);
+    size_t size = (size_t)blockCapacity * blockStride;
+    pool->Base.Allocator = allocator;
+    pool->Base.Data = (uint8_t*)callocatorAlloc(allocator, size);
     pool->Base.Type = CCOLLECTION_TYPE_BLOCKPOOL;
     pool->SubItemStride = itemStride;
 
     // init free list
     CBlockHeader* block = (CBlockHeader*)pool->Base.Data;
     CBlockHeader* last = (CBlockHeader*)((uint8_t*)block + size - blockStride);
-    uint32_t next = blockStride;
+    CSize next = blockStride;
     while (block != last)
     {
         block->Count = 0;
@@ -45,9 +67,14 @@ inline void cblockpoolAlloc(CBlockPool* pool, uint32_t blockStride, uint32_t blo
     last->Next = 0;
 }
 
+inline void cblockpoolAlloc(CBlockPool* pool, CSize blockStride, CSize blockCapacity, CSize itemStride)
+{
+    cblockpoolAllocEx(pool, blockStride, blockCapacity, itemStride, callocatorDefault());
+}
+
 inline void cblockpoolFree(CBlockPool* pool)
 {
-    _mm_free(pool->Base.Data);
+    callocatorFree(pool->Base.Allocator, pool->Base.Data, (size_t)pool->Base.Capacity * pool->Base.Stride);
 }
 
 inline CBlockHeader* cblockpoolBegin(CBlockPool* pool)
@@ -102,7 +129,7 @@ inline CBlockHeader* cblockpoolPrev(CBlockPool* pool, CBlockHeader* block)
 }
 
 // O(n) avoid
-//inline CBlockHeader* cblockpoolBlockAt(CBlockPool* pool, uint32_t index)
+//inline CBlockHeader* cblockpoolBlockAt(CBlockPool* pool, CSize index)
 //{
 //    CBlockHeader* block = (CBlockHeader*)pool->Base.Data;
 //    while (index--)
@@ -112,19 +139,19 @@ inline CBlockHeader* cblockpoolPrev(CBlockPool* pool, CBlockHeader* block)
 //    return block;
 //}
 
-inline CBlockHeader* cblockpoolBlockAtOffset(CBlockPool* pool, uint32_t offset)
+inline CBlockHeader* cblockpoolBlockAtOffset(CBlockPool* pool, CSize offset)
 {
     return (CBlockHeader*)(pool->Base.Data + offset);
 }
 
-inline uint32_t cblockpoolOffsetOfBlock(CBlockPool* pool, CBlockHeader* block)
+inline CSize cblockpoolOffsetOfBlock(CBlockPool* pool, CBlockHeader* block)
 {
-    return (uint32_t)((uint8_t*)block - pool->Base.Data);
+    return (CSize)((uint8_t*)block - pool->Base.Data);
 }
 
-inline void* cblockpoolItemAtBlock(CBlockPool* pool, CBlockHeader* block, uint32_t index)
+inline void* cblockpoolItemAtBlock(CBlockPool* pool, CBlockHeader* block, CSize index)
 {
-    uint32_t offset = pool->SubItemStride * index;
+    CSize offset = pool->SubItemStride * index;
     uint8_t* data = (uint8_t*)block + sizeof(CBlockHeader) + offset;
     return data;
 }
@@ -162,7 +189,7 @@ inline CBlockHeader* cblockpoolAdd(CBlockPool* pool)
     return blockNew;
 }
 
-inline void cblockpoolRemove(CBlockPool* pool, uint32_t blockOffset)
+inline void cblockpoolRemove(CBlockPool* pool, CSize blockOffset)
 {
     CBlockHeader* blockRemove = cblockpoolBlockAtOffset(pool, blockOffset);
     CBlockHeader* blockPrev = cblockpoolBlockAtOffset(pool, blockRemove->Prev);
@@ -177,7 +204,7 @@ inline void cblockpoolRemove(CBlockPool* pool, uint32_t blockOffset)
     pool->Free = blockOffset;
 }
 
-inline uint32_t cblockpoolAddAt(CBlockPool* pool, uint32_t blockOffset)
+inline CSize cblockpoolAddAt(CBlockPool* pool, CSize blockOffset)
 {
     // check if need realloc
     if (pool->Base.Count == pool->Base.Capacity)
@@ -195,16 +222,17 @@ inline uint32_t cblockpoolAddAt(CBlockPool* pool, uint32_t blockOffset)
     
     block->Count = 0;
     block->Next = 0;
+    return cblockpoolOffsetOfBlock(pool, block);
 }
 
-inline void* cblockpoolItemAt(CBlockPool* pool, uint32_t blockOffset, uint32_t itemIndex)
+inline void* cblockpoolItemAt(CBlockPool* pool, CSize blockOffset, CSize itemIndex)
 {
     // goto block
     CBlockHeader* block = cblockpoolBlockAtOffset(pool, blockOffset);
     
     // normalize index to block
     // seek to block containing item
-    uint32_t capacity = pool->Base.Stride / pool->SubItemStride;
+    CSize capacity = pool->Base.Stride / pool->SubItemStride;
     while (itemIndex >= capacity)
     {
         block = cblockpoolNext(pool, block);
@@ -217,7 +245,7 @@ inline void* cblockpoolItemAt(CBlockPool* pool, uint32_t blockOffset, uint32_t i
     return (void*)item;
 }
 
-inline void cblockpoolAddItemAt(CBlockPool* pool, uint32_t blockOffset, void* item)
+inline void cblockpoolAddItemAt(CBlockPool* pool, CSize blockOffset, void* item)
 {
     CBlockHeader* block = cblockpoolBlockAtOffset(pool, blockOffset);
     while (block->Next)
@@ -243,7 +271,7 @@ inline void cblockpoolAddItemAt(CBlockPool* pool, uint32_t blockOffset, void* it
     ++block->Count;
 }
 
-inline void* cblockpoolPopBackItemAt(CBlockPool* pool, uint32_t blockOffset)
+inline void* cblockpoolPopBackItemAt(CBlockPool* pool, CSize blockOffset)
 {
     CBlockHeader* block = cblockpoolBlockAtOffset(pool, blockOffset);
     if (block->Count == 0)
@@ -253,7 +281,7 @@ inline void* cblockpoolPopBackItemAt(CBlockPool* pool, uint32_t blockOffset)
     return (void*)item;
 }
 
-inline void cblockpoolRemoveItemAtIndex(CBlockPool* pool, uint32_t blockOffset, uint32_t index)
+inline void cblockpoolRemoveItemAtIndex(CBlockPool* pool, CSize blockOffset, CSize index)
 {
     CBlockHeader* block = cblockpoolBlockAtOffset(pool, blockOffset);
     size_t movsize = block->Count - index;
@@ -280,17 +308,21 @@ inline void cblockpoolRemoveItemAtIndex(CBlockPool* pool, uint32_t blockOffset,
 // - Dynamic array of keys for indirrect lookup of blocks in a CBlockPool
 // - lookup O(2) = CList O(1) + CBlockPool O(1)
 
-inline CBlockHeader* cmultiblockpoolItemAt(CMultiBlockPool* multipool, uint32_t key)
+static inline CBlockHeader* cmultiblockpoolItemAt(CMultiBlockPool* multipool, CSize key);
+static inline CSize cmultiblockpoolAdd(CMultiBlockPool* multipool);
+
+
+inline CBlockHeader* cmultiblockpoolItemAt(CMultiBlockPool* multipool, CSize key)
 {
     CBlockHeader* block = cblockpoolBlockAtOffset(&multipool->Pool, key);
     return block;
 }
 
 // returns key to new multi block
-inline uint32_t cmultiblockpoolAdd(CMultiBlockPool* multipool)
+inline CSize cmultiblockpoolAdd(CMultiBlockPool* multipool)
 {
     CBlockHeader* block = cblockpoolAdd(&multipool->Pool);
-    uint32_t key = cblockpoolOffsetOfBlock(&multipool->Pool, block);
+    CSize key = cblockpoolOffsetOfBlock(&multipool->Pool, block);
     // add to key container TODO
     return key;
 }
\ No newline at end of file
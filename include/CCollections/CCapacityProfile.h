@@ -0,0 +1,143 @@
+// MIT License - CCollections
+// Copyright(c) 2020 Dante Falcone (dantefalcone@gmail.com)
+#pragma once
+#include "CList.h"
+#include <stdio.h>
+
+/*  CCapacityProfile
+
+    Records peak counts and growth events of containers during a run, keyed by a user id
+    Save the profile at shutdown, load it at startup and reserve each container once with ccapacityprofileCapacity
+    CList of CCapacityProfileEntry, text file of "key peak growths" lines
+    ecsSaveCapacityProfile and ecsLoadCapacityProfile use the same format for the containers of an ECS instance
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+static inline CList ccapacityprofileCreate(CSize capacity);
+static inline void ccapacityprofileFree(CList* profile);
+// returns NULL if key was never recorded
+static inline CCapacityProfileEntry* ccapacityprofileFind(CList* profile, uint32_t key);
+// call after adding to or growing a container - a growth event is counted when capacity changes
+static inline void ccapacityprofileRecord(CList* profile, uint32_t key, CSize count, CSize capacity);
+static inline void ccapacityprofileRecordList(CList* profile, uint32_t key, CList* list);
+// recorded peak count, reserving it holds the peak without growth - or defaultCapacity if larger or key was never recorded
+static inline CSize ccapacityprofileCapacity(CList* profile, uint32_t key, CSize defaultCapacity);
+// returns 0 on failure
+static inline uint32_t ccapacityprofileSave(CList* profile, const char* path);
+// keeps the larger of loaded and recorded peaks, growth counts restart from 0 - returns 0 on failure or malformed file
+static inline uint32_t ccapacityprofileLoad(CList* profile, const char* path);
+
+
+
+CList ccapacityprofileCreate(CSize capacity)
+{
+    return clistCreate(sizeof(CCapacityProfileEntry), capacity);
+}
+
+void ccapacityprofileFree(CList* profile)
+{
+    clistFree(profile);
+}
+
+CCapacityProfileEntry* ccapacityprofileFind(CList* profile, uint32_t key)
+{
+    CCapacityProfileEntry* itr = (CCapacityProfileEntry*)clistBegin(profile);
+    CCapacityProfileEntry* end = (CCapacityProfileEntry*)clistEnd(profile);
+    for (; itr != end; ++itr)
+    {
+        if (itr->Key == key)
+        {
+            return itr;
+        }
+    }
+    return NULL;
+}
+
+static inline CCapacityProfileEntry* ccapacityprofileFindOrAdd(CList* profile, uint32_t key)
+{
+    CCapacityProfileEntry* entry = ccapacityprofileFind(profile, key);
+    if (entry == NULL)
+    {
+        clistReserve(profile, profile->Count + 1);
+        CCapacityProfileEntry item = { key, 0, 0, 0 };
+        clistAdd(profile, &item);
+        entry = (CCapacityProfileEntry*)clistLast(profile);
+    }
+    return entry;
+}
+
+void ccapacityprofileRecord(CList* profile, uint32_t key, CSize count, CSize capacity)
+{
+    CCapacityProfileEntry* entry = ccapacityprofileFindOrAdd(profile, key);
+    if (count > entry->PeakCount)
+    {
+        entry->PeakCount = count;
+    }
+    if (entry->Capacity && capacity != entry->Capacity)
+    {
+        ++entry->GrowthCount;
+    }
+    entry->Capacity = capacity;
+}
+
+void ccapacityprofileRecordList(CList* profile, uint32_t key, CList* list)
+{
+    ccapacityprofileRecord(profile, key, list->Count, list->Capacity);
+}
+
+CSize ccapacityprofileCapacity(CList* profile, uint32_t key, CSize defaultCapacity)
+{
+    CCapacityProfileEntry* entry = ccapacityprofileFind(profile, key);
+    if (entry == NULL || entry->PeakCount <= defaultCapacity)
+    {
+        return defaultCapacity;
+    }
+    return entry->PeakCount;
+}
+
+uint32_t ccapacityprofileSave(CList* profile, const char* path)
+{
+    FILE* file = fopen(path, "w");
+    if (file == NULL)
+    {
+        return 0;
+    }
+    uint32_t bWritten = 1;
+    CCapacityProfileEntry* itr = (CCapacityProfileEntry*)clistBegin(profile);
+    CCapacityProfileEntry* end = (CCapacityProfileEntry*)clistEnd(profile);
+    for (; itr != end; ++itr)
+    {
+        bWritten &= fprintf(file, "%u %llu %llu\n", itr->Key, (unsigned long long)itr->PeakCount, (unsigned long long)itr->GrowthCount) > 0;
+    }
+    bWritten &= fclose(file) == 0;
+    return bWritten;
+}
+
+uint32_t ccapacityprofileLoad(CList* profile, const char* path)
+{
+    FILE* file = fopen(path, "r");
+    if (file == NULL)
+    {
+        return 0;
+    }
+    uint32_t key;
+    unsigned long long peak, growths;
+    int fields;
+    while ((fields = fscanf(file, "%u %llu %llu", &key, &peak, &growths)) == 3)
+    {
+        CCapacityProfileEntry* entry = ccapacityprofileFindOrAdd(profile, key);
+        if (peak > entry->PeakCount)
+        {
+            entry->PeakCount = (CSize)peak;
+        }
+    }
+    fclose(file);
+    return fields == EOF;
+}
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
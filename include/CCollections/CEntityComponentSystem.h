@@ -3,6 +3,7 @@
 
 #pragma once
 #include <stdint.h>
+#include <stddef.h>
 
 #ifndef ECS_MAX_COMPONENT_TYPES
 #define ECS_MAX_COMPONENT_TYPES 255
@@ -37,15 +38,70 @@
 #define ECS_DEFAULT_QUERY_COUNT 256
 #endif // !ECS_DEFAULT_QUERY_COUNT
 
-#ifndef ECS_ALIGNMENT 
-#define ECS_ALIGNMENT 4096
-#endif // !ECS_ALIGNMENT 
+#ifndef ECS_DEFAULT_SPARSE_COMPONENT_CAPACITY
+#define ECS_DEFAULT_SPARSE_COMPONENT_CAPACITY 256
+#endif // !ECS_DEFAULT_SPARSE_COMPONENT_CAPACITY
+
+#ifndef ECS_INVALID_ID
+// archetypeId and componentsId of a destroyed entity
+#define ECS_INVALID_ID 0xFFFFFFFF
+#endif // !ECS_INVALID_ID
+
+#ifndef ECS_AOSOA_LANES
+// entities per block of an AoSoA component array, 8 lanes of 4 byte fields fill a 256 bit register
+#define ECS_AOSOA_LANES 8
+#endif // !ECS_AOSOA_LANES
+
+#ifndef ECS_SNAPSHOT_CHUNK_ENTITIES
+// entities per write tracked chunk of a snapshot component array, multiple of ECS_AOSOA_LANES
+#define ECS_SNAPSHOT_CHUNK_ENTITIES 64
+#endif // !ECS_SNAPSHOT_CHUNK_ENTITIES
+
+#ifndef ECS_MAX_SYSTEMS
+// max systems of an instance, dependencies between systems are stored as 64 bit masks
+#define ECS_MAX_SYSTEMS 64
+#endif // !ECS_MAX_SYSTEMS
+
+#ifndef ECS_MAX_SYSTEM_THREADS
+#define ECS_MAX_SYSTEM_THREADS 64
+#endif // !ECS_MAX_SYSTEM_THREADS
+
+#ifndef ECS_FILE_ALIGNMENT
+// alignment of every array in a file saved by ecsSaveInstance
+#define ECS_FILE_ALIGNMENT 64
+#endif // !ECS_FILE_ALIGNMENT
+
+#ifndef ECS_REALTIME_ASSERT
+// 1 to assert on any allocation in real-time mode, otherwise allocations are only counted (see ecsBeginRealtime)
+#define ECS_REALTIME_ASSERT 0
+#endif // !ECS_REALTIME_ASSERT
+
+#ifndef ECS_COMPACT_SHRINK_LOAD
+// percentage of archetype entity capacity in use, below which ecsCompact shrinks the archetype
+#define ECS_COMPACT_SHRINK_LOAD 25
+#endif // !ECS_COMPACT_SHRINK_LOAD
+
+#ifndef ECS_COMPACT_TARGET_LOAD
+// percentage of archetype entity capacity in use after ecsCompact shrinks the archetype
+#define ECS_COMPACT_TARGET_LOAD 50
+#endif // !ECS_COMPACT_TARGET_LOAD
+
+#ifndef ECS_COMPACT_MIN_ARCHETYPE_ENTITY_CAPACITY
+// ecsCompact never shrinks an archetype below this capacity, only frees it when empty
+#define ECS_COMPACT_MIN_ARCHETYPE_ENTITY_CAPACITY 16
+#endif // !ECS_COMPACT_MIN_ARCHETYPE_ENTITY_CAPACITY
+
+#ifndef ECS_INCREMENTAL_GROWTH_MIN_BYTES
+// archetypes with fewer bytes of columns are grown at once, see ecsEnableIncrementalGrowth
+#define ECS_INCREMENTAL_GROWTH_MIN_BYTES 0x40000
+#endif // !ECS_INCREMENTAL_GROWTH_MIN_BYTES
 
 
 /* Example Usage:
 
 typedef struct Position { float x, y, z, w; } Position;
 typedef struct Attributes { int a, b, c, d; } Attributes;
+typedef struct Stunned { float seconds; } Stunned;
 
 // component ids are simply an index from 0 to (ECS_MAX_COMPONENT_TYPES - 1)
 // it is your responsibility to keep track of component id to component struct mapping
@@ -53,7 +109,8 @@ typedef struct Attributes { int a, b, c, d; } Attributes;
 enum EComponentIds
 {
     ePositionId,
-    eAttributesId
+    eAttributesId,
+    eStunnedId
 };
 
 int main()
@@ -90,6 +147,36 @@ int main()
         printf("Processed components for entity %u", curEntityId);
     }
 
+    // components with fields of equal size can be stored AoSoA by setting fieldSize in EcsComponentDesc
+    // ex. { ePositionId, sizeof(Position), sizeof(float) } stores blocks of 8 x, 8 y, 8 z, 8 w
+    // ecsIterateQueryBlock hands out one block per iteration, each field maps to a 256 bit register
+    uint laneCount;
+    void* blocks[2];
+    EcsQueryIterator blockItr = ecsCreateQueryIterator(&instance, ePositionVelocityQuery);
+    while( ecsIterateQueryBlock(&blockItr, &laneCount, blocks) )
+    {
+        float* pos = (float*)blocks[0];
+        float* vel = (float*)blocks[1];
+        for (uint field = 0; field < 4; ++field)
+        {
+            __m256 p = _mm256_load_ps(pos + field * ECS_AOSOA_LANES);
+            __m256 v = _mm256_load_ps(vel + field * ECS_AOSOA_LANES);
+            _mm256_store_ps(pos + field * ECS_AOSOA_LANES, _mm256_add_ps(p, v));
+        }
+    }
+
+    // components toggled often are stored in sparse sets, adding and removing them does not move the entity
+    // register before creating archetypes and queries with eStunnedId, queries skip entities without it
+    ecsCreateSparseComponent(&instance, eStunnedId, sizeof(Stunned));
+    Stunned* stunned = (Stunned*)ecsAddSparseComponent(&instance, entityId, eStunnedId);
+    ecsRemoveSparseComponent(&instance, entityId, eStunnedId);
+
+    // paused or culled entities are disabled in place, queries skip them without moving any data
+    ecsSetEntityEnabled(&instance, entityId, 0);
+
+    // once per frame, reclaim memory of archetypes emptied by destroyed entities (visits up to 8 archetypes)
+    ecsCompact(&instance, 8);
+
     // TODO: add/remove components, sort order tags, entity flags, bulk creations
 }
 
@@ -101,25 +188,43 @@ typedef uint8_t byte;
 typedef void (*EcsQueryCallback)(void** components);
 typedef void (*EcsQueryCallbackEx)(uint entityId, void** components);
 
+struct EcsInstance;
+typedef void (*EcsSystemCallback)(struct EcsInstance* instance, uint queryId, void* userData);
+
+// bits per component id, for system read and write sets
+#define ECS_COMPONENT_MASK_WORDS ((ECS_MAX_COMPONENT_TYPES + 63) / 64)
+
 #ifdef __cplusplus
 extern "C" {
 #endif // __cplusplus
 
 
+/// @brief location of an entity's components - hot data, read on every entity lookup
+/// kept to 8 bytes for 8 entities per cache line, see EcsEntityInfo for cold data
 typedef struct EcsEntity
 {
     uint32_t archetypeId; // index of archetype
     uint32_t componentsId; // unified index to all components data within archetype, also to entityId index
+} EcsEntity;
+//int sizeofEntity = sizeof(EcsEntity); // default 8
 
-    // --- not sure if need below --- could be important to keep size small
+/// @brief rarely accessed entity data - cold data, stored in an array parallel to EcsEntity
+typedef struct EcsEntityInfo
+{
     uint32_t sortOrder;
     uint32_t flags;
-} EcsEntity;
+} EcsEntityInfo;
 
+/// @brief array of one component type within an archetype
+/// AoS when fieldSize is 0, components are contiguous structs
+/// AoSoA otherwise, entities are grouped in blocks of ECS_AOSOA_LANES and each block stores every field of its entities together
+/// ex. Position { float x, y, z, w; } with fieldSize 4: [x0..x7][y0..y7][z0..z7][w0..w7] [x8..x15]...
 typedef struct EcsComponentArray
 {
     byte* components;
     size_t stride;
+    uint fieldSize;
+    uint snapshotId; // index of snapshot column, ECS_INVALID_ID when not snapshotted
 } EcsComponentArray;
 
 /// @brief packed array of sorted component ids
@@ -139,12 +244,26 @@ typedef struct EcsArchetype
     uint entityCount;
     uint entityCapacity;
 
+    // bit n of word n / 64 set when row n is enabled, see ecsSetEntityEnabled
+    uint64_t* enabledMask;
+    uint disabledCount;
+
+    // most entities held and number of reallocations, see ecsSaveCapacityProfile
+    uint peakEntityCount;
+    uint growthCount;
+
+    // rows [migrateBegin, migrateEnd) are still in the columns before the last growth, see ecsEnableIncrementalGrowth
+    byte** migrateColumns; // indexed by componentId, NULL when not migrating
+    uint migrateBegin;
+    uint migrateEnd;
+    uint migrateCapacity; // entity capacity of the previous columns
+
     // sparse array for O(1) indexing by componentId
     // entity count/capacity used to maintain dynamic arrays in unison
     // note: todo: inspect behavior of accessing invalid component
     EcsComponentArray componentArrays[ECS_MAX_COMPONENT_TYPES];
 } EcsArchetype;
-//int sizeofArchetype = sizeof(EcsArchetype); // default 4096
+//int sizeofArchetype = sizeof(EcsArchetype); // default 6176
 
 /// @brief explicitly define queries that keep track of compatible archetypes
 /// use ecsCreateQuery
@@ -153,22 +272,57 @@ typedef struct EcsQuery
     uint componentCount;
     uint archetypeCount;
     uint componentIds[ECS_MAX_QUERY_COMPONENTS];
+    uint sparseMask; // bit n set when componentIds[n] is sparse stored, see ecsCreateSparseComponent
     EcsArchetype* archetypes[ECS_MAX_QUERY_ARCHETYPES];
 } EcsQuery;
 //int sizeofQuery = sizeof(EcsQuery); // default 4096
 
+/// @brief column base pointers of one archetype of a query, in query component order
+/// cached when the archetype is added to the query and refreshed when its columns are reallocated
+typedef struct EcsQueryColumns
+{
+    byte* components[ECS_MAX_QUERY_COMPONENTS]; // NULL for sparse components
+    uint strides[ECS_MAX_QUERY_COMPONENTS];
+    uint fieldSizes[ECS_MAX_QUERY_COMPONENTS];
+    uint bAoS; // 1 when no column is AoSoA, row n of every column is at components + n * stride
+} EcsQueryColumns;
+
+/// @brief columns of every archetype of a query, parallel to EcsQuery archetypes
+typedef struct EcsQueryColumnTable
+{
+    EcsQueryColumns* columns;
+    uint capacity;
+} EcsQueryColumnTable;
+
 typedef struct EcsQueryResult
 {
     void* components[ECS_MAX_QUERY_COMPONENTS+1];
 } EcsQueryResult;
 //int sizeofQueryResult = sizeof(EcsQueryResult); // default 128
 
+/// @brief components of one sparse stored component id, kept outside of archetypes
+/// dense arrays of components and their entityIds, and a sparse index from entityId to dense index
+typedef struct EcsSparseSet
+{
+    byte* components; // dense, AoS
+    uint* entityIds; // dense, parallel to components
+    uint* sparse; // indexed by entityId, ECS_INVALID_ID when the entity does not have the component
+    size_t stride;
+    uint count;
+    uint capacity;
+    uint sparseCapacity;
+    uint peakCount; // most components held, see ecsSaveCapacityProfile
+} EcsSparseSet;
+
 typedef struct EcsQueryIterator
 {
     EcsQuery* query;
+    const EcsQueryColumnTable* columnTable;
+    EcsSparseSet* sparseSets; // indexed by componentId, joined per entity when query->sparseMask is set
 
     uint archIdIndex;
     uint archEntityIndex;
+    uint laneMask; // bit l set when lane l of the current ecsIterateQueryBlock block is enabled
 
 } EcsQueryIterator;
 
@@ -176,6 +330,7 @@ typedef struct EcsComponentDesc
 {
     uint id;
     uint stride;
+    uint fieldSize; // 0 for AoS, else size of every field of the component for AoSoA storage (see EcsComponentArray)
 } EcsComponentDesc;
 
 typedef struct EcsComponentDescEx
@@ -199,19 +354,74 @@ typedef struct EcsComponentsResultEx
 } EcsComponentsResultEx;
 //int sizeofComponentsResultEx = sizeof(EcsComponentsResultEx); // default 4088
 
+/// @brief read-only copy of one snapshotted component array of one archetype, see ecsPublishSnapshot
+typedef struct EcsSnapshotColumn
+{
+    uint archetypeId;
+    uint componentId;
+    uint entityCount;
+    uint entityCapacity;
+    size_t stride;
+    uint fieldSize; // layout matches EcsComponentArray
+    byte* components;
+    uint* entityIds;
+} EcsSnapshotColumn;
+
+/// @brief a consistent published frame of all snapshot columns
+typedef struct EcsSnapshotFrame
+{
+    EcsSnapshotColumn* columns;
+    uint columnCount;
+    uint columnCapacity;
+    uint frame; // publish count when this frame was published
+} EcsSnapshotFrame;
+
+/// @brief writer side chunk tracking of a snapshot column
+/// bit n of a chunk is set when the chunk changed since last published to frame n, bit 2 since the last ecsEncodeDelta
+typedef struct EcsSnapshotTracker
+{
+    uint archetypeId;
+    uint componentId;
+    byte* chunks;
+    uint chunkCapacity;
+} EcsSnapshotTracker;
+
+/// @brief copy of a column as of the last encoded or applied delta, see ecsEncodeDelta
+typedef struct EcsDeltaBaseline
+{
+    byte* data;
+    size_t size;
+} EcsDeltaBaseline;
+
+/// @brief a function run once per ecsRunSystems over a query, see ecsCreateSystem
+typedef struct EcsSystem
+{
+    EcsSystemCallback callback;
+    void* userData;
+    uint queryId;
+    uint unused;
+    uint64_t reads[ECS_COMPONENT_MASK_WORDS];
+    uint64_t writes[ECS_COMPONENT_MASK_WORDS];
+    uint64_t timeNs; // duration of the last run
+} EcsSystem;
+
 typedef struct EcsInstance
 {
+    const struct CAllocator* Allocator; // every array of the instance, callocatorDefault() at ecsCreateInstance
+
     struct ArchetypeContainer_T
     {
         EcsArchetypeSignature* signatures;
         EcsArchetype* archetypes;
         uint count;
         uint capacity;
+        uint compactIndex; // next archetype visited by ecsCompact
     } ArchetypeContainer;
 
     struct EntityContainer_T
     {
-        EcsEntity* entities;
+        EcsEntity* entities; // hot, indexed by entityId
+        EcsEntityInfo* infos; // cold, parallel to entities
         uint count;
         uint capacity;
     } EntityContainer;
@@ -219,6 +429,7 @@ typedef struct EcsInstance
     struct QueryContainer_T
     {
         EcsQuery* queries;
+        EcsQueryColumnTable* columnTables; // parallel to queries
         uint count;
         uint capacity;
     } QueryContainer;
@@ -230,9 +441,89 @@ typedef struct EcsInstance
         uint capacity;
     } QueryIteratorContainer;
 
+    struct SnapshotContainer_T
+    {
+        EcsSnapshotFrame frames[2];
+        EcsSnapshotTracker* trackers; // parallel to columns of frames
+        uint count;
+        uint capacity;
+        uint frame; // publish count
+        volatile uint front; // frame acquired by readers
+        volatile uint readers[2]; // reader count of each frame
+        byte components[ECS_MAX_COMPONENT_TYPES]; // 1 for snapshotted component ids
+    } SnapshotContainer;
+
+    struct DeltaContainer_T
+    {
+        uint enabled;
+        uint depth; // nonzero inside a recorded call or ecsApplyDelta, nested structural changes are not recorded
+        uint frame; // number of deltas encoded or applied
+        uint eventCount; // uints of structural events since the last encode
+        uint eventCapacity;
+        uint* events;
+        byte* buffer; // output of ecsEncodeDelta
+        size_t bufferCapacity;
+        EcsDeltaBaseline* columns; // parallel to snapshot trackers
+        uint columnCapacity;
+        EcsDeltaBaseline sparse[ECS_MAX_COMPONENT_TYPES]; // dense components of sparse sets, indexed by componentId
+    } DeltaContainer;
+
+    struct SystemContainer_T
+    {
+        EcsSystem* systems;
+        uint count;
+        uint capacity;
+        struct EcsScheduler* scheduler; // thread pool, see ecsCreateSystemThreads
+    } SystemContainer;
+
+    struct SparseContainer_T
+    {
+        EcsSparseSet* sets; // indexed by componentId, allocated by the first ecsCreateSparseComponent
+        uint ids[ECS_MAX_COMPONENT_TYPES]; // sparse stored component ids
+        uint count;
+        byte components[ECS_MAX_COMPONENT_TYPES]; // 1 for sparse stored component ids
+    } SparseContainer;
+
+    struct FileContainer_T
+    {
+        const byte* data; // copy-on-write mapping of the file loaded by ecsLoadInstance, kept for the lifetime of the instance
+        size_t size;
+    } FileContainer;
+
+    struct ScratchContainer_T
+    {
+        uint64_t* keys; // ecsDestroyEntities sort keys
+        uint capacity;
+    } ScratchContainer;
+
+    struct GrowthContainer_T
+    {
+        size_t stepBytes; // bytes migrated per ecsStepIncrementalGrowth, 0 when archetypes grow at once
+        uint migratingCount; // archetypes with rows left in their previous columns
+    } GrowthContainer;
+
+    struct ProfileContainer_T
+    {
+        uint* archetypePeaks; // peak entity count of archetypes by archetypeId, from ecsLoadCapacityProfile
+        uint archetypeCount;
+        uint entityPeak; // from ecsLoadCapacityProfile
+        uint entityGrowthCount;
+        uint sparsePeaks[ECS_MAX_COMPONENT_TYPES]; // peak count of sparse sets by componentId, from ecsLoadCapacityProfile
+    } ProfileContainer;
+
+    struct RealtimeContainer_T
+    {
+        uint enabled;
+        uint allocationCount; // allocations since ecsBeginRealtime
+    } RealtimeContainer;
+
 } EcsInstance;
 
 EcsEntity* ecsGetEntity(EcsInstance* instance, uint entityId);
+EcsEntityInfo* ecsGetEntityInfo(EcsInstance* instance, uint entityId);
+/// @brief disabled entities keep their archetype and components but are skipped by query iteration and export
+void ecsSetEntityEnabled(EcsInstance* instance, uint entityId, uint bEnabled);
+uint ecsIsEntityEnabled(EcsInstance* instance, uint entityId);
 EcsArchetype* ecsGetArchetype(EcsInstance* instance, uint archetypeId);
 EcsArchetype* ecsGetArchetypeFromEntity(EcsInstance* instance, const EcsEntity* entity);
 EcsArchetype* ecsGetArchetypeFromEntityId(EcsInstance* instance, uint entityId);
@@ -242,8 +533,14 @@ void* ecsGetComponentFromArchetypeId(EcsInstance* instance, uint archetypeId, ui
 void* ecsGetComponentFromEntityId(EcsInstance* instance, uint entityId, uint componentTypeId);
 void ecsGetComponentsFromEntityId(EcsInstance* instance, EcsComponentsResult* dst, uint entityId);
 void ecsGetComponentsFromEntityIdEx(EcsInstance* instance, EcsComponentsResultEx* dst, uint entityId);
+
+/// @brief copy a component to or from a packed struct, for both AoS and AoSoA component arrays
+/// component pointers of AoSoA arrays point to the first field, the next field is ECS_AOSOA_LANES * fieldSize bytes after
+void ecsLoadComponentFromEntityId(EcsInstance* instance, uint entityId, uint componentTypeId, void* dst);
+void ecsStoreComponentToEntityId(EcsInstance* instance, uint entityId, uint componentTypeId, const void* src);
 EcsQuery* ecsGetQuery(EcsInstance* instance, uint queryId);
 
+/// @brief arrays of the instance are allocated with callocatorDefault() at creation, see CAllocator.h
 EcsInstance ecsCreateInstance();
 
 /// @brief creates a query for iterating components in all applicable archetypes
@@ -267,12 +564,35 @@ EcsQueryIterator ecsCreateQueryIterator(EcsInstance* instance, uint queryId);
 EcsQueryIterator* ecsIterateQuery(EcsQueryIterator* itr, void** componentsArray);
 EcsQueryIterator* ecsIterateQueryEx(EcsQueryIterator* itr, uint* entityId, void** componentsArray);
 
+/// @brief iterate all archetypes of a query, one block of up to ECS_AOSOA_LANES entities at a time
+/// AoSoA components: pointer to the block, field f of lane l at (byte*)ptr + (f * ECS_AOSOA_LANES + l) * fieldSize
+/// AoS components: pointer to the first of laneCount contiguous components
+/// blocks are aligned to ECS_AOSOA_LANES * stride bytes, 32 byte aligned for strides that are a multiple of 4
+/// queries with sparse components can not be block iterated
+/// blocks with no enabled entity are skipped, disabled lanes are cleared in itr->laneMask
+/// do not mix with ecsIterateQuery on the same iterator
+/// @param laneCount: number of valid entities in the block, lanes past laneCount are unused data
+/// @return EcsQueryIterator*: the valid iterator pointer, or NULL when the query has ended
+EcsQueryIterator* ecsIterateQueryBlock(EcsQueryIterator* itr, uint* laneCount, void** componentsArray);
+
 /// @brief iterate all entities that match query, executing callback per entity
 /// @param queryId: created with ecsCreateQuery
 /// @param callback function to execute per entity for components in query
 void ecsIterateQueryCallback  (EcsInstance* instance, uint queryId, EcsQueryCallback   callback);
 void ecsIterateQueryCallbackEx(EcsInstance* instance, uint queryId, EcsQueryCallbackEx callback);
 
+/// @brief number of entities that match a query, rows needed by ecsExportQuery
+uint ecsGetQueryEntityCount(EcsInstance* instance, uint queryId);
+
+/// @brief copy the components of all entities that match a query into contiguous columns, archetype by archetype
+/// row n of every column belongs to the same entity, components are packed structs (AoSoA components are converted)
+/// dense columns are copied with non-temporal stores, the exported data is not left in the cache
+/// @param columns: one destination per query component in query order, capacity * sizeofComponent bytes each, NULL to skip
+/// @param entityIds: destination of capacity entity ids, or NULL
+/// @param capacity: rows available in the destinations, see ecsGetQueryEntityCount
+/// @return number of rows written
+uint ecsExportQuery(EcsInstance* instance, uint queryId, void** columns, uint* entityIds, uint capacity);
+
 /// @brief create an archetype, a collection of components which entities are assigned to
 /// @param componentCount: number of component args
 /// @param ...: componentId, sizeofComponent, ...
@@ -285,9 +605,27 @@ uint ecsCreateArchetype(EcsInstance* instance, uint componentCount, EcsComponent
 /// @return entityId
 uint ecsCreateEntity(EcsInstance* instance, uint archetypeId);
 
+/// @brief destroy an entity, the last entity of its archetype is moved into the removed slot
+/// the destroyed entity keeps its entityId, with archetypeId and componentsId set to ECS_INVALID_ID
 void ecsDestroyEntity(EcsInstance* instance, uint entityId);
 
+/// @brief destroy many entities at once, grouped by archetype
+/// each component array of an archetype is compacted in a single pass, filling removed slots from the end
+/// destroyed or invalid entityIds are ignored
+/// @param entityCount: number of entityIds
+/// @param entityIds: entities to destroy, in any order
+void ecsDestroyEntities(EcsInstance* instance, uint entityCount, const uint* entityIds);
+
+/// @brief incremental compaction, appropriate to call once per frame
+/// shrinks archetypes using less than ECS_COMPACT_SHRINK_LOAD percent of capacity to ECS_COMPACT_TARGET_LOAD percent
+/// frees all storage of archetypes with no entities and removes them from queries
+/// freed archetypes keep their archetypeId, storage is reallocated by the next ecsCreateEntity
+/// @param archetypeBudget: max number of archetypes visited by this call, resumes where the last call ended. 0 visits all
+/// @return number of archetypes shrunk or freed
+uint ecsCompact(EcsInstance* instance, uint archetypeBudget);
+
 /// @brief add a component to entity - if new signiture, results in allocating new archetype and moving data
+/// sparse stored components are added with ecsAddSparseComponent instead, without moving data
 /// @param instance
 /// @param entityId
 /// @param componentId 
@@ -295,13 +633,151 @@ void ecsDestroyEntity(EcsInstance* instance, uint entityId);
 void ecsAddComponentToEntity(EcsInstance* instance, uint entityId, uint componentId, size_t sizeofComponent);
 
 
+/// @brief store a component id in a sparse set instead of archetypes, for components added and removed often (ex. Stunned, HitThisFrame)
+/// adding and removing is O(1) and never moves the entity's archetype row
+/// queries join archetype components with sparse components per entity, entities without the sparse components are skipped
+/// register before creating archetypes or queries with the component id. sparse components can not be snapshotted or block iterated
+void ecsCreateSparseComponent(EcsInstance* instance, uint componentId, size_t sizeofComponent);
+
+/// @brief add a sparse component to an entity, returns the component, zeroed when newly added
+void* ecsAddSparseComponent(EcsInstance* instance, uint entityId, uint componentId);
+/// @brief remove a sparse component from an entity, the last component of the set is moved into the removed slot
+/// no effect if the entity does not have the component
+void ecsRemoveSparseComponent(EcsInstance* instance, uint entityId, uint componentId);
+/// @brief the sparse component of an entity, or NULL if the entity does not have the component
+void* ecsGetSparseComponent(EcsInstance* instance, uint entityId, uint componentId);
+/// @brief the set of a sparse component, for iterating all of its components densely
+EcsSparseSet* ecsGetSparseSet(EcsInstance* instance, uint componentId);
+
+/// @brief double buffered snapshots for concurrent readers, ex. a render thread
+/// the writer thread publishes once per frame, copying only chunks of ECS_SNAPSHOT_CHUNK_ENTITIES written since the frame was last published
+/// readers acquire the latest published frame and iterate its columns without locks while the writer continues
+///
+/// writer: write components... ecsMarkSnapshotWritten(...); ecsPublishSnapshot(&instance);
+/// reader: uint f; const EcsSnapshotFrame* frame = ecsAcquireSnapshot(&instance, &f); ...read frame->columns... ecsReleaseSnapshot(&instance, f);
+
+/// @brief snapshot a component id in all archetypes, current and future
+void ecsEnableSnapshot(EcsInstance* instance, uint componentId);
+
+/// @brief mark a component written through a pointer, for the next publish
+/// structural changes (create, destroy, add component) and ecsStoreComponentToEntityId are tracked automatically
+void ecsMarkSnapshotWritten(EcsInstance* instance, uint entityId, uint componentId);
+void ecsMarkSnapshotArchetypeWritten(EcsInstance* instance, uint archetypeId, uint componentId);
+
+/// @brief publish changed chunks to the back frame and make it the front frame, writer thread only
+/// @return 1 if published, 0 if deferred because readers still hold the back frame (changes are kept for the next publish)
+uint ecsPublishSnapshot(EcsInstance* instance);
+
+/// @brief acquire the latest published frame for reading, any thread, must be released
+/// @param frameIndex: destination for the frame index passed to ecsReleaseSnapshot
+const EcsSnapshotFrame* ecsAcquireSnapshot(EcsInstance* instance, uint* frameIndex);
+void ecsReleaseSnapshot(EcsInstance* instance, uint frameIndex);
+
+/// @brief frame to frame deltas of the whole instance, for replay recording and rollback
+/// a delta holds the structural changes (entities created and destroyed, archetypes created, components added) in call order,
+/// and the XOR of every chunk of ECS_SNAPSHOT_CHUNK_ENTITIES changed since the last delta against its baseline, run-length encoded
+/// changes are tracked like snapshots: writes through pointers must be marked with ecsMarkSnapshotWritten or ecsMarkSnapshotArchetypeWritten
+///
+/// encoder and decoder start from the same state (ex. empty, or the same ecsLoadInstance file), with the same sparse components and queries,
+/// and both call ecsEnableDelta before the first change. deltas are applied in the order they were encoded
+/// an instance either encodes or applies deltas
+///
+/// encoder: ... frame changes ... size_t size; const void* delta = ecsEncodeDelta(&instance, &size); record or send delta
+/// decoder: ecsApplyDelta(&replica, delta, size);
+
+/// @brief start recording structural changes and tracking all components, call after ecsCreateSparseComponent
+void ecsEnableDelta(EcsInstance* instance);
+/// @brief encode changes since the last encode, the returned buffer is valid until the next call
+/// @param size: destination for the size in bytes of the delta
+const void* ecsEncodeDelta(EcsInstance* instance, size_t* size);
+/// @brief apply a delta from ecsEncodeDelta, the instance must be at the frame the delta was encoded from
+/// @return 1 on success, 0 if the delta is for another frame or malformed (the instance may be partially updated)
+uint ecsApplyDelta(EcsInstance* instance, const void* delta, size_t size);
+/// @brief number of deltas encoded or applied
+uint ecsGetDeltaFrame(EcsInstance* instance);
+
+/// @brief register a system, run by ecsRunSystems in registration order unless it has no read/write conflicts
+/// systems conflict when one writes a component the other reads or writes, conflicting systems never run concurrently
+/// query components are implicitly read. systems must not create or destroy entities, or add components
+/// @param queryId: passed to callback, created with ecsCreateQuery
+/// @param readIds/writeIds: component ids read and written by the system
+/// @return systemId
+uint ecsCreateSystem(EcsInstance* instance, uint queryId, EcsSystemCallback callback, void* userData,
+    uint readCount, const uint* readIds, uint writeCount, const uint* writeIds);
+
+/// @brief start worker threads for ecsRunSystems, the calling thread also runs systems
+/// without worker threads ecsRunSystems runs all systems on the calling thread
+/// @return number of threads started, less than threadCount if the os failed to create some
+uint ecsCreateSystemThreads(EcsInstance* instance, uint threadCount);
+void ecsDestroySystemThreads(EcsInstance* instance);
+
+/// @brief run every system once, returns when all have finished
+/// dependencies are rebuilt from read/write sets each call, non-conflicting systems run concurrently
+void ecsRunSystems(EcsInstance* instance);
+
+/// @brief duration in nanoseconds of the last run of a system
+uint64_t ecsGetSystemTime(EcsInstance* instance, uint systemId);
+
+/// @brief grow large archetypes without copying all their columns at once, so spawn heavy frames do not spike
+/// a full archetype of at least ECS_INCREMENTAL_GROWTH_MIN_BYTES allocates its new columns and keeps the old ones,
+/// rows are then moved to the new columns by ecsStepIncrementalGrowth. reads and writes of rows not yet moved use the old columns
+/// an archetype that fills again before its rows were moved, save, ecsBeginRealtime and ecsApplyDelta move the remaining rows at once
+/// @param stepBytes: bytes of rows moved per ecsStepIncrementalGrowth, 0 grows at once (remaining rows are moved now)
+void ecsEnableIncrementalGrowth(EcsInstance* instance, size_t stepBytes);
+/// @brief move rows of growing archetypes to their new columns, appropriate to call once per frame
+/// @return number of archetypes with rows left to move
+uint ecsStepIncrementalGrowth(EcsInstance* instance);
+
+/// @brief reserve capacity up front so that creation does not allocate, no effect if capacity is already larger
+/// @param newCapacity: number of archetypes, entities, or queries that can be created without allocation
+void ecsReserveArchetypeCapacity(EcsInstance* instance, uint newCapacity);
+void ecsReserveEntityCapacity(EcsInstance* instance, uint newCapacity);
+void ecsReserveQueryCapacity(EcsInstance* instance, uint newCapacity);
+/// @param newCapacity: number of entities the archetype can hold without allocation
+void ecsReserveArchetypeEntityCapacity(EcsInstance* instance, uint archetypeId, uint newCapacity);
+/// @param newCapacity: number of entityIds ecsDestroyEntities can take without allocation
+void ecsReserveDestroyCapacity(EcsInstance* instance, uint newCapacity);
+/// @param newCapacity: number of entities that can have the sparse component without allocation, the sparse index covers all reserved entities
+void ecsReserveSparseCapacity(EcsInstance* instance, uint componentId, uint newCapacity);
+
+/// @brief enter real-time mode, call after reserving and before the first frame
+/// prefaults and locks all reserved memory into RAM (mlock / VirtualLock), so the hot path does not page fault
+/// every allocation made in real-time mode is counted, and asserts if ECS_REALTIME_ASSERT is 1
+/// @return 1 if all memory was locked, 0 if locking failed for any allocation (ex. RLIMIT_MEMLOCK), memory is prefaulted regardless
+uint ecsBeginRealtime(EcsInstance* instance);
+/// @brief leave real-time mode, unlocking memory
+void ecsEndRealtime(EcsInstance* instance);
+/// @brief number of allocations since ecsBeginRealtime, 0 means bounded by reserved memory
+uint ecsGetRealtimeAllocationCount(EcsInstance* instance);
+
+/// @brief save entities, archetype signatures and columns, queries and sparse components to a file
+/// each array is written as in memory up to its capacity, starting at an ECS_FILE_ALIGNMENT aligned offset
+/// snapshots and systems are not saved, enable and create them again after loading
+/// @return 1 on success, 0 if the file could not be written
+uint ecsSaveInstance(EcsInstance* instance, const char* path);
+/// @brief load a file saved by ecsSaveInstance into a new instance from ecsCreateInstance
+/// the file is mapped copy-on-write and entities and archetype columns are used in place, only pointers are fixed up
+/// pages are read on first access, columns are copied out of the mapping when they grow. writes never reach the file
+/// entityIds, archetypeIds and queryIds are the same as when saved
+/// @return 1 on success, 0 if the file could not be read or was saved with a different configuration
+uint ecsLoadInstance(EcsInstance* instance, const char* path);
+
+/// @brief capacity profile of a run, so that the next run is sized up front instead of growing while warming up
+/// records the peak count of entities, archetypes, queries, every archetype and sparse set, and the destroy scratch, and how often they grew
+/// written as a CCapacityProfile text file, one "key peak growths" line per container. the top byte of a key is the kind of container:
+/// 1 entities, 2 archetypes, 3 queries, 4 destroy scratch, 5 archetype and 6 sparse set, with the archetypeId or componentId below it.
+/// peaks of a loaded profile are kept if larger, so profiles accumulate over runs
+/// @return 1 on success, 0 if the file could not be written
+uint ecsSaveCapacityProfile(EcsInstance* instance, const char* path);
+/// @brief load a profile from ecsSaveCapacityProfile into a new instance, before creating archetypes and sparse components
+/// entities, archetypes, queries and the destroy scratch are reserved now. archetypes and sparse sets are created at their recorded peak,
+/// matched by archetypeId and componentId, and archetypes freed by ecsCompact are reallocated at their peak
+/// @return 1 on success, 0 if the file could not be read or is malformed
+uint ecsLoadCapacityProfile(EcsInstance* instance, const char* path);
+
 // TODO -- below -- nice to have quality of life functions
 // void ecsRemoveComponentFromEntity(EcsInstance* instance, uint entityId, uint componentId);
 // uint ecsCreateEntities(uint archetypeId, uint count);
-// void ecsReserveArchetypeCapacity(uint newCapacity);
-// void ecsReserveEntityCapacity(uint newCapacity);
-// void ecsReserveArchetypeEntityCapacity(uint newCapacity);
-// void ecsReserveQueryCapacity(uint newCapacity);
 
 #ifdef __cplusplus
 }
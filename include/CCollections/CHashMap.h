@@ -0,0 +1,521 @@
+// MIT License - CCollections
+// Copyright(c) 2020 Dante Falcone (dantefalcone@gmail.com)
+#pragma once
+#include "CTypes.h"
+#include "CAllocator.h"
+#include "CSimd.h"
+#include <string.h>
+#include <assert.h>
+
+/*  CHashMap
+
+    Open addressing hash map of fixed stride keys and values, keys are hashed and compared as raw bytes
+    Swiss table layout - one control byte per slot holds 7 bits of the key hash, a group of 16 slots is matched with one SSE2 compare
+    Deletion is tombstone free - each group counts the keys that probed past it and lookups stop at the first group no key passed,
+    so removed slots are simply emptied and insert / remove churn never lengthens probes or forces a rehash
+    Range insert and find hash a batch of keys and prefetch their groups before probing any of them
+    Each slot is a key followed by its value, so a hit touches one control and one slot cache line - pad keys to keep values aligned
+    Pointers to values are valid until the map grows
+*/
+
+#define CHASHMAP_GROUP_WIDTH 16
+// control byte of an empty slot, full slots hold the low 7 bits of the key hash
+#define CHASHMAP_EMPTY 0x80
+
+#ifndef CHASHMAP_MAX_LOAD_NUMERATOR
+// the map grows when Count would pass Capacity * numerator / denominator
+#define CHASHMAP_MAX_LOAD_NUMERATOR 7
+#define CHASHMAP_MAX_LOAD_DENOMINATOR 8
+#endif // !CHASHMAP_MAX_LOAD_NUMERATOR
+
+#ifndef CHASHMAP_BATCH
+// keys hashed and prefetched ahead of probing by the range functions
+#define CHASHMAP_BATCH 16
+#endif // !CHASHMAP_BATCH
+
+#if defined(CSIMD_X86)
+    #define CHASHMAP_PREFETCH(address) _mm_prefetch((const char*)(address), _MM_HINT_T0)
+#elif defined(__GNUC__) || defined(__clang__)
+    #define CHASHMAP_PREFETCH(address) __builtin_prefetch(address)
+#else
+    #define CHASHMAP_PREFETCH(address)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+// room for capacity keys before the map grows, valueStride may be 0 for a set
+static inline void chashmapAlloc(CHashMap* map, CSize keyStride, CSize valueStride, CSize capacity);
+// allocate from allocator instead of the default, NULL for the built-in aligned heap
+static inline void chashmapAllocEx(CHashMap* map, CSize keyStride, CSize valueStride, CSize capacity, const CAllocator* allocator);
+static inline void chashmapFree(CHashMap* map);
+static inline void chashmapClear(CHashMap* map);
+// grow only if count keys would not fit - use before time critical sections to avoid allocation
+static inline void chashmapReserve(CHashMap* map, CSize count);
+// hash of every key, size bytes
+static inline uint64_t chashmapHash(const void* key, size_t size);
+// value of key, NULL if not found
+static inline void* chashmapFind(CHashMap* map, const void* key);
+// add key or overwrite its value - value NULL zeroes added values and keeps existing ones
+// key and value must not point into the map - returns 1 if key was added
+static inline uint32_t chashmapInsert(CHashMap* map, const void* key, const void* value);
+// value of key, added with a zeroed value if not found
+static inline void* chashmapFindOrAdd(CHashMap* map, const void* key);
+// returns 1 if key was found and removed
+static inline uint32_t chashmapRemove(CHashMap* map, const void* key);
+// insert itemsCount keys and values, values may be NULL as in chashmapInsert
+// room for all keys is reserved up front - returns number of keys added
+static inline CSize chashmapInsertRange(CHashMap* map, const void* keys, const void* values, CSize itemsCount);
+// value of each key to values, NULL for keys not found - returns number found
+static inline CSize chashmapFindRange(CHashMap* map, const void* keys, CSize itemsCount, void** values);
+// first full slot at or after index, Capacity if none - iterate from 0 with chashmapKeyAt and chashmapValueAt
+static inline CSize chashmapNext(CHashMap* map, CSize index);
+static inline void* chashmapKeyAt(CHashMap* map, CSize index);
+static inline void* chashmapValueAt(CHashMap* map, CSize index);
+
+
+
+//=======================================================================
+// control bytes
+
+// bit i set where group control byte i equals h2
+static inline uint32_t chashmapMatch(const uint8_t* group, uint32_t h2)
+{
+#if defined(CSIMD_X86)
+    const __m128i ctrl = _mm_load_si128((const __m128i*)group);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)h2)));
+#else
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < CHASHMAP_GROUP_WIDTH; ++i)
+    {
+        mask |= (uint32_t)(group[i] == h2) << i;
+    }
+    return mask;
+#endif
+}
+
+// bit i set where group slot i is empty - only empty control bytes have the high bit
+static inline uint32_t chashmapMatchEmpty(const uint8_t* group)
+{
+#if defined(CSIMD_X86)
+    return (uint32_t)_mm_movemask_epi8(_mm_load_si128((const __m128i*)group));
+#else
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < CHASHMAP_GROUP_WIDTH; ++i)
+    {
+        mask |= (uint32_t)(group[i] >> 7) << i;
+    }
+    return mask;
+#endif
+}
+
+static inline size_t chashmapGroupMask(CHashMap* map)
+{
+    return (size_t)map->Base.Capacity / CHASHMAP_GROUP_WIDTH - 1;
+}
+
+// home group from the hash bits above h2, groups are then probed triangularly - home + 1, + 3, + 6 ...
+// which visits every group once when the group count is a power of 2
+static inline size_t chashmapHomeGroup(uint64_t hash, size_t groupMask)
+{
+    return (size_t)(hash >> 7) & groupMask;
+}
+
+//=======================================================================
+// hashing
+
+static inline uint64_t chashmapMix(uint64_t x)
+{
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDull;
+    x ^= x >> 33;
+    x *= 0xC4CEB9FE1A85EC53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+uint64_t chashmapHash(const void* key, size_t size)
+{
+    const uint8_t* bytes = (const uint8_t*)key;
+    uint64_t hash = (uint64_t)size * 0x9E3779B97F4A7C15ull;
+    uint64_t word = 0;
+    if (size == 8)
+    {
+        memcpy(&word, bytes, 8);
+        return chashmapMix(hash ^ word);
+    }
+    if (size == 4)
+    {
+        uint32_t word32;
+        memcpy(&word32, bytes, 4);
+        return chashmapMix(hash ^ word32);
+    }
+    for (; size >= 8; size -= 8, bytes += 8)
+    {
+        memcpy(&word, bytes, 8);
+        hash ^= word * 0x87C37B91114253D5ull;
+        hash = ((hash << 31) | (hash >> 33)) * 0x4CF5AD432745937Full;
+    }
+    if (size)
+    {
+        word = 0;
+        memcpy(&word, bytes, size);
+        hash ^= word * 0x87C37B91114253D5ull;
+    }
+    return chashmapMix(hash);
+}
+
+static inline uint32_t chashmapKeyEqual(const uint8_t* a, const void* b, size_t size)
+{
+    if (size == 8)
+    {
+        uint64_t x, y;
+        memcpy(&x, a, 8);
+        memcpy(&y, b, 8);
+        return x == y;
+    }
+    if (size == 4)
+    {
+        uint32_t x, y;
+        memcpy(&x, a, 4);
+        memcpy(&y, b, 4);
+        return x == y;
+    }
+    return memcmp(a, b, size) == 0;
+}
+
+//=======================================================================
+// storage - control bytes, per group overflow counts and slots in one allocation
+
+static inline size_t chashmapAlignSize(size_t size)
+{
+    return (size + CCOLLECTIONS_CACHE_LINE_ALIGNMENT - 1) & ~(size_t)(CCOLLECTIONS_CACHE_LINE_ALIGNMENT - 1);
+}
+
+static inline size_t chashmapSlotsOffset(CSize capacity)
+{
+    return chashmapAlignSize((size_t)capacity + capacity / CHASHMAP_GROUP_WIDTH);
+}
+
+static inline size_t chashmapSizeOf(CSize capacity, CSize stride)
+{
+    return chashmapSlotsOffset(capacity) + (size_t)capacity * stride;
+}
+
+// slots for count keys at the max load factor
+static inline CSize chashmapRoundCapacity(CSize count)
+{
+    size_t capacity = CHASHMAP_GROUP_WIDTH;
+    while (capacity * CHASHMAP_MAX_LOAD_NUMERATOR / CHASHMAP_MAX_LOAD_DENOMINATOR < count)
+    {
+        capacity *= 2;
+    }
+    assert(capacity <= CCOLLECTIONS_SIZE_MAX && "CHashMap capacity out of range");
+    return (CSize)capacity;
+}
+
+static inline void chashmapAllocSlots(CHashMap* map, CSize capacity)
+{
+    const size_t size = chashmapSizeOf(capacity, map->Base.Stride);
+    map->Base.Data = (uint8_t*)callocatorAlloc(map->Base.Allocator, size);
+    assert(map->Base.Data);
+    map->Base.Capacity = capacity;
+    map->Overflow = map->Base.Data + capacity;
+    map->Slots = map->Base.Data + chashmapSlotsOffset(capacity);
+    map->GrowthLimit = (CSize)((size_t)capacity * CHASHMAP_MAX_LOAD_NUMERATOR / CHASHMAP_MAX_LOAD_DENOMINATOR);
+    chashmapClear(map);
+}
+
+static inline void chashmapFreeSlots(CHashMap* map)
+{
+    callocatorFree(map->Base.Allocator, map->Base.Data, chashmapSizeOf(map->Base.Capacity, map->Base.Stride));
+}
+
+//=======================================================================
+// probing
+
+// slot of key, (size_t)-1 if not found
+static inline size_t chashmapFindSlot(CHashMap* map, const void* key, uint64_t hash)
+{
+    const size_t groupMask = chashmapGroupMask(map);
+    const size_t stride = map->Base.Stride;
+    const uint32_t h2 = (uint32_t)(hash & 0x7F);
+    size_t group = chashmapHomeGroup(hash, groupMask);
+    for (size_t step = 1; step <= groupMask + 1; ++step)
+    {
+        uint32_t match = chashmapMatch(map->Base.Data + group * CHASHMAP_GROUP_WIDTH, h2);
+        while (match)
+        {
+            const size_t slot = group * CHASHMAP_GROUP_WIDTH + csimdCtz64(match);
+            if (chashmapKeyEqual(map->Slots + slot * stride, key, map->KeyStride))
+            {
+                return slot;
+            }
+            match &= match - 1;
+        }
+        if (map->Overflow[group] == 0)
+        {
+            break;
+        }
+        group = (group + step) & groupMask;
+    }
+    return (size_t)-1;
+}
+
+// claim the first empty slot on the probe of hash, counting the groups passed - key must not be in the map and a slot must be free
+static inline size_t chashmapClaimSlot(CHashMap* map, uint64_t hash)
+{
+    const size_t groupMask = chashmapGroupMask(map);
+    size_t group = chashmapHomeGroup(hash, groupMask);
+    for (size_t step = 1;; ++step)
+    {
+        const uint32_t empty = chashmapMatchEmpty(map->Base.Data + group * CHASHMAP_GROUP_WIDTH);
+        if (empty)
+        {
+            const size_t slot = group * CHASHMAP_GROUP_WIDTH + csimdCtz64(empty);
+            map->Base.Data[slot] = (uint8_t)(hash & 0x7F);
+            ++map->Base.Count;
+            return slot;
+        }
+        if (map->Overflow[group] != 0xFF)
+        {
+            ++map->Overflow[group];
+        }
+        group = (group + step) & groupMask;
+    }
+}
+
+// empty slot and uncount the groups its key probed past - saturated counts stay until the next rehash
+static inline void chashmapReleaseSlot(CHashMap* map, size_t slot, uint64_t hash)
+{
+    const size_t groupMask = chashmapGroupMask(map);
+    const size_t slotGroup = slot / CHASHMAP_GROUP_WIDTH;
+    size_t group = chashmapHomeGroup(hash, groupMask);
+    for (size_t step = 1; group != slotGroup; ++step)
+    {
+        if (map->Overflow[group] != 0xFF)
+        {
+            --map->Overflow[group];
+        }
+        group = (group + step) & groupMask;
+    }
+    map->Base.Data[slot] = CHASHMAP_EMPTY;
+    --map->Base.Count;
+}
+
+static inline void chashmapRehash(CHashMap* map, CSize capacity)
+{
+    CHashMap old = *map;
+    chashmapAllocSlots(map, capacity);
+    const size_t stride = map->Base.Stride;
+    for (CSize index = chashmapNext(&old, 0); index < old.Base.Capacity; index = chashmapNext(&old, index + 1))
+    {
+        const uint8_t* item = old.Slots + (size_t)index * stride;
+        const size_t slot = chashmapClaimSlot(map, chashmapHash(item, map->KeyStride));
+        memcpy(map->Slots + slot * stride, item, stride);
+    }
+    chashmapFreeSlots(&old);
+}
+
+// slot of key, claimed if not found - bAdded set to 1 if claimed
+static inline size_t chashmapFindOrClaimSlot(CHashMap* map, const void* key, uint64_t hash, uint32_t* bAdded)
+{
+    size_t slot = chashmapFindSlot(map, key, hash);
+    *bAdded = slot == (size_t)-1;
+    if (*bAdded)
+    {
+        if (map->Base.Count >= map->GrowthLimit)
+        {
+            chashmapRehash(map, map->Base.Capacity * 2);
+        }
+        slot = chashmapClaimSlot(map, hash);
+        memcpy(map->Slots + slot * map->Base.Stride, key, map->KeyStride);
+    }
+    return slot;
+}
+
+static inline uint32_t chashmapInsertHashed(CHashMap* map, const void* key, const void* value, uint64_t hash)
+{
+    uint32_t bAdded;
+    const size_t slot = chashmapFindOrClaimSlot(map, key, hash, &bAdded);
+    uint8_t* dst = map->Slots + slot * map->Base.Stride + map->KeyStride;
+    if (value)
+    {
+        memcpy(dst, value, map->ValueStride);
+    }
+    else if (bAdded)
+    {
+        memset(dst, 0, map->ValueStride);
+    }
+    return bAdded;
+}
+
+// hash the batch of keys from first and prefetch the control bytes and first slots of their home groups
+static inline void chashmapHashBatch(CHashMap* map, const uint8_t* keys, CSize itemsCount, CSize first, uint64_t* hashes)
+{
+    const size_t groupMask = chashmapGroupMask(map);
+    const size_t keyStride = map->KeyStride;
+    const CSize count = first >= itemsCount ? 0 : itemsCount - first < CHASHMAP_BATCH ? itemsCount - first : CHASHMAP_BATCH;
+    for (CSize i = 0; i < count; ++i)
+    {
+        hashes[i] = chashmapHash(keys + ((size_t)first + i) * keyStride, keyStride);
+        const size_t group = chashmapHomeGroup(hashes[i], groupMask);
+        CHASHMAP_PREFETCH(map->Base.Data + group * CHASHMAP_GROUP_WIDTH);
+        CHASHMAP_PREFETCH(map->Slots + group * CHASHMAP_GROUP_WIDTH * map->Base.Stride);
+    }
+}
+
+//=======================================================================
+// CHashMap
+
+void chashmapAlloc(CHashMap* map, CSize keyStride, CSize valueStride, CSize capacity)
+{
+    chashmapAllocEx(map, keyStride, valueStride, capacity, callocatorDefault());
+}
+
+void chashmapAllocEx(CHashMap* map, CSize keyStride, CSize valueStride, CSize capacity, const CAllocator* allocator)
+{
+    assert(keyStride > 0 && "CHashMap keys must not be empty");
+    memset(map, 0, sizeof(CHashMap));
+    map->KeyStride = keyStride;
+    map->ValueStride = valueStride;
+    map->Base.Stride = keyStride + valueStride;
+    map->Base.Allocator = allocator;
+    map->Base.Type = CCOLLECTION_TYPE_HASHMAP;
+    chashmapAllocSlots(map, chashmapRoundCapacity(capacity));
+}
+
+void chashmapFree(CHashMap* map)
+{
+    chashmapFreeSlots(map);
+}
+
+void chashmapClear(CHashMap* map)
+{
+    const size_t capacity = map->Base.Capacity;
+    memset(map->Base.Data, CHASHMAP_EMPTY, capacity);
+    memset(map->Overflow, 0, capacity / CHASHMAP_GROUP_WIDTH);
+    map->Base.Count = 0;
+}
+
+void chashmapReserve(CHashMap* map, CSize count)
+{
+    if (count > map->GrowthLimit)
+    {
+        chashmapRehash(map, chashmapRoundCapacity(count));
+    }
+}
+
+void* chashmapFind(CHashMap* map, const void* key)
+{
+    const size_t slot = chashmapFindSlot(map, key, chashmapHash(key, map->KeyStride));
+    return slot == (size_t)-1 ? NULL : chashmapValueAt(map, (CSize)slot);
+}
+
+uint32_t chashmapInsert(CHashMap* map, const void* key, const void* value)
+{
+    return chashmapInsertHashed(map, key, value, chashmapHash(key, map->KeyStride));
+}
+
+void* chashmapFindOrAdd(CHashMap* map, const void* key)
+{
+    uint32_t bAdded;
+    const size_t slot = chashmapFindOrClaimSlot(map, key, chashmapHash(key, map->KeyStride), &bAdded);
+    uint8_t* value = (uint8_t*)chashmapValueAt(map, (CSize)slot);
+    if (bAdded)
+    {
+        memset(value, 0, map->ValueStride);
+    }
+    return value;
+}
+
+uint32_t chashmapRemove(CHashMap* map, const void* key)
+{
+    const uint64_t hash = chashmapHash(key, map->KeyStride);
+    const size_t slot = chashmapFindSlot(map, key, hash);
+    if (slot == (size_t)-1)
+    {
+        return 0;
+    }
+    chashmapReleaseSlot(map, slot, hash);
+    return 1;
+}
+
+CSize chashmapInsertRange(CHashMap* map, const void* keys, const void* values, CSize itemsCount)
+{
+    chashmapReserve(map, map->Base.Count + itemsCount);
+    const uint8_t* keyBytes = (const uint8_t*)keys;
+    const uint8_t* valueBytes = (const uint8_t*)values;
+    uint64_t hashes[2][CHASHMAP_BATCH];
+    CSize added = 0;
+    chashmapHashBatch(map, keyBytes, itemsCount, 0, hashes[0]);
+    for (CSize first = 0, batch = 0; first < itemsCount; first += CHASHMAP_BATCH, batch ^= 1)
+    {
+        // next batch is hashed and prefetched while this one probes
+        chashmapHashBatch(map, keyBytes, itemsCount, first + CHASHMAP_BATCH, hashes[batch ^ 1]);
+        const CSize count = itemsCount - first < CHASHMAP_BATCH ? itemsCount - first : CHASHMAP_BATCH;
+        for (CSize i = 0; i < count; ++i)
+        {
+            const size_t item = (size_t)first + i;
+            added += chashmapInsertHashed(map, keyBytes + item * map->KeyStride,
+                valueBytes ? valueBytes + item * map->ValueStride : NULL, hashes[batch][i]);
+        }
+    }
+    return added;
+}
+
+CSize chashmapFindRange(CHashMap* map, const void* keys, CSize itemsCount, void** values)
+{
+    const uint8_t* keyBytes = (const uint8_t*)keys;
+    uint64_t hashes[2][CHASHMAP_BATCH];
+    CSize found = 0;
+    chashmapHashBatch(map, keyBytes, itemsCount, 0, hashes[0]);
+    for (CSize first = 0, batch = 0; first < itemsCount; first += CHASHMAP_BATCH, batch ^= 1)
+    {
+        chashmapHashBatch(map, keyBytes, itemsCount, first + CHASHMAP_BATCH, hashes[batch ^ 1]);
+        const CSize count = itemsCount - first < CHASHMAP_BATCH ? itemsCount - first : CHASHMAP_BATCH;
+        for (CSize i = 0; i < count; ++i)
+        {
+            const size_t item = (size_t)first + i;
+            const size_t slot = chashmapFindSlot(map, keyBytes + item * map->KeyStride, hashes[batch][i]);
+            values[item] = slot == (size_t)-1 ? NULL : chashmapValueAt(map, (CSize)slot);
+            found += slot != (size_t)-1;
+        }
+    }
+    return found;
+}
+
+CSize chashmapNext(CHashMap* map, CSize index)
+{
+    const size_t capacity = map->Base.Capacity;
+    if (index >= capacity)
+    {
+        return (CSize)capacity;
+    }
+    size_t group = index / CHASHMAP_GROUP_WIDTH;
+    uint32_t full = ~chashmapMatchEmpty(map->Base.Data + group * CHASHMAP_GROUP_WIDTH) & (0xFFFFu << (index % CHASHMAP_GROUP_WIDTH));
+    while ((full & 0xFFFF) == 0)
+    {
+        if (++group * CHASHMAP_GROUP_WIDTH >= capacity)
+        {
+            return (CSize)capacity;
+        }
+        full = ~chashmapMatchEmpty(map->Base.Data + group * CHASHMAP_GROUP_WIDTH);
+    }
+    return (CSize)(group * CHASHMAP_GROUP_WIDTH + csimdCtz64(full & 0xFFFF));
+}
+
+void* chashmapKeyAt(CHashMap* map, CSize index)
+{
+    return map->Slots + (size_t)index * map->Base.Stride;
+}
+
+void* chashmapValueAt(CHashMap* map, CSize index)
+{
+    return map->Slots + (size_t)index * map->Base.Stride + map->KeyStride;
+}
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
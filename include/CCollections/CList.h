@@ -2,10 +2,43 @@
 // Copyright(c) 2020 Dante Falcone (dantefalcone@gmail.com)
 #pragma once
 #include "CTypes.h"
+#include "CSimd.h"
+#include "CVirtualMemory.h"
+#include "CAllocator.h"
+#include "CAtomic.h"
 #include <string.h>
 #include <malloc.h>
 #include <assert.h>
 
+#ifndef CLIST_GROWTH_NUMERATOR
+// geometric growth factor of clistEnsureCapacity and the growing adds, numerator / denominator
+// heap lists round capacity up to a power of 2, so factors below 2 only take effect on mapped lists
+#define CLIST_GROWTH_NUMERATOR 2
+#define CLIST_GROWTH_DENOMINATOR 1
+#endif // !CLIST_GROWTH_NUMERATOR
+
+#ifndef CLIST_MAPPED_BYTES
+// lists of at least this capacity in bytes live in virtual memory and grow without copying - 0 to disable
+// only lists on the built-in allocator are mapped
+#define CLIST_MAPPED_BYTES ((size_t)1 << 26)
+#endif // !CLIST_MAPPED_BYTES
+
+#ifndef CLIST_MAPPED_RESERVE_BYTES
+// address space reserved per mapped list where pages cannot be remapped, growing past it copies once
+#if UINTPTR_MAX > 0xFFFFFFFFu
+#define CLIST_MAPPED_RESERVE_BYTES ((size_t)1 << 36)
+#else
+#define CLIST_MAPPED_RESERVE_BYTES ((size_t)1 << 28)
+#endif
+#endif // !CLIST_MAPPED_RESERVE_BYTES
+
+// declares a list with inline storage for capacity items of type, allocate it with clistAllocInline
+// the clist api works on .List as usual, growing past capacity spills the items to the heap
+// an inline list points into its own storage - do not copy it by value before it spills
+#define CLIST_INLINE(type, capacity) struct { CList List; type Inline[capacity]; }
+#define clistAllocInline(inlineList) clistAllocStorage(&(inlineList)->List, (inlineList)->Inline, \
+    (CSize)sizeof((inlineList)->Inline[0]), (CSize)(sizeof((inlineList)->Inline) / sizeof((inlineList)->Inline[0])))
+
 //#if defined(_MSC_VER)
 //#pragma warning(disable:4820)
 //#endif
@@ -18,44 +51,72 @@
 extern "C" {
 #endif // __cplusplus
 
-static inline uint32_t clistSizeOfCapacity(CList* list);
-static inline uint32_t clistSizeOfItems(CList* list);
+// byte sizes are size_t, Stride * Capacity can pass 4 GB even with 32 bit CSize
+static inline size_t clistSizeOfCapacity(CList* list);
+static inline size_t clistSizeOfItems(CList* list);
 static inline void* clistBegin(CList* list);
 static inline void* clistBegin(CList* list);
 static inline void* clistEnd(CList* list);
 static inline void* clistLast(CList* list);
 static inline void* clistCapacityEnd(CList* list);
-static inline void clistAlloc(CList* list, uint32_t stride, uint32_t capacity);
-static inline CList clistCreate(uint32_t stride, uint32_t capacity);
+static inline void clistAlloc(CList* list, CSize stride, CSize capacity);
+static inline CList clistCreate(CSize stride, CSize capacity);
+// allocate from allocator instead of the default, NULL for the built-in aligned heap
+static inline void clistAllocEx(CList* list, CSize stride, CSize capacity, const CAllocator* allocator);
+static inline CList clistCreateEx(CSize stride, CSize capacity, const CAllocator* allocator);
+// use caller storage for the first capacity items, spills to the default allocator - see CLIST_INLINE
+static inline void clistAllocStorage(CList* list, void* storage, CSize stride, CSize capacity);
+// 1 while items are in the storage given to clistAllocStorage
+static inline uint32_t clistIsInline(CList* list);
 static inline void clistFree(CList* list);
 static inline void clistZeroMem(CList* list);
-static inline void clistRealloc(CList* list, uint32_t newCapacity);
-static inline void clistGrow(CList* list, uint32_t numNewItems);
-static inline void clistGrowZero(CList* list, uint32_t numNewItems);
-static inline void clistShrink(CList* list, uint32_t numLessItems);
+static inline void clistRealloc(CList* list, CSize newCapacity);
+// realloc only if capacity is less than minCapacity - use before time critical sections to avoid allocation
+static inline void clistReserve(CList* list, CSize minCapacity);
+// realloc geometrically if capacity is less than minCapacity - amortized O(1) growth for appends
+static inline void clistEnsureCapacity(CList* list, CSize minCapacity);
+static inline void clistGrow(CList* list, CSize numNewItems);
+static inline void clistGrowZero(CList* list, CSize numNewItems);
+static inline void clistShrink(CList* list, CSize numLessItems);
 static inline void clistAdd(CList* list, void* item);
-static inline void clistAddRange(CList* list, void* items, uint32_t itemsCount);
-static inline void* clistItemAt(CList* list, uint32_t index);
-static inline void clistInsertAt(CList* list, void* item, uint32_t index);
-static inline void clistInsertRangeAt(CList* list, void* items, uint32_t itemsCount, uint32_t index);
-static inline void clistZeroItemAt(CList* list, uint32_t index);
-static inline void clistZeroRangeAt(CList* list, uint32_t itemsCount, uint32_t index);
-static inline uint32_t clistFindIndex(CList* list, void* item);
-static inline uint32_t clistFindZeroIndex(CList* list);
-static inline void clistRemoveAt(CList* list, uint32_t index);
+static inline void clistAddRange(CList* list, void* items, CSize itemsCount);
+// add, growing the list if full - item must not point into the list
+static inline void clistAddGrow(CList* list, void* item);
+static inline void clistAddRangeGrow(CList* list, void* items, CSize itemsCount);
+// concurrent append - threads reserve ranges with an atomic add on Count and write them in place
+// address space for maxCapacity items is reserved up front and committed as the list grows, so data never moves
+// and readers of ranges already written are never stopped - reserving past maxCapacity is out of bounds
+// other clist functions may be used once appending threads are done
+static inline void clistAllocConcurrent(CList* list, CSize stride, CSize maxCapacity);
+// thread safe - returns itemsCount consecutive uninitialized items to write
+static inline void* clistAppendConcurrent(CList* list, CSize itemsCount);
+// thread safe
+static inline void clistAddConcurrent(CList* list, void* item);
+static inline void clistAddRangeConcurrent(CList* list, void* items, CSize itemsCount);
+static inline void* clistItemAt(CList* list, CSize index);
+static inline void clistInsertAt(CList* list, void* item, CSize index);
+static inline void clistInsertRangeAt(CList* list, void* items, CSize itemsCount, CSize index);
+static inline void clistZeroItemAt(CList* list, CSize index);
+static inline void clistZeroRangeAt(CList* list, CSize itemsCount, CSize index);
+// vectorized for strides 1, 2, 4, 8, 16 and 32 - CCOLLECTION_NOT_FOUND if none
+static inline CSize clistFindIndex(CList* list, void* item);
+// first item of all zero bytes, vectorized for strides 1, 2, 4, 8, 16 and 32 - CCOLLECTION_NOT_FOUND if none
+static inline CSize clistFindZeroIndex(CList* list);
+static inline void clistRemoveAt(CList* list, CSize index);
+static inline void clistRemoveRangeAt(CList* list, CSize index, CSize count);
 static inline void clistRemove(CList* list, void* item);
 
 
 
 
-uint32_t clistSizeOfCapacity(CList* list)
+size_t clistSizeOfCapacity(CList* list)
 {
-    return list->Stride * list->Capacity;
+    return (size_t)list->Stride * list->Capacity;
 }
 
-uint32_t clistSizeOfItems(CList* list)
+size_t clistSizeOfItems(CList* list)
 {
-    return list->Stride * list->Count;
+    return (size_t)list->Stride * list->Count;
 }
 
 void* clistBegin(CList* list)
@@ -66,7 +127,7 @@ void* clistBegin(CList* list)
 void* clistEnd(CList* list)
 {
     uint8_t* ptr = (uint8_t*)list->Data;
-    uint32_t size = clistSizeOfItems(list);
+    size_t size = (size_t)list->Stride * list->Count;
     return ptr + size;
 }
 
@@ -79,73 +140,290 @@ void* clistLast(CList* list)
 void* clistCapacityEnd(CList* list)
 {
     uint8_t* ptr = (uint8_t*)list->Data;
-    uint32_t size = clistSizeOfCapacity(list);
+    size_t size = (size_t)list->Stride * list->Capacity;
     return ptr + size;
 }
 
-void clistAlloc(CList* list, uint32_t stride, uint32_t capacity)
+// mapped lists are decided by allocator and capacity in bytes alone, so no flag is stored
+// their data is preceded by one page holding the reserved size
+static inline uint32_t clistIsMapped(const CAllocator* allocator, size_t capacityBytes)
+{
+#if defined(CVM_AVAILABLE)
+    const size_t mappedBytes = CLIST_MAPPED_BYTES;
+    return allocator == NULL && mappedBytes && capacityBytes >= mappedBytes;
+#else
+    (void)allocator;
+    (void)capacityBytes;
+    return 0;
+#endif
+}
+
+// heap lists round capacity up to a power of 2, mapped lists round up to fill their last page
+static inline CSize clistRoundCapacity(const CAllocator* allocator, CSize stride, CSize capacity)
+{
+    CSize pow2 = capacity;
+    if (!CCOLLECTIONS_IS_POW2(pow2))
+    {
+        CCOLLECTIONS_SET_NEXT_POW2(pow2);
+    }
+    if (!clistIsMapped(allocator, (size_t)stride * pow2))
+    {
+        return pow2;
+    }
+#if defined(CVM_AVAILABLE)
+    if (!clistIsMapped(allocator, (size_t)stride * capacity))
+    {
+        capacity = (CSize)((CLIST_MAPPED_BYTES + stride - 1) / stride);
+    }
+    const size_t page = cvmPageSize();
+    const size_t rounded = (((size_t)stride * capacity + page - 1) & ~(page - 1)) / stride;
+    const size_t sizeMax = CCOLLECTIONS_SIZE_MAX;
+    return rounded > sizeMax ? (CSize)sizeMax : (CSize)rounded;
+#else
+    return pow2;
+#endif
+}
+
+#if defined(CVM_AVAILABLE)
+
+static inline uint8_t* clistMapData(size_t size)
+{
+    const size_t page = cvmPageSize();
+    const size_t committed = page + ((size + page - 1) & ~(page - 1));
+#if defined(CVM_REMAP)
+    const size_t reserved = committed;
+#else
+    const size_t reserved = committed > CLIST_MAPPED_RESERVE_BYTES ? committed * 2 : CLIST_MAPPED_RESERVE_BYTES;
+#endif
+    assert(page % CCOLLECTIONS_ALIGNMENT == 0 && "page smaller than CCOLLECTIONS_ALIGNMENT");
+    uint8_t* base = (uint8_t*)cvmReserve(reserved);
+    if (base == NULL)
+    {
+        return NULL;
+    }
+    if (!cvmCommit(base, committed))
+    {
+        cvmRelease(base, reserved);
+        return NULL;
+    }
+    if (callocatorAlignment(size) == CCOLLECTIONS_HUGE_PAGE_ALIGNMENT)
+    {
+        cvmAdviseHugePages(base, reserved);
+    }
+    *(size_t*)base = reserved;
+    return base + page;
+}
+
+// grow or shrink within the reservation, or remap - returns NULL if data must be copied instead
+static inline uint8_t* clistRemapData(uint8_t* data, size_t newSize)
+{
+    const size_t page = cvmPageSize();
+    uint8_t* base = data - page;
+    const size_t reserved = *(size_t*)base;
+    const size_t committed = page + ((newSize + page - 1) & ~(page - 1));
+#if defined(CVM_REMAP)
+    base = (uint8_t*)cvmRemap(base, reserved, committed);
+    if (base == NULL)
+    {
+        return NULL;
+    }
+    *(size_t*)base = committed;
+    return base + page;
+#else
+    return committed <= reserved && cvmCommit(base, committed) ? data : NULL;
+#endif
+}
+
+#endif // CVM_AVAILABLE
+
+static inline uint8_t* clistAllocData(const CAllocator* allocator, size_t size)
+{
+#if defined(CVM_AVAILABLE)
+    if (clistIsMapped(allocator, size))
+    {
+        return clistMapData(size);
+    }
+#endif
+    return (uint8_t*)callocatorAlloc(allocator, size);
+}
+
+#if defined(CVM_AVAILABLE)
+static inline void clistUnmapData(uint8_t* data)
+{
+    uint8_t* base = data - cvmPageSize();
+    cvmRelease(base, *(size_t*)base);
+}
+#endif // CVM_AVAILABLE
+
+static inline void clistFreeData(const CAllocator* allocator, uint8_t* data, size_t size)
 {
-    if (!CCOLLECTIONS_IS_POW2(capacity))
+#if defined(CVM_AVAILABLE)
+    if (clistIsMapped(allocator, size))
     {
-        CCOLLECTIONS_SET_NEXT_POW2(capacity);
+        clistUnmapData(data);
+        return;
     }
+#endif
+    callocatorFree(allocator, data, size);
+}
+
+void clistAlloc(CList* list, CSize stride, CSize capacity)
+{
+    clistAllocEx(list, stride, capacity, callocatorDefault());
+}
+
+void clistAllocEx(CList* list, CSize stride, CSize capacity, const CAllocator* allocator)
+{
     list->Count = 0;
-    list->Capacity = capacity;
+    list->Capacity = clistRoundCapacity(allocator, stride, capacity);
     list->Stride = stride;
-    uint32_t size = clistSizeOfCapacity(list);
-    list->Data = (uint8_t*)_mm_malloc(size, CCOLLECTIONS_ALIGNMENT);
+    list->Allocator = allocator;
+    list->Data = clistAllocData(allocator, (size_t)stride * list->Capacity);
+    assert(list->Data);
     list->Type = CCOLLECTION_TYPE_LIST;
 }
 
-CList clistCreate(uint32_t stride, uint32_t capacity)
+CList clistCreate(CSize stride, CSize capacity)
 {
     CList list;
     clistAlloc(&list, stride, capacity);
     return list;
 }
 
+CList clistCreateEx(CSize stride, CSize capacity, const CAllocator* allocator)
+{
+    CList list;
+    clistAllocEx(&list, stride, capacity, allocator);
+    return list;
+}
+
+void clistAllocStorage(CList* list, void* storage, CSize stride, CSize capacity)
+{
+    list->Count = 0;
+    list->Capacity = capacity;
+    list->Stride = stride;
+    list->Allocator = callocatorDefault();
+    list->Data = (uint8_t*)storage;
+    list->Type = CCOLLECTION_TYPE_LIST_INLINE;
+}
+
+uint32_t clistIsInline(CList* list)
+{
+    return list->Type == CCOLLECTION_TYPE_LIST_INLINE;
+}
+
 void clistFree(CList* list)
 {
-    _mm_free(list->Data);
+    if (clistIsInline(list))
+    {
+        return;
+    }
+#if defined(CVM_AVAILABLE)
+    if (list->Type == CCOLLECTION_TYPE_LIST_CONCURRENT)
+    {
+        clistUnmapData(list->Data);
+        return;
+    }
+#endif
+    clistFreeData(list->Allocator, list->Data, (size_t)list->Stride * list->Capacity);
 }
 
 void clistZeroMem(CList* list)
 {
-    uint32_t size = clistSizeOfCapacity(list);
+    size_t size = (size_t)list->Stride * list->Capacity;
     memset(list->Data, 0, size);
 }
 
-void clistRealloc(CList* list, uint32_t newCapacity)
+// inline storage cannot be resized - shrinking keeps it, growing moves the items to the heap for good
+static inline void clistReallocInline(CList* list, CSize newCapacity)
+{
+    if (newCapacity <= list->Capacity)
+    {
+        list->Capacity = newCapacity;
+        return;
+    }
+    const CAllocator* allocator = list->Allocator;
+    newCapacity = clistRoundCapacity(allocator, list->Stride, newCapacity);
+    uint8_t* data = clistAllocData(allocator, (size_t)list->Stride * newCapacity);
+    assert(data);
+    memcpy(data, list->Data, (size_t)list->Stride * list->Count);
+    list->Data = data;
+    list->Capacity = newCapacity;
+    list->Type = CCOLLECTION_TYPE_LIST;
+}
+
+void clistRealloc(CList* list, CSize newCapacity)
 {
-    if (!CCOLLECTIONS_IS_POW2(newCapacity))
+    assert(list->Type != CCOLLECTION_TYPE_LIST_CONCURRENT && "concurrent CList cannot be reallocated");
+    if (clistIsInline(list))
     {
-        CCOLLECTIONS_SET_NEXT_POW2(newCapacity);
+        clistReallocInline(list, newCapacity);
+        return;
     }
-    void* data = list->Data;
+    const CAllocator* allocator = list->Allocator;
+    newCapacity = clistRoundCapacity(allocator, list->Stride, newCapacity);
+    uint8_t* data = list->Data;
+    const size_t oldSize = (size_t)list->Stride * list->Capacity;
+    const size_t newSize = (size_t)list->Stride * newCapacity;
+    const size_t itemsSize = (size_t)list->Stride * list->Count;
     list->Capacity = newCapacity;
-    list->Data = (uint8_t*)_mm_malloc(clistSizeOfCapacity(list), CCOLLECTIONS_ALIGNMENT);
+#if defined(CVM_AVAILABLE)
+    const uint32_t bOldMapped = clistIsMapped(allocator, oldSize);
+    const uint32_t bNewMapped = clistIsMapped(allocator, newSize);
+    if (bOldMapped || bNewMapped)
+    {
+        // mapped to mapped keeps or moves pages instead of copying
+        list->Data = bOldMapped && bNewMapped ? clistRemapData(data, newSize) : NULL;
+        if (list->Data == NULL)
+        {
+            list->Data = clistAllocData(allocator, newSize);
+            assert(list->Data);
+            memcpy(list->Data, data, itemsSize < newSize ? itemsSize : newSize);
+            clistFreeData(allocator, data, oldSize);
+        }
+        return;
+    }
+#endif
+    list->Data = (uint8_t*)callocatorRealloc(allocator, data, oldSize, newSize, itemsSize);
     assert(list->Data);
-    memcpy(list->Data, data, clistSizeOfItems(list));
-    _mm_free(data);
 }
 
-void clistGrow(CList* list, uint32_t numNewItems)
+void clistReserve(CList* list, CSize minCapacity)
+{
+    if (minCapacity > list->Capacity)
+    {
+        clistRealloc(list, minCapacity);
+    }
+}
+
+void clistEnsureCapacity(CList* list, CSize minCapacity)
+{
+    if (minCapacity > list->Capacity)
+    {
+        const uint64_t grown = (uint64_t)list->Capacity * CLIST_GROWTH_NUMERATOR / CLIST_GROWTH_DENOMINATOR;
+        const uint64_t sizeMax = CCOLLECTIONS_SIZE_MAX;
+        const CSize newCapacity = grown > sizeMax || (uint64_t)list->Capacity > sizeMax / CLIST_GROWTH_NUMERATOR ? (CSize)sizeMax : (CSize)grown;
+        clistRealloc(list, newCapacity > minCapacity ? newCapacity : minCapacity);
+    }
+}
+
+void clistGrow(CList* list, CSize numNewItems)
 {
-    uint32_t newcapacity = list->Capacity + numNewItems;
+    CSize newcapacity = list->Capacity + numNewItems;
     clistRealloc(list, newcapacity);
 }
 
-void clistGrowZero(CList* list, uint32_t numNewItems)
+void clistGrowZero(CList* list, CSize numNewItems)
 {
     clistGrow(list, numNewItems);
-    uint8_t* dst = (uint8_t*)list->Data + clistSizeOfItems(list);
-    uint8_t* capEnd = (uint8_t*)list->Data + clistSizeOfCapacity(list);
+    uint8_t* dst = (uint8_t*)clistEnd(list);
+    uint8_t* capEnd = (uint8_t*)clistCapacityEnd(list);
     memset(dst, 0, capEnd - dst);
 }
 
-void clistShrink(CList* list, uint32_t numLessItems)
+void clistShrink(CList* list, CSize numLessItems)
 {
-    uint32_t newcapacity = list->Capacity - numLessItems;
+    CSize newcapacity = list->Capacity - numLessItems;
     clistRealloc(list, newcapacity);
 }
 
@@ -157,7 +435,7 @@ void clistAdd(CList* list, void* item)
     assert(list->Count <= list->Capacity && "CList out of bounds");
 }
 
-void clistAddRange(CList* list, void* items, uint32_t itemsCount)
+void clistAddRange(CList* list, void* items, CSize itemsCount)
 {
     uint8_t* end = (uint8_t*)clistEnd(list);
     memcpy(end, items, (size_t)list->Stride * itemsCount);
@@ -165,15 +443,129 @@ void clistAddRange(CList* list, void* items, uint32_t itemsCount)
     assert(list->Count <= list->Capacity && "CList out of bounds");
 }
 
-void* clistItemAt(CList* list, uint32_t index)
+void clistAddGrow(CList* list, void* item)
+{
+    clistEnsureCapacity(list, list->Count + 1);
+    clistAdd(list, item);
+}
+
+void clistAddRangeGrow(CList* list, void* items, CSize itemsCount)
+{
+    clistEnsureCapacity(list, list->Count + itemsCount);
+    clistAddRange(list, items, itemsCount);
+}
+
+static inline CSize clistAtomicLoadSize(CSize* ptr)
+{
+#if defined(CCOLLECTIONS_SIZE64)
+    return catomicLoad64((volatile uint64_t*)ptr);
+#else
+    return catomicLoad32((volatile uint32_t*)ptr);
+#endif
+}
+
+static inline CSize clistAtomicFetchAddSize(CSize* ptr, CSize value)
+{
+#if defined(CCOLLECTIONS_SIZE64)
+    return catomicFetchAdd64((volatile uint64_t*)ptr, value);
+#else
+    return catomicFetchAdd32((volatile uint32_t*)ptr, value);
+#endif
+}
+
+static inline uint32_t clistAtomicCompareExchangeSize(CSize* ptr, CSize expected, CSize desired)
+{
+#if defined(CCOLLECTIONS_SIZE64)
+    return catomicCompareExchange64((volatile uint64_t*)ptr, expected, desired);
+#else
+    return catomicCompareExchange32((volatile uint32_t*)ptr, expected, desired);
+#endif
+}
+
+void clistAllocConcurrent(CList* list, CSize stride, CSize maxCapacity)
+{
+    list->Count = 0;
+    list->Stride = stride;
+    list->Allocator = callocatorDefault();
+    list->Type = CCOLLECTION_TYPE_LIST_CONCURRENT;
+#if defined(CVM_AVAILABLE)
+    // header page holds the reserved size as for mapped lists, capacity starts at one committed page
+    const size_t page = cvmPageSize();
+    const size_t maxBytes = ((size_t)stride * maxCapacity + page - 1) & ~(page - 1);
+    uint8_t* base = (uint8_t*)cvmReserve(page + maxBytes);
+    assert(base);
+    const size_t committed = maxBytes < page ? maxBytes : page;
+    const uint32_t bCommitted = cvmCommit(base, page + committed);
+    assert(bCommitted);
+    (void)bCommitted;
+    *(size_t*)base = page + maxBytes;
+    list->Data = base + page;
+    list->Capacity = (CSize)(committed / stride);
+#else
+    // no virtual memory, the whole range up front
+    list->Capacity = maxCapacity;
+    list->Data = (uint8_t*)callocatorAlloc(list->Allocator, (size_t)stride * maxCapacity);
+    assert(list->Data);
+#endif
+}
+
+// commit pages for at least minCapacity items, growing geometrically
+// threads may commit overlapping ranges at once - committed pages keep their contents, the larger capacity is kept
+static inline void clistCommitConcurrent(CList* list, CSize minCapacity)
+{
+    CSize capacity = clistAtomicLoadSize(&list->Capacity);
+    if (minCapacity <= capacity)
+    {
+        return;
+    }
+#if defined(CVM_AVAILABLE)
+    const size_t page = cvmPageSize();
+    uint8_t* base = list->Data - page;
+    const size_t maxBytes = *(size_t*)base - page;
+    const size_t minBytes = (size_t)list->Stride * minCapacity;
+    assert(minBytes <= maxBytes && "CList concurrent max capacity exceeded");
+    size_t bytes = (size_t)list->Stride * capacity * 2;
+    bytes = ((bytes > minBytes ? bytes : minBytes) + page - 1) & ~(page - 1);
+    bytes = bytes < maxBytes ? bytes : maxBytes;
+    const uint32_t bCommitted = cvmCommit(base, page + bytes);
+    assert(bCommitted && "CList concurrent commit failed");
+    (void)bCommitted;
+    const CSize newCapacity = (CSize)(bytes / list->Stride);
+    while (capacity < newCapacity && !clistAtomicCompareExchangeSize(&list->Capacity, capacity, newCapacity))
+    {
+        capacity = clistAtomicLoadSize(&list->Capacity);
+    }
+#else
+    assert(0 && "CList concurrent max capacity exceeded");
+#endif
+}
+
+void* clistAppendConcurrent(CList* list, CSize itemsCount)
+{
+    const CSize index = clistAtomicFetchAddSize(&list->Count, itemsCount);
+    clistCommitConcurrent(list, index + itemsCount);
+    return list->Data + (size_t)list->Stride * index;
+}
+
+void clistAddConcurrent(CList* list, void* item)
+{
+    memcpy(clistAppendConcurrent(list, 1), item, list->Stride);
+}
+
+void clistAddRangeConcurrent(CList* list, void* items, CSize itemsCount)
+{
+    memcpy(clistAppendConcurrent(list, itemsCount), items, (size_t)list->Stride * itemsCount);
+}
+
+void* clistItemAt(CList* list, CSize index)
 {
     uint8_t* ptr = (uint8_t*)list->Data;
-    uint32_t offset = list->Stride * index;
+    size_t offset = (size_t)list->Stride * index;
     assert(ptr < (uint8_t*)clistEnd(list) && "CList out of bounds");
     return ptr + offset;
 }
 
-void clistInsertAt(CList* list, void* item, uint32_t index)
+void clistInsertAt(CList* list, void* item, CSize index)
 {
     size_t stride = (size_t)list->Stride;
     uint8_t* insdst = (uint8_t*)clistItemAt(list, index);
@@ -185,7 +577,7 @@ void clistInsertAt(CList* list, void* item, uint32_t index)
     assert(list->Count <= list->Capacity && "CList out of bounds");
 }
 
-void clistInsertRangeAt(CList* list, void* items, uint32_t itemsCount, uint32_t index)
+void clistInsertRangeAt(CList* list, void* items, CSize itemsCount, CSize index)
 {
     size_t stride = (size_t)list->Stride;
     size_t itemsSize = stride * itemsCount;
@@ -198,14 +590,14 @@ void clistInsertRangeAt(CList* list, void* items, uint32_t itemsCount, uint32_t
     assert(list->Count <= list->Capacity && "CList out of bounds");
 }
 
-void clistZeroItemAt(CList* list, uint32_t index)
+void clistZeroItemAt(CList* list, CSize index)
 {
     void* item = clistItemAt(list, index);
     assert(item < clistEnd(list) && "CList out of bounds");
     memset(item, 0, list->Stride);
 }
 
-void clistZeroRangeAt(CList* list, uint32_t itemsCount, uint32_t index)
+void clistZeroRangeAt(CList* list, CSize itemsCount, CSize index)
 {
     uint8_t* dst = (uint8_t*)clistItemAt(list, index);
     size_t size = (size_t)list->Stride * itemsCount;
@@ -213,42 +605,202 @@ void clistZeroRangeAt(CList* list, uint32_t itemsCount, uint32_t index)
     memset(dst, 0, size);
 }
 
-uint32_t clistFindIndex(CList* list, void* item)
+// vectorized find - compares 64 bytes at a time against a pattern of the item repeated, then folds
+// the byte equality mask to one bit per item: an item matches when all of its stride bits are set
+// stride must be a power of 2 up to 32 so items never straddle a 64 byte block
+
+static inline uint32_t clistIsSimdStride(CSize stride)
+{
+    return stride <= 32 && CCOLLECTIONS_IS_POW2(stride);
+}
+
+static inline uint64_t clistFoldItemMask(uint64_t byteMask, CSize stride, uint64_t itemLanes)
+{
+    for (uint32_t shift = 1; shift < stride; shift <<= 1)
+    {
+        byteMask &= byteMask >> shift;
+    }
+    return byteMask & itemLanes;
+}
+
+#if defined(CSIMD_X86)
+
+static inline size_t clistFindPatternSse2(const uint8_t* data, size_t size, const uint8_t* pattern, CSize stride)
+{
+    const uint64_t itemLanes = UINT64_MAX / ((1ull << stride) - 1);
+    const __m128i p0 = _mm_loadu_si128((const __m128i*)pattern);
+    const __m128i p1 = _mm_loadu_si128((const __m128i*)(pattern + 16));
+    const __m128i p2 = _mm_loadu_si128((const __m128i*)(pattern + 32));
+    const __m128i p3 = _mm_loadu_si128((const __m128i*)(pattern + 48));
+    for (size_t offset = 0; offset < size; offset += 64)
+    {
+        const uint8_t* block = data + offset;
+        uint64_t mask = (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)block), p0));
+        mask |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(block + 16)), p1)) << 16;
+        mask |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(block + 32)), p2)) << 32;
+        mask |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(block + 48)), p3)) << 48;
+        if (mask && (mask = clistFoldItemMask(mask, stride, itemLanes)) != 0)
+        {
+            return offset + csimdCtz64(mask);
+        }
+    }
+    return size;
+}
+
+CSIMD_TARGET_AVX2 static inline size_t clistFindPatternAvx2(const uint8_t* data, size_t size, const uint8_t* pattern, CSize stride)
 {
+    const uint64_t itemLanes = UINT64_MAX / ((1ull << stride) - 1);
+    const __m256i p0 = _mm256_loadu_si256((const __m256i*)pattern);
+    const __m256i p1 = _mm256_loadu_si256((const __m256i*)(pattern + 32));
+    for (size_t offset = 0; offset < size; offset += 64)
+    {
+        const uint8_t* block = data + offset;
+        uint64_t mask = (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)block), p0));
+        mask |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(block + 32)), p1)) << 32;
+        if (mask && (mask = clistFoldItemMask(mask, stride, itemLanes)) != 0)
+        {
+            return offset + csimdCtz64(mask);
+        }
+    }
+    return size;
+}
+
+CSIMD_TARGET_AVX512 static inline size_t clistFindPatternAvx512(const uint8_t* data, size_t size, const uint8_t* pattern, CSize stride)
+{
+    const uint64_t itemLanes = UINT64_MAX / ((1ull << stride) - 1);
+    const __m512i p = _mm512_loadu_si512((const void*)pattern);
+    for (size_t offset = 0; offset < size; offset += 64)
+    {
+        uint64_t mask = (uint64_t)_mm512_cmpeq_epi8_mask(_mm512_loadu_si512((const void*)(data + offset)), p);
+        if (mask && (mask = clistFoldItemMask(mask, stride, itemLanes)) != 0)
+        {
+            return offset + csimdCtz64(mask);
+        }
+    }
+    return size;
+}
+
+#endif // CSIMD_X86
+
+// wide compare - small strides as one integer, larger ones reject most items on the first 8 bytes before memcmp
+static inline uint32_t clistItemEquals(const uint8_t* a, const uint8_t* b, CSize stride)
+{
+    switch (stride)
+    {
+    case 1: return *a == *b;
+    case 2: { uint16_t wordA, wordB; memcpy(&wordA, a, 2); memcpy(&wordB, b, 2); return wordA == wordB; }
+    case 4: { uint32_t wordA, wordB; memcpy(&wordA, a, 4); memcpy(&wordB, b, 4); return wordA == wordB; }
+    default: break;
+    }
+    if (stride < 8)
+    {
+        return memcmp(a, b, stride) == 0;
+    }
+    uint64_t wordA, wordB;
+    memcpy(&wordA, a, sizeof(uint64_t));
+    memcpy(&wordB, b, sizeof(uint64_t));
+    return wordA == wordB && memcmp(a + 8, b + 8, stride - 8) == 0;
+}
+
+static inline uint32_t clistItemIsZero(const uint8_t* item, CSize stride)
+{
+    uint64_t wordsOr = 0;
+    CSize i = 0;
+    for (; i + 8 <= stride; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, item + i, sizeof(uint64_t));
+        if (word)
+        {
+            return 0;
+        }
+    }
+    for (; i < stride; ++i)
+    {
+        wordsOr |= item[i];
+    }
+    return wordsOr == 0;
+}
+
+// pattern is 64 bytes of the item repeated
+static inline CSize clistFindPattern(CList* list, const uint8_t* pattern)
+{
+    const uint8_t* data = (const uint8_t*)clistBegin(list);
+    const CSize stride = list->Stride;
+    const size_t size = (size_t)stride * list->Count;
+    size_t blocksSize = 0;
+#if defined(CSIMD_X86)
+    blocksSize = size & ~(size_t)63;
+    size_t found = blocksSize;
+    switch (csimdLevel())
+    {
+    case CSIMD_LEVEL_AVX512: found = clistFindPatternAvx512(data, blocksSize, pattern, stride); break;
+    case CSIMD_LEVEL_AVX2: found = clistFindPatternAvx2(data, blocksSize, pattern, stride); break;
+    case CSIMD_LEVEL_SSE2: found = clistFindPatternSse2(data, blocksSize, pattern, stride); break;
+    default: blocksSize = 0; break;
+    }
+    if (found < blocksSize)
+    {
+        return (CSize)(found / stride);
+    }
+#endif // CSIMD_X86
+    for (size_t offset = blocksSize; offset < size; offset += stride)
+    {
+        if (clistItemEquals(data + offset, pattern, stride))
+        {
+            return (CSize)(offset / stride);
+        }
+    }
+    return CCOLLECTION_NOT_FOUND;
+}
+
+CSize clistFindIndex(CList* list, void* item)
+{
+    CSize stride = list->Stride;
+    if (clistIsSimdStride(stride))
+    {
+        uint8_t pattern[64];
+        for (CSize offset = 0; offset < 64; offset += stride)
+        {
+            memcpy(pattern + offset, item, stride);
+        }
+        return clistFindPattern(list, pattern);
+    }
+
     uint8_t* itr = (uint8_t*)clistBegin(list);
     uint8_t* end = (uint8_t*)clistEnd(list);
-    uint32_t stride = list->Stride;
-    for (uint32_t i = 0; itr != end; itr += stride, ++i)
+    for (CSize i = 0; itr != end; itr += stride, ++i)
     {
-        if (memcmp(itr, item, stride) == 0)
+        if (clistItemEquals(itr, (const uint8_t*)item, stride))
         {
             return i;
         }
     }
-    return CCOLLECTION_ERROR;
+    return CCOLLECTION_NOT_FOUND;
 }
 
-uint32_t clistFindZeroIndex(CList* list)
+CSize clistFindZeroIndex(CList* list)
 {
+    CSize stride = list->Stride;
+    if (clistIsSimdStride(stride))
+    {
+        const uint8_t pattern[64] = { 0 };
+        return clistFindPattern(list, pattern);
+    }
+
     uint8_t* itr = (uint8_t*)clistBegin(list);
-    uint8_t* end = (uint8_t*)clistCapacityEnd(list);
-    uint32_t stride = list->Stride;
-    for (uint32_t i = 0; itr != end; itr += stride, ++i)
+    uint8_t* end = (uint8_t*)clistEnd(list);
+    for (CSize i = 0; itr != end; itr += stride, ++i)
     {
-        uint8_t bytesOr = 0;
-        for (uint8_t* byte = itr, *byteEnd = itr + stride; byte != byteEnd; ++byte)
-        {
-            bytesOr |= *byte;
-        }
-        if (bytesOr == 0)
+        if (clistItemIsZero(itr, stride))
         {
             return i;
         }
     }
-    return CCOLLECTION_ERROR;
+    return CCOLLECTION_NOT_FOUND;
 }
 
-void clistRemoveAt(CList* list, uint32_t index)
+void clistRemoveAt(CList* list, CSize index)
 {
     uint8_t* dst = (uint8_t*)clistItemAt(list, index);
     uint8_t* src = dst + list->Stride;
@@ -257,9 +809,9 @@ void clistRemoveAt(CList* list, uint32_t index)
     --list->Count;
 }
 
-void clistRemoveRangeAt(CList* list, uint32_t index, uint32_t count)
+void clistRemoveRangeAt(CList* list, CSize index, CSize count)
 {
-    uint32_t remsize = list->Stride * count;
+    size_t remsize = (size_t)list->Stride * count;
     uint8_t* dst = (uint8_t*)clistItemAt(list, index);
     uint8_t* src = dst + remsize;
     uint8_t* end = (uint8_t*)clistEnd(list);
@@ -269,8 +821,8 @@ void clistRemoveRangeAt(CList* list, uint32_t index, uint32_t count)
 
 void clistRemove(CList* list, void* item)
 {
-    uint32_t index = clistFindIndex(list, item);
-    if (index == CCOLLECTION_ERROR) return;
+    CSize index = clistFindIndex(list, item);
+    if (index == CCOLLECTION_NOT_FOUND) return;
     clistRemoveAt(list, index);
 }
 
@@ -0,0 +1,651 @@
+// MIT License - CCollections
+// Copyright(c) 2020 Dante Falcone (dantefalcone@gmail.com)
+#pragma once
+#include "CList.h"
+
+#if defined(_WIN32)
+    #ifndef WIN32_LEAN_AND_MEAN
+    #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+#else
+    #include <pthread.h>
+    #include <unistd.h>
+#endif
+
+/*  CListSort
+
+    In place sorting of CList items
+    LSD radix sort on a key at an offset in each item - unsigned, signed or float keys of 1, 2, 4 or 8 bytes, stable
+    Comparator sorts - introsort without allocation, or stable merge sort
+    Parallel variants split the list across threads and fall back to one thread below CLIST_SORT_PARALLEL_MIN_ITEMS
+    Radix and stable sorts allocate a scratch copy of the items from the list's allocator, parallel radix sort its per thread histograms with it
+*/
+
+#ifndef CLIST_SORT_PARALLEL_MIN_ITEMS
+// lists smaller than this are sorted on the calling thread only
+#define CLIST_SORT_PARALLEL_MIN_ITEMS 0x10000
+#endif // !CLIST_SORT_PARALLEL_MIN_ITEMS
+
+#ifndef CLIST_SORT_MAX_THREADS
+#define CLIST_SORT_MAX_THREADS 64
+#endif // !CLIST_SORT_MAX_THREADS
+
+enum CLIST_SORT_KEY
+{
+    CLIST_SORT_KEY_UINT,
+    CLIST_SORT_KEY_INT,
+    // IEEE 754 float or double, negative zero sorts before zero
+    CLIST_SORT_KEY_FLOAT,
+};
+
+// returns < 0 if a sorts before b, 0 if equal, > 0 if after
+typedef int (*CListCompare)(const void* a, const void* b, void* context);
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+// keyWidth of 1, 2, 4 or 8 bytes at keyOffset in each item, keyType of CLIST_SORT_KEY
+static inline void clistSortRadix(CList* list, CSize keyOffset, CSize keyWidth, uint32_t keyType);
+// threadCount 0 for all hardware threads
+static inline void clistSortRadixParallel(CList* list, CSize keyOffset, CSize keyWidth, uint32_t keyType, uint32_t threadCount);
+// unstable, no allocation
+static inline void clistSort(CList* list, CListCompare compare, void* context);
+static inline void clistSortStable(CList* list, CListCompare compare, void* context);
+// threadCount 0 for all hardware threads
+static inline void clistSortStableParallel(CList* list, CListCompare compare, void* context, uint32_t threadCount);
+
+
+
+//=======================================================================
+// threads
+
+typedef void (*CListSortTask)(void* args, uint32_t index);
+
+typedef struct CListSortThread
+{
+    CListSortTask task;
+    void* args;
+    uint32_t index;
+} CListSortThread;
+
+#if defined(_WIN32)
+static inline DWORD WINAPI clistSortThreadMain(LPVOID arg)
+#else
+static inline void* clistSortThreadMain(void* arg)
+#endif
+{
+    CListSortThread* thread = (CListSortThread*)arg;
+    thread->task(thread->args, thread->index);
+    return 0;
+}
+
+static inline uint32_t clistSortHardwareThreads(void)
+{
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    const uint32_t count = (uint32_t)info.dwNumberOfProcessors;
+#else
+    const long online = sysconf(_SC_NPROCESSORS_ONLN);
+    const uint32_t count = online > 0 ? (uint32_t)online : 1u;
+#endif
+    return count < CLIST_SORT_MAX_THREADS ? count : CLIST_SORT_MAX_THREADS;
+}
+
+static inline uint32_t clistSortThreadCount(CSize count, uint32_t threadCount)
+{
+    if (count < CLIST_SORT_PARALLEL_MIN_ITEMS)
+    {
+        return 1;
+    }
+    threadCount = threadCount ? threadCount : clistSortHardwareThreads();
+    return threadCount < CLIST_SORT_MAX_THREADS ? threadCount : CLIST_SORT_MAX_THREADS;
+}
+
+// run task for indices 0 to taskCount - 1, one thread each, index 0 and tasks whose thread failed to start on the calling thread
+static inline void clistSortRun(CListSortTask task, void* args, uint32_t taskCount)
+{
+    CListSortThread threads[CLIST_SORT_MAX_THREADS];
+    uint32_t bStarted[CLIST_SORT_MAX_THREADS];
+#if defined(_WIN32)
+    HANDLE handles[CLIST_SORT_MAX_THREADS];
+#else
+    pthread_t handles[CLIST_SORT_MAX_THREADS];
+#endif
+    assert(taskCount <= CLIST_SORT_MAX_THREADS);
+    for (uint32_t i = 1; i < taskCount; ++i)
+    {
+        threads[i].task = task;
+        threads[i].args = args;
+        threads[i].index = i;
+#if defined(_WIN32)
+        handles[i] = CreateThread(NULL, 0, clistSortThreadMain, &threads[i], 0, NULL);
+        bStarted[i] = handles[i] != NULL;
+#else
+        bStarted[i] = pthread_create(&handles[i], NULL, clistSortThreadMain, &threads[i]) == 0;
+#endif
+    }
+    task(args, 0);
+    for (uint32_t i = 1; i < taskCount; ++i)
+    {
+        if (bStarted[i] == 0)
+        {
+            task(args, i);
+            continue;
+        }
+#if defined(_WIN32)
+        WaitForSingleObject(handles[i], INFINITE);
+        CloseHandle(handles[i]);
+#else
+        pthread_join(handles[i], NULL);
+#endif
+    }
+}
+
+//=======================================================================
+// items
+
+static inline void clistSortCopyItem(uint8_t* dst, const uint8_t* src, size_t stride)
+{
+    switch (stride)
+    {
+    case 4: memcpy(dst, src, 4); break;
+    case 8: memcpy(dst, src, 8); break;
+    case 16: memcpy(dst, src, 16); break;
+    default: memcpy(dst, src, stride); break;
+    }
+}
+
+static inline void clistSortSwapItems(uint8_t* a, uint8_t* b, size_t stride)
+{
+    uint64_t word;
+    for (; stride >= sizeof(word); stride -= sizeof(word), a += sizeof(word), b += sizeof(word))
+    {
+        memcpy(&word, a, sizeof(word));
+        memcpy(a, b, sizeof(word));
+        memcpy(b, &word, sizeof(word));
+    }
+    for (; stride; --stride, ++a, ++b)
+    {
+        uint8_t byte = *a;
+        *a = *b;
+        *b = byte;
+    }
+}
+
+// room for a copy of the items after headerSize bytes, a multiple of 64 keeps the copy cache line aligned
+static inline uint8_t* clistSortAllocScratch(CList* list, size_t headerSize)
+{
+    uint8_t* scratch = (uint8_t*)callocatorAlloc(list->Allocator, headerSize + (size_t)list->Stride * list->Count);
+    assert(scratch);
+    return scratch;
+}
+
+static inline void clistSortFreeScratch(CList* list, uint8_t* scratch, size_t headerSize)
+{
+    callocatorFree(list->Allocator, scratch, headerSize + (size_t)list->Stride * list->Count);
+}
+
+//=======================================================================
+// radix sort
+
+typedef struct CListSortKey
+{
+    size_t Offset;
+    uint32_t Width;
+    uint32_t Type;
+} CListSortKey;
+
+// key bits ordered as unsigned integers
+static inline uint64_t clistSortKeyBits(const uint8_t* item, const CListSortKey* key)
+{
+    const uint8_t* ptr = item + key->Offset;
+    uint64_t bits;
+    switch (key->Width)
+    {
+    case 1: { uint8_t value; memcpy(&value, ptr, 1); bits = value; } break;
+    case 2: { uint16_t value; memcpy(&value, ptr, 2); bits = value; } break;
+    case 4: { uint32_t value; memcpy(&value, ptr, 4); bits = value; } break;
+    default: memcpy(&bits, ptr, 8); break;
+    }
+    if (key->Type == CLIST_SORT_KEY_UINT)
+    {
+        return bits;
+    }
+    const uint64_t sign = (uint64_t)1 << (key->Width * 8 - 1);
+    if (key->Type == CLIST_SORT_KEY_INT)
+    {
+        return bits ^ sign;
+    }
+    // negative floats sort in reverse, so flip all bits of negatives and only the sign of positives
+    const uint64_t mask = sign | (sign - 1);
+    return bits & sign ? ~bits & mask : bits | sign;
+}
+
+static inline CListSortKey clistSortMakeKey(CList* list, CSize keyOffset, CSize keyWidth, uint32_t keyType)
+{
+    assert((keyWidth == 1 || keyWidth == 2 || keyWidth == 4 || keyWidth == 8) && "CListSort key width must be 1, 2, 4 or 8");
+    assert(keyOffset + keyWidth <= list->Stride && "CListSort key out of item bounds");
+    assert((keyType != CLIST_SORT_KEY_FLOAT || keyWidth >= 4) && "CListSort float key must be 4 or 8 bytes");
+    CListSortKey key;
+    key.Offset = keyOffset;
+    key.Width = (uint32_t)keyWidth;
+    key.Type = keyType;
+    return key;
+}
+
+void clistSortRadix(CList* list, CSize keyOffset, CSize keyWidth, uint32_t keyType)
+{
+    const size_t count = list->Count;
+    const size_t stride = list->Stride;
+    if (count < 2)
+    {
+        return;
+    }
+    const CListSortKey key = clistSortMakeKey(list, keyOffset, keyWidth, keyType);
+
+    // histograms of every digit in one read
+    size_t histograms[8][256];
+    memset(histograms, 0, sizeof(histograms[0]) * key.Width);
+    for (uint8_t* itr = list->Data, *end = list->Data + count * stride; itr != end; itr += stride)
+    {
+        uint64_t bits = clistSortKeyBits(itr, &key);
+        for (uint32_t pass = 0; pass < key.Width; ++pass, bits >>= 8)
+        {
+            ++histograms[pass][bits & 0xFF];
+        }
+    }
+
+    uint8_t* scratch = clistSortAllocScratch(list, 0);
+    uint8_t* src = list->Data;
+    uint8_t* dst = scratch;
+    for (uint32_t pass = 0; pass < key.Width; ++pass)
+    {
+        size_t* histogram = histograms[pass];
+        const uint32_t shift = pass * 8;
+        // every item has the same digit - nothing to move
+        if (histogram[(clistSortKeyBits(src, &key) >> shift) & 0xFF] == count)
+        {
+            continue;
+        }
+        size_t offset = 0;
+        for (uint32_t digit = 0; digit < 256; ++digit)
+        {
+            const size_t digitCount = histogram[digit];
+            histogram[digit] = offset;
+            offset += digitCount;
+        }
+        for (uint8_t* itr = src, *end = src + count * stride; itr != end; itr += stride)
+        {
+            const uint32_t digit = (uint32_t)(clistSortKeyBits(itr, &key) >> shift) & 0xFF;
+            clistSortCopyItem(dst + histogram[digit]++ * stride, itr, stride);
+        }
+        uint8_t* swap = src;
+        src = dst;
+        dst = swap;
+    }
+    if (src != list->Data)
+    {
+        memcpy(list->Data, src, count * stride);
+    }
+    clistSortFreeScratch(list, scratch, 0);
+}
+
+typedef struct CListSortRadixArgs
+{
+    CListSortKey Key;
+    uint8_t* Src;
+    uint8_t* Dst;
+    size_t Stride;
+    size_t Count;
+    uint32_t ThreadCount;
+    uint32_t Shift;
+    // per thread digit counts, then per thread digit offsets
+    size_t (*Histograms)[256];
+} CListSortRadixArgs;
+
+static inline void clistSortRadixChunk(CListSortRadixArgs* args, uint32_t index, uint8_t** begin, uint8_t** end)
+{
+    const size_t chunk = args->Count / args->ThreadCount;
+    const size_t first = chunk * index;
+    const size_t last = index + 1 == args->ThreadCount ? args->Count : first + chunk;
+    *begin = args->Src + first * args->Stride;
+    *end = args->Src + last * args->Stride;
+}
+
+static inline void clistSortRadixHistogramTask(void* argsPtr, uint32_t index)
+{
+    CListSortRadixArgs* args = (CListSortRadixArgs*)argsPtr;
+    size_t* histogram = args->Histograms[index];
+    uint8_t *itr, *end;
+    clistSortRadixChunk(args, index, &itr, &end);
+    memset(histogram, 0, sizeof(size_t) * 256);
+    for (; itr != end; itr += args->Stride)
+    {
+        ++histogram[(clistSortKeyBits(itr, &args->Key) >> args->Shift) & 0xFF];
+    }
+}
+
+static inline void clistSortRadixScatterTask(void* argsPtr, uint32_t index)
+{
+    CListSortRadixArgs* args = (CListSortRadixArgs*)argsPtr;
+    size_t* offsets = args->Histograms[index];
+    const size_t stride = args->Stride;
+    uint8_t *itr, *end;
+    clistSortRadixChunk(args, index, &itr, &end);
+    for (; itr != end; itr += stride)
+    {
+        const uint32_t digit = (uint32_t)(clistSortKeyBits(itr, &args->Key) >> args->Shift) & 0xFF;
+        clistSortCopyItem(args->Dst + offsets[digit]++ * stride, itr, stride);
+    }
+}
+
+void clistSortRadixParallel(CList* list, CSize keyOffset, CSize keyWidth, uint32_t keyType, uint32_t threadCount)
+{
+    threadCount = clistSortThreadCount(list->Count, threadCount);
+    if (threadCount < 2)
+    {
+        clistSortRadix(list, keyOffset, keyWidth, keyType);
+        return;
+    }
+    // histograms of every thread share the scratch allocation, ahead of the items copy
+    const size_t histogramsSize = sizeof(size_t) * 256 * threadCount;
+    uint8_t* scratch = clistSortAllocScratch(list, histogramsSize);
+    size_t (*histograms)[256] = (size_t (*)[256])scratch;
+    CListSortRadixArgs args;
+    args.Key = clistSortMakeKey(list, keyOffset, keyWidth, keyType);
+    args.Src = list->Data;
+    args.Dst = scratch + histogramsSize;
+    args.Stride = list->Stride;
+    args.Count = list->Count;
+    args.ThreadCount = threadCount;
+    args.Histograms = histograms;
+
+    // each pass counts digits per chunk, then scatters each chunk after the same digits of earlier chunks - stable
+    for (uint32_t pass = 0; pass < args.Key.Width; ++pass)
+    {
+        args.Shift = pass * 8;
+        clistSortRun(clistSortRadixHistogramTask, &args, threadCount);
+        size_t offset = 0;
+        uint32_t bTrivial = 0;
+        for (uint32_t digit = 0; digit < 256; ++digit)
+        {
+            size_t digitCount = 0;
+            for (uint32_t t = 0; t < threadCount; ++t)
+            {
+                const size_t chunkCount = histograms[t][digit];
+                histograms[t][digit] = offset;
+                offset += chunkCount;
+                digitCount += chunkCount;
+            }
+            bTrivial |= digitCount == args.Count;
+        }
+        if (bTrivial)
+        {
+            continue;
+        }
+        clistSortRun(clistSortRadixScatterTask, &args, threadCount);
+        uint8_t* swap = args.Src;
+        args.Src = args.Dst;
+        args.Dst = swap;
+    }
+    if (args.Src != list->Data)
+    {
+        memcpy(list->Data, args.Src, args.Count * args.Stride);
+    }
+    clistSortFreeScratch(list, scratch, histogramsSize);
+}
+
+//=======================================================================
+// comparator sorts
+
+static inline void clistSortInsertion(uint8_t* begin, uint8_t* end, size_t stride, CListCompare compare, void* context)
+{
+    for (uint8_t* itr = begin + stride; itr < end; itr += stride)
+    {
+        for (uint8_t* cur = itr; cur > begin && compare(cur, cur - stride, context) < 0; cur -= stride)
+        {
+            clistSortSwapItems(cur, cur - stride, stride);
+        }
+    }
+}
+
+static inline void clistSortSiftDown(uint8_t* data, size_t root, size_t count, size_t stride, CListCompare compare, void* context)
+{
+    for (size_t child = root * 2 + 1; child < count; root = child, child = root * 2 + 1)
+    {
+        if (child + 1 < count && compare(data + child * stride, data + (child + 1) * stride, context) < 0)
+        {
+            ++child;
+        }
+        if (compare(data + root * stride, data + child * stride, context) >= 0)
+        {
+            return;
+        }
+        clistSortSwapItems(data + root * stride, data + child * stride, stride);
+    }
+}
+
+static inline void clistSortHeap(uint8_t* data, size_t count, size_t stride, CListCompare compare, void* context)
+{
+    for (size_t i = count / 2; i-- > 0;)
+    {
+        clistSortSiftDown(data, i, count, stride, compare, context);
+    }
+    for (size_t last = count - 1; last > 0; --last)
+    {
+        clistSortSwapItems(data, data + last * stride, stride);
+        clistSortSiftDown(data, 0, last, stride, compare, context);
+    }
+}
+
+// quicksort recursing into the smaller side, heapsort past depthLimit, insertion sort for small ranges
+static inline void clistSortIntro(uint8_t* data, size_t count, size_t stride, CListCompare compare, void* context, uint32_t depthLimit)
+{
+    while (count > 16)
+    {
+        if (depthLimit-- == 0)
+        {
+            clistSortHeap(data, count, stride, compare, context);
+            return;
+        }
+        // median of 3 to the front as pivot
+        uint8_t* first = data;
+        uint8_t* mid = data + (count / 2) * stride;
+        uint8_t* last = data + (count - 1) * stride;
+        if (compare(mid, first, context) < 0) clistSortSwapItems(mid, first, stride);
+        if (compare(last, mid, context) < 0) clistSortSwapItems(last, mid, stride);
+        if (compare(mid, first, context) < 0) clistSortSwapItems(mid, first, stride);
+        clistSortSwapItems(first, mid, stride);
+
+        // Hoare partition around the pivot at data
+        size_t i = 0;
+        size_t j = count;
+        for (;;)
+        {
+            do { ++i; } while (i < count && compare(data + i * stride, data, context) < 0);
+            do { --j; } while (compare(data, data + j * stride, context) < 0);
+            if (i >= j)
+            {
+                break;
+            }
+            clistSortSwapItems(data + i * stride, data + j * stride, stride);
+        }
+        if (j)
+        {
+            clistSortSwapItems(data, data + j * stride, stride);
+        }
+
+        const size_t leftCount = j;
+        const size_t rightCount = count - j - 1;
+        if (leftCount < rightCount)
+        {
+            clistSortIntro(data, leftCount, stride, compare, context, depthLimit);
+            data += (j + 1) * stride;
+            count = rightCount;
+        }
+        else
+        {
+            clistSortIntro(data + (j + 1) * stride, rightCount, stride, compare, context, depthLimit);
+            count = leftCount;
+        }
+    }
+    clistSortInsertion(data, data + count * stride, stride, compare, context);
+}
+
+void clistSort(CList* list, CListCompare compare, void* context)
+{
+    uint32_t depthLimit = 0;
+    for (size_t count = list->Count; count > 1; count >>= 1)
+    {
+        depthLimit += 2;
+    }
+    clistSortIntro(list->Data, list->Count, list->Stride, compare, context, depthLimit);
+}
+
+// merge sorted a and b into dst, a first on ties - stable
+static inline void clistSortMerge(uint8_t* dst, const uint8_t* a, const uint8_t* aEnd, const uint8_t* b, const uint8_t* bEnd,
+    size_t stride, CListCompare compare, void* context)
+{
+    while (a != aEnd && b != bEnd)
+    {
+        if (compare(b, a, context) < 0)
+        {
+            clistSortCopyItem(dst, b, stride);
+            b += stride;
+        }
+        else
+        {
+            clistSortCopyItem(dst, a, stride);
+            a += stride;
+        }
+        dst += stride;
+    }
+    memcpy(dst, a, (size_t)(aEnd - a));
+    memcpy(dst + (aEnd - a), b, (size_t)(bEnd - b));
+}
+
+// bottom up merge sort of count items, sorted result left in data
+static inline void clistSortMergeRange(uint8_t* data, uint8_t* scratch, size_t count, size_t stride, CListCompare compare, void* context)
+{
+    const size_t run = 16;
+    for (size_t first = 0; first < count; first += run)
+    {
+        const size_t last = first + run < count ? first + run : count;
+        clistSortInsertion(data + first * stride, data + last * stride, stride, compare, context);
+    }
+    uint8_t* src = data;
+    uint8_t* dst = scratch;
+    for (size_t width = run; width < count; width *= 2)
+    {
+        for (size_t first = 0; first < count; first += width * 2)
+        {
+            const size_t mid = first + width < count ? first + width : count;
+            const size_t last = first + width * 2 < count ? first + width * 2 : count;
+            clistSortMerge(dst + first * stride, src + first * stride, src + mid * stride, src + mid * stride, src + last * stride,
+                stride, compare, context);
+        }
+        uint8_t* swap = src;
+        src = dst;
+        dst = swap;
+    }
+    if (src != data)
+    {
+        memcpy(data, src, count * stride);
+    }
+}
+
+void clistSortStable(CList* list, CListCompare compare, void* context)
+{
+    if (list->Count < 2)
+    {
+        return;
+    }
+    uint8_t* scratch = clistSortAllocScratch(list, 0);
+    clistSortMergeRange(list->Data, scratch, list->Count, list->Stride, compare, context);
+    clistSortFreeScratch(list, scratch, 0);
+}
+
+typedef struct CListSortMergeArgs
+{
+    uint8_t* Src;
+    uint8_t* Dst;
+    size_t Stride;
+    CListCompare Compare;
+    void* Context;
+    // item index where each sorted chunk begins, plus the end
+    size_t Bounds[CLIST_SORT_MAX_THREADS + 1];
+    uint32_t ChunkCount;
+} CListSortMergeArgs;
+
+static inline void clistSortChunkTask(void* argsPtr, uint32_t index)
+{
+    CListSortMergeArgs* args = (CListSortMergeArgs*)argsPtr;
+    const size_t first = args->Bounds[index];
+    const size_t count = args->Bounds[index + 1] - first;
+    clistSortMergeRange(args->Src + first * args->Stride, args->Dst + first * args->Stride, count, args->Stride, args->Compare, args->Context);
+}
+
+static inline void clistSortMergeTask(void* argsPtr, uint32_t index)
+{
+    CListSortMergeArgs* args = (CListSortMergeArgs*)argsPtr;
+    const size_t stride = args->Stride;
+    const uint32_t chunk = index * 2;
+    const size_t first = args->Bounds[chunk];
+    const size_t mid = args->Bounds[chunk + 1];
+    const size_t last = chunk + 2 <= args->ChunkCount ? args->Bounds[chunk + 2] : mid;
+    clistSortMerge(args->Dst + first * stride, args->Src + first * stride, args->Src + mid * stride, args->Src + mid * stride,
+        args->Src + last * stride, stride, args->Compare, args->Context);
+}
+
+void clistSortStableParallel(CList* list, CListCompare compare, void* context, uint32_t threadCount)
+{
+    threadCount = clistSortThreadCount(list->Count, threadCount);
+    if (threadCount < 2)
+    {
+        clistSortStable(list, compare, context);
+        return;
+    }
+    CListSortMergeArgs args;
+    args.Src = list->Data;
+    args.Dst = clistSortAllocScratch(list, 0);
+    args.Stride = list->Stride;
+    args.Compare = compare;
+    args.Context = context;
+    args.ChunkCount = threadCount;
+    uint8_t* scratch = args.Dst;
+    const size_t chunk = list->Count / threadCount;
+    for (uint32_t i = 0; i < threadCount; ++i)
+    {
+        args.Bounds[i] = chunk * i;
+    }
+    args.Bounds[threadCount] = list->Count;
+
+    // sort chunks, then merge pairs of neighbours in parallel until one remains
+    clistSortRun(clistSortChunkTask, &args, threadCount);
+    while (args.ChunkCount > 1)
+    {
+        const uint32_t pairCount = (args.ChunkCount + 1) / 2;
+        clistSortRun(clistSortMergeTask, &args, pairCount);
+        for (uint32_t i = 0; i < pairCount; ++i)
+        {
+            args.Bounds[i] = args.Bounds[i * 2];
+        }
+        args.Bounds[pairCount] = list->Count;
+        args.ChunkCount = pairCount;
+        uint8_t* swap = args.Src;
+        args.Src = args.Dst;
+        args.Dst = swap;
+    }
+    if (args.Src != list->Data)
+    {
+        memcpy(list->Data, args.Src, (size_t)list->Count * list->Stride);
+    }
+    clistSortFreeScratch(list, scratch, 0);
+}
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
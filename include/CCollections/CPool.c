@@ -1,4 +1,5 @@
 #include "CTypes.h"
+#include "CAllocator.h"
 #include <stdint.h>
 #include <malloc.h>
 #include <string.h>
@@ -16,7 +17,7 @@ typedef CContainerEx CPool;
 // - allocates from a free list, re-allocates on capacity exceeded
 // - indices are unstable, order is not preserved, caller can obtain changes on relevant function calls
 
-void cpoolAlloc(CPool* pool, uint32_t stride, uint32_t capacity)
+void cpoolAllocEx(CPool* pool, CSize stride, CSize capacity, const CAllocator* allocator)
 {
     if (!CCOLLECTIONS_IS_POW2(capacity))
     {
@@ -27,14 +28,15 @@ void cpoolAlloc(CPool* pool, uint32_t stride, uint32_t capacity)
     pool->Base.Capacity = capacity;
     pool->Base.Stride = stride;
     
-    uint32_t size = stride * capacity;
-    pool->Base.Data = (uint8_t*)_mm_malloc(size, CCOLLECTIONS_ALIGNMENT);
+    CSize size = stride * capacity;
+    pool->Base.Allocator = allocator;
+    pool->Base.Data = (uint8_t*)callocatorAlloc(allocator, size);
     pool->Base.Type = CCOLLECTION_TYPE_POOL;
 
     // init free linked list
     CFreeHeader* itr = (CFreeHeader*)pool->Base.Data;
     CFreeHeader* last = (CFreeHeader*)((uint8_t*)itr + size - stride);
-    uint32_t next = stride;
+    CSize next = stride;
     while (itr != last)
     {
         itr->Next = next;
@@ -45,9 +47,14 @@ void cpoolAlloc(CPool* pool, uint32_t stride, uint32_t capacity)
 
 }
 
+void cpoolAlloc(CPool* pool, CSize stride, CSize capacity)
+{
+    cpoolAllocEx(pool, stride, capacity, callocatorDefault());
+}
+
 void cpoolFree(CPool* pool)
 {
-    _mm_free(pool->Base.Data);
+    callocatorFree(pool->Base.Allocator, pool->Base.Data, (size_t)pool->Base.Capacity * pool->Base.Stride);
 }
 
 uint8_t* cpoolBegin(CPool* pool)
@@ -57,7 +64,7 @@ uint8_t* cpoolBegin(CPool* pool)
 
 uint8_t* cpoolEnd(CPool* pool)
 {
-    uint32_t offset = pool->Base.Capacity * pool->Base.Stride;
+    CSize offset = pool->Base.Capacity * pool->Base.Stride;
     return pool->Base.Data + offset;
 }
 
@@ -66,26 +73,26 @@ uint8_t* cpoolLast(CPool* pool)
     return pool->Base.Data + pool->Last;
 }
 
-uint8_t* cpoolItemAt(CPool* pool, uint32_t index)
+uint8_t* cpoolItemAt(CPool* pool, CSize index)
 {
-    uint32_t offset = pool->Base.Stride * index;
+    CSize offset = pool->Base.Stride * index;
     return pool->Base.Data + offset;
 }
 
-//void cpoolRemoveAt_Sparse(CPool* pool, uint32_t index)
+//void cpoolRemoveAt_Sparse(CPool* pool, CSize index)
 //{
 //    CFreeHeader* remove = (CFreeHeader*)cpoolItemAt(pool, index);
 //    CFreeHeader* last = (CFreeHeader*)cpoolLast(pool);
 //    // move remove to free
 //    remove->Next = pool->Free;
-//    pool->Free = (uint32_t)((uint8_t*)remove - pool->Base.Data);
+//    pool->Free = (CSize)((uint8_t*)remove - pool->Base.Data);
 //    --pool->Base.Count;
 //}
 
 struct CPoolIndexChange
 {
-    uint32_t From;
-    uint32_t To;
+    CSize From;
+    CSize To;
 };
 
 void cpoolRemoveLast(CPool* pool)
@@ -94,12 +101,12 @@ void cpoolRemoveLast(CPool* pool)
     
     // move last to free
     last->Next = pool->Free;
-    pool->Free = (uint32_t)((uint8_t*)last - pool->Base.Data);
+    pool->Free = (CSize)((uint8_t*)last - pool->Base.Data);
     
     --pool->Base.Count;
 }
 
-void cpoolRemoveAt(CPool* pool, uint32_t index)
+void cpoolRemoveAt(CPool* pool, CSize index)
 {
     CFreeHeader* remove = (CFreeHeader*)cpoolItemAt(pool, index);
     CFreeHeader* last = (CFreeHeader*)cpoolLast(pool);
@@ -114,7 +121,7 @@ void cpoolRemoveAt(CPool* pool, uint32_t index)
     //notify.To = index;
 }
 
-void cpoolAddRange(CPool* pool, uint32_t index)
+void cpoolAddRange(CPool* pool, CSize index)
 {
 
 }
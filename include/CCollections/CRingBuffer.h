@@ -0,0 +1,288 @@
+// MIT License - CCollections
+// Copyright(c) 2020 Dante Falcone (dantefalcone@gmail.com)
+#pragma once
+#include "CTypes.h"
+#include "CAtomic.h"
+#include "CAllocator.h"
+#include <string.h>
+#include <assert.h>
+
+/*  CRingBuffer
+
+    Lock-free bounded queues of fixed stride items, for passing work between threads
+    CSpscRing - one producer and one consumer thread, each side caches the other's index and touches it only when full or empty
+    CMpmcRing - any number of producers and consumers, slots claimed by compare exchange and published by per item sequence numbers
+    Read and write indices sit on their own cache lines, batch push and pop copy many items per index update
+    Indices are 32 bit and wrap, capacity is rounded up to a power of 2 no larger than CRING_MAX_CAPACITY
+*/
+
+#define CRING_MAX_CAPACITY 0x80000000u
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+static inline void cspscringAlloc(CSpscRing* ring, CSize stride, CSize capacity);
+static inline void cspscringAllocEx(CSpscRing* ring, CSize stride, CSize capacity, const CAllocator* allocator);
+static inline void cspscringFree(CSpscRing* ring);
+// producer only - returns 0 if full
+static inline uint32_t cspscringPush(CSpscRing* ring, void* item);
+// producer only - pushes as many of itemsCount as fit, returns number pushed
+static inline CSize cspscringPushRange(CSpscRing* ring, void* items, CSize itemsCount);
+// consumer only - returns 0 if empty
+static inline uint32_t cspscringPop(CSpscRing* ring, void* item);
+// consumer only - pops up to maxCount items, returns number popped
+static inline CSize cspscringPopRange(CSpscRing* ring, void* items, CSize maxCount);
+// exact from either side when the other is idle, a snapshot otherwise
+static inline CSize cspscringCount(CSpscRing* ring);
+
+static inline void cmpmcringAlloc(CMpmcRing* ring, CSize stride, CSize capacity);
+static inline void cmpmcringAllocEx(CMpmcRing* ring, CSize stride, CSize capacity, const CAllocator* allocator);
+static inline void cmpmcringFree(CMpmcRing* ring);
+// returns 0 if full
+static inline uint32_t cmpmcringPush(CMpmcRing* ring, void* item);
+// claims up to itemsCount consecutive free slots at once, returns number pushed
+static inline CSize cmpmcringPushRange(CMpmcRing* ring, void* items, CSize itemsCount);
+// returns 0 if empty
+static inline uint32_t cmpmcringPop(CMpmcRing* ring, void* item);
+// claims up to maxCount consecutive full slots at once, returns number popped
+static inline CSize cmpmcringPopRange(CMpmcRing* ring, void* items, CSize maxCount);
+// snapshot, may count items still being written or read
+static inline CSize cmpmcringCount(CMpmcRing* ring);
+
+
+
+static inline CSize cringRoundCapacity(CSize capacity)
+{
+    assert(capacity > 0 && capacity <= CRING_MAX_CAPACITY && "CRingBuffer capacity out of range");
+    if (!CCOLLECTIONS_IS_POW2(capacity))
+    {
+        CCOLLECTIONS_SET_NEXT_POW2(capacity);
+    }
+    return capacity;
+}
+
+// copy items into the ring at a wrapping index, split in two where it wraps
+static inline void cringCopyIn(CContainer* base, uint32_t index, const uint8_t* items, uint32_t count)
+{
+    const uint32_t capacity = (uint32_t)base->Capacity;
+    const size_t stride = base->Stride;
+    const uint32_t first = index & (capacity - 1);
+    const uint32_t firstCount = count < capacity - first ? count : capacity - first;
+    memcpy(base->Data + first * stride, items, firstCount * stride);
+    memcpy(base->Data, items + firstCount * stride, (count - firstCount) * stride);
+}
+
+static inline void cringCopyOut(CContainer* base, uint32_t index, uint8_t* items, uint32_t count)
+{
+    const uint32_t capacity = (uint32_t)base->Capacity;
+    const size_t stride = base->Stride;
+    const uint32_t first = index & (capacity - 1);
+    const uint32_t firstCount = count < capacity - first ? count : capacity - first;
+    memcpy(items, base->Data + first * stride, firstCount * stride);
+    memcpy(items + firstCount * stride, base->Data, (count - firstCount) * stride);
+}
+
+//=======================================================================
+// CSpscRing
+
+void cspscringAlloc(CSpscRing* ring, CSize stride, CSize capacity)
+{
+    cspscringAllocEx(ring, stride, capacity, callocatorDefault());
+}
+
+void cspscringAllocEx(CSpscRing* ring, CSize stride, CSize capacity, const CAllocator* allocator)
+{
+    memset(ring, 0, sizeof(CSpscRing));
+    ring->Base.Capacity = cringRoundCapacity(capacity);
+    ring->Base.Stride = stride;
+    ring->Base.Allocator = allocator;
+    ring->Base.Data = (uint8_t*)callocatorAlloc(allocator, (size_t)stride * ring->Base.Capacity);
+    assert(ring->Base.Data);
+    ring->Base.Type = CCOLLECTION_TYPE_RING_SPSC;
+}
+
+void cspscringFree(CSpscRing* ring)
+{
+    callocatorFree(ring->Base.Allocator, ring->Base.Data, (size_t)ring->Base.Stride * ring->Base.Capacity);
+}
+
+uint32_t cspscringPush(CSpscRing* ring, void* item)
+{
+    return cspscringPushRange(ring, item, 1) == 1;
+}
+
+CSize cspscringPushRange(CSpscRing* ring, void* items, CSize itemsCount)
+{
+    const uint32_t capacity = (uint32_t)ring->Base.Capacity;
+    const uint32_t tail = ring->Tail;
+    uint32_t free = capacity - (tail - ring->HeadCache);
+    if (free < itemsCount)
+    {
+        ring->HeadCache = catomicLoadAcquire32(&ring->Head);
+        free = capacity - (tail - ring->HeadCache);
+    }
+    const uint32_t count = itemsCount < free ? (uint32_t)itemsCount : free;
+    if (count)
+    {
+        cringCopyIn(&ring->Base, tail, (const uint8_t*)items, count);
+        catomicStoreRelease32(&ring->Tail, tail + count);
+    }
+    return count;
+}
+
+uint32_t cspscringPop(CSpscRing* ring, void* item)
+{
+    return cspscringPopRange(ring, item, 1) == 1;
+}
+
+CSize cspscringPopRange(CSpscRing* ring, void* items, CSize maxCount)
+{
+    const uint32_t head = ring->Head;
+    uint32_t used = ring->TailCache - head;
+    if (used < maxCount)
+    {
+        ring->TailCache = catomicLoadAcquire32(&ring->Tail);
+        used = ring->TailCache - head;
+    }
+    const uint32_t count = maxCount < used ? (uint32_t)maxCount : used;
+    if (count)
+    {
+        cringCopyOut(&ring->Base, head, (uint8_t*)items, count);
+        catomicStoreRelease32(&ring->Head, head + count);
+    }
+    return count;
+}
+
+CSize cspscringCount(CSpscRing* ring)
+{
+    const uint32_t head = catomicLoadAcquire32(&ring->Head);
+    return catomicLoadAcquire32(&ring->Tail) - head;
+}
+
+//=======================================================================
+// CMpmcRing
+// - slot i of lap n holds sequence n * capacity + i while free and that + 1 while full
+// - producers claim slots whose sequence equals the write index, consumers slots whose sequence is one past the read index
+
+static inline size_t cmpmcringItemsSize(CSize stride, CSize capacity)
+{
+    return ((size_t)stride * capacity + CCOLLECTIONS_CACHE_LINE_ALIGNMENT - 1) & ~(size_t)(CCOLLECTIONS_CACHE_LINE_ALIGNMENT - 1);
+}
+
+void cmpmcringAlloc(CMpmcRing* ring, CSize stride, CSize capacity)
+{
+    cmpmcringAllocEx(ring, stride, capacity, callocatorDefault());
+}
+
+void cmpmcringAllocEx(CMpmcRing* ring, CSize stride, CSize capacity, const CAllocator* allocator)
+{
+    memset(ring, 0, sizeof(CMpmcRing));
+    capacity = cringRoundCapacity(capacity);
+    const size_t itemsSize = cmpmcringItemsSize(stride, capacity);
+    ring->Base.Capacity = capacity;
+    ring->Base.Stride = stride;
+    ring->Base.Allocator = allocator;
+    ring->Base.Data = (uint8_t*)callocatorAlloc(allocator, itemsSize + sizeof(uint32_t) * (size_t)capacity);
+    assert(ring->Base.Data);
+    ring->Base.Type = CCOLLECTION_TYPE_RING_MPMC;
+    ring->Sequences = (volatile uint32_t*)(ring->Base.Data + itemsSize);
+    for (uint32_t i = 0; i < (uint32_t)capacity; ++i)
+    {
+        ring->Sequences[i] = i;
+    }
+}
+
+void cmpmcringFree(CMpmcRing* ring)
+{
+    const size_t itemsSize = cmpmcringItemsSize(ring->Base.Stride, ring->Base.Capacity);
+    callocatorFree(ring->Base.Allocator, ring->Base.Data, itemsSize + sizeof(uint32_t) * (size_t)ring->Base.Capacity);
+}
+
+uint32_t cmpmcringPush(CMpmcRing* ring, void* item)
+{
+    return cmpmcringPushRange(ring, item, 1) == 1;
+}
+
+CSize cmpmcringPushRange(CMpmcRing* ring, void* items, CSize itemsCount)
+{
+    const uint32_t mask = (uint32_t)ring->Base.Capacity - 1;
+    uint32_t tail = catomicLoadAcquire32(&ring->Tail);
+    for (;;)
+    {
+        uint32_t count = 0;
+        while (count < itemsCount && catomicLoadAcquire32(&ring->Sequences[(tail + count) & mask]) == tail + count)
+        {
+            ++count;
+        }
+        if (count == 0)
+        {
+            // slot still holds an item from the last lap - full, otherwise tail is stale
+            const uint32_t sequence = catomicLoadAcquire32(&ring->Sequences[tail & mask]);
+            if ((int32_t)(sequence - tail) < 0)
+            {
+                return 0;
+            }
+        }
+        else if (catomicCompareExchange32(&ring->Tail, tail, tail + count))
+        {
+            cringCopyIn(&ring->Base, tail, (const uint8_t*)items, count);
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                catomicStoreRelease32(&ring->Sequences[(tail + i) & mask], tail + i + 1);
+            }
+            return count;
+        }
+        tail = catomicLoadAcquire32(&ring->Tail);
+    }
+}
+
+uint32_t cmpmcringPop(CMpmcRing* ring, void* item)
+{
+    return cmpmcringPopRange(ring, item, 1) == 1;
+}
+
+CSize cmpmcringPopRange(CMpmcRing* ring, void* items, CSize maxCount)
+{
+    const uint32_t capacity = (uint32_t)ring->Base.Capacity;
+    const uint32_t mask = capacity - 1;
+    uint32_t head = catomicLoadAcquire32(&ring->Head);
+    for (;;)
+    {
+        uint32_t count = 0;
+        while (count < maxCount && catomicLoadAcquire32(&ring->Sequences[(head + count) & mask]) == head + count + 1)
+        {
+            ++count;
+        }
+        if (count == 0)
+        {
+            // slot not yet written this lap - empty, otherwise head is stale
+            const uint32_t sequence = catomicLoadAcquire32(&ring->Sequences[head & mask]);
+            if ((int32_t)(sequence - (head + 1)) < 0)
+            {
+                return 0;
+            }
+        }
+        else if (catomicCompareExchange32(&ring->Head, head, head + count))
+        {
+            cringCopyOut(&ring->Base, head, (uint8_t*)items, count);
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                catomicStoreRelease32(&ring->Sequences[(head + i) & mask], head + i + capacity);
+            }
+            return count;
+        }
+        head = catomicLoadAcquire32(&ring->Head);
+    }
+}
+
+CSize cmpmcringCount(CMpmcRing* ring)
+{
+    const uint32_t head = catomicLoadAcquire32(&ring->Head);
+    const uint32_t count = catomicLoadAcquire32(&ring->Tail) - head;
+    return (int32_t)count < 0 ? 0 : count;
+}
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
@@ -0,0 +1,122 @@
+// MIT License - CCollections
+// Copyright(c) 2020 Dante Falcone (dantefalcone@gmail.com)
+#pragma once
+#include <stdint.h>
+
+/*  CSimd
+
+    Runtime detection of x86 vector instruction sets, for containers with vectorized kernels
+    Kernels for wider instruction sets are compiled with per function target attributes, no global -mavx2 needed
+    Define CSIMD_MAX_LEVEL to cap the level used, 0 for scalar only
+*/
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #define CSIMD_X86
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #endif
+    #include <immintrin.h>
+#endif
+
+// target attributes for kernels using instructions above the compiler baseline - MSVC allows any intrinsic without them
+#if defined(CSIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+    #define CSIMD_TARGET_AVX2 __attribute__((target("avx2")))
+    #define CSIMD_TARGET_AVX512 __attribute__((target("avx512f,avx512bw")))
+#else
+    #define CSIMD_TARGET_AVX2
+    #define CSIMD_TARGET_AVX512
+#endif
+
+enum CSIMD_LEVEL
+{
+    CSIMD_LEVEL_SCALAR,
+    CSIMD_LEVEL_SSE2,
+    CSIMD_LEVEL_AVX2,
+    // AVX-512 F and BW
+    CSIMD_LEVEL_AVX512,
+};
+
+#ifndef CSIMD_MAX_LEVEL
+#define CSIMD_MAX_LEVEL CSIMD_LEVEL_AVX512
+#endif // !CSIMD_MAX_LEVEL
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+// highest level supported by cpu and os, detected once
+static inline uint32_t csimdLevel(void);
+// use a lower level than detected, for benchmarks - clamped to the detected level
+static inline void csimdSetLevel(uint32_t level);
+// index of lowest set bit, mask must not be 0
+static inline uint32_t csimdCtz64(uint64_t mask);
+
+
+
+static inline uint32_t csimdDetectLevel(void)
+{
+#if defined(CSIMD_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    const int bOsxsave = (info[2] >> 27) & 1;
+    const int bAvx = (info[2] >> 28) & 1;
+    if (!bOsxsave || !bAvx)
+        return CSIMD_LEVEL_SSE2;
+    const unsigned long long xcr0 = _xgetbv(0);
+    __cpuidex(info, 7, 0);
+    if ((xcr0 & 0xE6) == 0xE6 && ((info[1] >> 16) & 1) && ((info[1] >> 30) & 1))
+        return CSIMD_LEVEL_AVX512;
+    if ((xcr0 & 0x6) == 0x6 && ((info[1] >> 5) & 1))
+        return CSIMD_LEVEL_AVX2;
+    return CSIMD_LEVEL_SSE2;
+#elif defined(CSIMD_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+        return CSIMD_LEVEL_AVX512;
+    if (__builtin_cpu_supports("avx2"))
+        return CSIMD_LEVEL_AVX2;
+    return CSIMD_LEVEL_SSE2;
+#else
+    return CSIMD_LEVEL_SCALAR;
+#endif
+}
+
+// cached level - one per translation unit, detection is cheap
+static inline uint32_t* csimdLevelState(void)
+{
+    static uint32_t level = (uint32_t)-1;
+    return &level;
+}
+
+uint32_t csimdLevel(void)
+{
+    uint32_t* level = csimdLevelState();
+    if (*level == (uint32_t)-1)
+    {
+        uint32_t detected = csimdDetectLevel();
+        *level = detected < (uint32_t)CSIMD_MAX_LEVEL ? detected : (uint32_t)CSIMD_MAX_LEVEL;
+    }
+    return *level;
+}
+
+void csimdSetLevel(uint32_t level)
+{
+    *csimdLevelState() = (uint32_t)-1;
+    uint32_t detected = csimdLevel();
+    *csimdLevelState() = level < detected ? level : detected;
+}
+
+uint32_t csimdCtz64(uint64_t mask)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, mask);
+    return (uint32_t)index;
+#else
+    return (uint32_t)__builtin_ctzll(mask);
+#endif
+}
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
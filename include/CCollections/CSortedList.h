@@ -0,0 +1,179 @@
+// MIT License - CCollections
+// Copyright(c) 2020 Dante Falcone (dantefalcone@gmail.com)
+#pragma once
+#include "CListSort.h"
+
+/*  CSortedList
+
+    CList kept in order by a comparator - sort it once with CListSort, then use these instead of the unsorted
+    find, insert and remove functions
+    Lookups are binary searches, batches are sorted and merged in one pass instead of one memmove per item
+    Equal items keep insertion order, batch removes take one matching item per batch item
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+// index of the first item not less than item, Count if none
+static inline CSize clistSortedLowerBound(CList* list, void* item, CListCompare compare, void* context);
+// index of the first item greater than item, Count if none
+static inline CSize clistSortedUpperBound(CList* list, void* item, CListCompare compare, void* context);
+// index of the first equal item, CCOLLECTION_NOT_FOUND if none
+static inline CSize clistSortedFindIndex(CList* list, void* item, CListCompare compare, void* context);
+// insert after equal items, growing the list if full - returns index inserted at
+static inline CSize clistSortedInsert(CList* list, void* item, CListCompare compare, void* context);
+// sort a copy of items and merge it in from the back, moving each list item at most once
+static inline void clistSortedInsertRange(CList* list, void* items, CSize itemsCount, CListCompare compare, void* context);
+// returns 1 if an equal item was found and removed
+static inline uint32_t clistSortedRemove(CList* list, void* item, CListCompare compare, void* context);
+// remove one equal item per item in items, compacting the list in one pass - returns number removed
+static inline CSize clistSortedRemoveRange(CList* list, void* items, CSize itemsCount, CListCompare compare, void* context);
+
+
+
+// first index in [first, last) where bUpper ? item < data[index] : item <= data[index]
+static inline size_t clistSortedBound(const uint8_t* data, size_t stride, size_t first, size_t last, const void* item,
+    uint32_t bUpper, CListCompare compare, void* context)
+{
+    size_t count = last - first;
+    while (count)
+    {
+        const size_t half = count / 2;
+        const size_t mid = first + half;
+        const int order = compare(data + mid * stride, item, context);
+        if (order < 0 || (bUpper && order == 0))
+        {
+            first = mid + 1;
+            count -= half + 1;
+        }
+        else
+        {
+            count = half;
+        }
+    }
+    return first;
+}
+
+CSize clistSortedLowerBound(CList* list, void* item, CListCompare compare, void* context)
+{
+    return (CSize)clistSortedBound(list->Data, list->Stride, 0, list->Count, item, 0, compare, context);
+}
+
+CSize clistSortedUpperBound(CList* list, void* item, CListCompare compare, void* context)
+{
+    return (CSize)clistSortedBound(list->Data, list->Stride, 0, list->Count, item, 1, compare, context);
+}
+
+CSize clistSortedFindIndex(CList* list, void* item, CListCompare compare, void* context)
+{
+    const CSize index = clistSortedLowerBound(list, item, compare, context);
+    if (index == list->Count || compare(list->Data + (size_t)index * list->Stride, item, context) != 0)
+    {
+        return CCOLLECTION_NOT_FOUND;
+    }
+    return index;
+}
+
+CSize clistSortedInsert(CList* list, void* item, CListCompare compare, void* context)
+{
+    const CSize index = clistSortedUpperBound(list, item, compare, context);
+    clistEnsureCapacity(list, list->Count + 1);
+    const size_t stride = list->Stride;
+    uint8_t* dst = list->Data + index * stride;
+    memmove(dst + stride, dst, (list->Count - index) * stride);
+    memcpy(dst, item, stride);
+    ++list->Count;
+    return index;
+}
+
+// sorted copy of items, stable so equal items keep their batch order
+static inline uint8_t* clistSortedBatch(CList* list, void* items, CSize itemsCount, CListCompare compare, void* context)
+{
+    const size_t size = (size_t)list->Stride * itemsCount;
+    uint8_t* batch = (uint8_t*)callocatorAlloc(list->Allocator, size * 2);
+    assert(batch);
+    memcpy(batch, items, size);
+    clistSortMergeRange(batch, batch + size, itemsCount, list->Stride, compare, context);
+    return batch;
+}
+
+void clistSortedInsertRange(CList* list, void* items, CSize itemsCount, CListCompare compare, void* context)
+{
+    if (itemsCount == 0)
+    {
+        return;
+    }
+    uint8_t* batch = clistSortedBatch(list, items, itemsCount, compare, context);
+    clistEnsureCapacity(list, list->Count + itemsCount);
+    const size_t stride = list->Stride;
+    uint8_t* data = list->Data;
+    // list items in [0, end) are still in place, everything from dst up is merged
+    size_t end = list->Count;
+    size_t dst = end + itemsCount;
+    for (size_t i = itemsCount; i-- > 0;)
+    {
+        const uint8_t* item = batch + i * stride;
+        const size_t first = clistSortedBound(data, stride, 0, end, item, 1, compare, context);
+        const size_t run = end - first;
+        dst -= run;
+        memmove(data + dst * stride, data + first * stride, run * stride);
+        --dst;
+        memcpy(data + dst * stride, item, stride);
+        end = first;
+    }
+    list->Count += itemsCount;
+    callocatorFree(list->Allocator, batch, (size_t)list->Stride * itemsCount * 2);
+}
+
+uint32_t clistSortedRemove(CList* list, void* item, CListCompare compare, void* context)
+{
+    const CSize index = clistSortedFindIndex(list, item, compare, context);
+    if (index == CCOLLECTION_NOT_FOUND)
+    {
+        return 0;
+    }
+    clistRemoveAt(list, index);
+    return 1;
+}
+
+CSize clistSortedRemoveRange(CList* list, void* items, CSize itemsCount, CListCompare compare, void* context)
+{
+    if (itemsCount == 0 || list->Count == 0)
+    {
+        return 0;
+    }
+    uint8_t* batch = clistSortedBatch(list, items, itemsCount, compare, context);
+    const size_t stride = list->Stride;
+    const size_t count = list->Count;
+    uint8_t* data = list->Data;
+    // kept items in [0, write), unvisited items from read
+    size_t read = 0;
+    size_t write = 0;
+    for (size_t i = 0; i < itemsCount && read < count; ++i)
+    {
+        const uint8_t* item = batch + i * stride;
+        const size_t index = clistSortedBound(data, stride, read, count, item, 0, compare, context);
+        if (index == count || compare(data + index * stride, item, context) != 0)
+        {
+            continue;
+        }
+        if (write != read)
+        {
+            memmove(data + write * stride, data + read * stride, (index - read) * stride);
+        }
+        write += index - read;
+        read = index + 1;
+    }
+    if (write != read)
+    {
+        memmove(data + write * stride, data + read * stride, (count - read) * stride);
+    }
+    list->Count = (CSize)(write + count - read);
+    callocatorFree(list->Allocator, batch, stride * itemsCount * 2);
+    return (CSize)(count - list->Count);
+}
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
@@ -5,20 +5,59 @@
 #ifndef CCOLLECTIONS_CTYPES_H
 #define CCOLLECTIONS_CTYPES_H
 
+#if !defined(_WIN32)
+    // every container header includes this first, so CVirtualMemory.h sees MAP_ANONYMOUS, madvise and mremap in strict ISO C
+    #ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+    #endif
+    #ifndef _DEFAULT_SOURCE
+    #define _DEFAULT_SOURCE
+    #endif
+#endif
+
 #include <stdint.h>
+#include <stddef.h>
 
 #ifndef CCOLLECTIONS_ALIGNMENT
-// default align to common cache line
+// page alignment of containers of at least this many bytes, see callocatorAlignment
 // redefine this manually for platforms that differ
 #define CCOLLECTIONS_ALIGNMENT 4096
 #endif // !CCOLLECTIONS_ALIGNMENT
 
+#ifndef CCOLLECTIONS_CACHE_LINE_ALIGNMENT
+// alignment of containers smaller than CCOLLECTIONS_ALIGNMENT bytes
+#define CCOLLECTIONS_CACHE_LINE_ALIGNMENT 64
+#endif // !CCOLLECTIONS_CACHE_LINE_ALIGNMENT
+
+#ifndef CCOLLECTIONS_HUGE_PAGE_BYTES
+// containers of at least this many bytes align to CCOLLECTIONS_HUGE_PAGE_ALIGNMENT and request transparent huge pages - 0 to disable
+#define CCOLLECTIONS_HUGE_PAGE_BYTES 0
+#endif // !CCOLLECTIONS_HUGE_PAGE_BYTES
+
+#ifndef CCOLLECTIONS_HUGE_PAGE_ALIGNMENT
+#define CCOLLECTIONS_HUGE_PAGE_ALIGNMENT 0x200000
+#endif // !CCOLLECTIONS_HUGE_PAGE_ALIGNMENT
+
+#ifdef CCOLLECTIONS_SIZE64
+// counts, capacities, strides and offsets of containers - 64 bit for collections over 4 GB
+typedef uint64_t CSize;
+#define CCOLLECTIONS_SIZE_MAX UINT64_MAX
+#else
+// counts, capacities, strides and offsets of containers - 32 bit by default for cache dense container headers
+typedef uint32_t CSize;
+#define CCOLLECTIONS_SIZE_MAX UINT32_MAX
+#endif // CCOLLECTIONS_SIZE64
+
+// index returned by finds when no item matched, as wide as CSize so no valid index can equal it
+#define CCOLLECTION_NOT_FOUND ((CSize)CCOLLECTIONS_SIZE_MAX)
+
 #ifndef CCOLLECTIONS_IS_POW2
 #define CCOLLECTIONS_IS_POW2(x) ( (x & (x - 1)) == 0 )
 #endif // !CCOLLECTIONS_IS_POW2
 
 #ifndef CCOLLECTIONS_SET_NEXT_POW2
-#define CCOLLECTIONS_SET_NEXT_POW2(x) { --x; x|=x>>1; x|=x>>2; x|=x>>4; x|=x>>8; x|=x>>16; ++x; }
+// 32 or 64 bit x
+#define CCOLLECTIONS_SET_NEXT_POW2(x) { --x; x|=x>>1; x|=x>>2; x|=x>>4; x|=x>>8; x|=x>>16; x|=(x>>16)>>16; ++x; }
 #endif // !CCOLLECTIONS_NEXT_POW2
 
 enum CCOLLECTION_TYPE
@@ -27,22 +66,41 @@ enum CCOLLECTION_TYPE
     CCOLLECTION_TYPE_ARRAYLIST,
     CCOLLECTION_TYPE_POOL,
     CCOLLECTION_TYPE_BLOCKPOOL,
+    // list on inline storage declared with CLIST_INLINE, becomes CCOLLECTION_TYPE_LIST when it spills to the heap
+    CCOLLECTION_TYPE_LIST_INLINE,
+    // list appended to by many threads at once, see clistAllocConcurrent
+    CCOLLECTION_TYPE_LIST_CONCURRENT,
+    CCOLLECTION_TYPE_RING_SPSC,
+    CCOLLECTION_TYPE_RING_MPMC,
+    CCOLLECTION_TYPE_HASHMAP,
 
     CCOLLECTION_ERROR = 0xFFFF,
 };
 
+// allocation hook for containers, see CAllocator.h
+// alloc returns memory aligned to alignment, realloc may be NULL to alloc, copy and free instead
+typedef struct CAllocator
+{
+    void* (*Alloc)(void* context, size_t size, size_t alignment);
+    void* (*Realloc)(void* context, void* ptr, size_t oldSize, size_t newSize, size_t alignment);
+    void (*Free)(void* context, void* ptr, size_t size);
+    void* Context;
+} CAllocator;
+
 typedef struct CContainer
 {
     //! data items contained in the container
     uint8_t* Data;
     //! number of items in the container
-    uint32_t Count;
+    CSize Count;
     //! maximum number of items in the container
-    uint32_t Capacity;
+    CSize Capacity;
     //! size in bytes of each item
-    uint32_t Stride;
+    CSize Stride;
     // the type of container this is - cast to CCOLLECTION_TYPE
     enum CCOLLECTION_TYPE Type;
+    // allocator the data was allocated with, NULL for the built-in aligned heap
+    const CAllocator* Allocator;
 } CContainer;
 
 typedef struct CContainerEx
@@ -50,14 +108,14 @@ typedef struct CContainerEx
     CContainer Base;
 
     // for use with multi-dimensional containers
-    uint32_t SubItemStride;
+    CSize SubItemStride;
 
     // data offset of next free item - for pool types only
-    uint32_t Free;
+    CSize Free;
     // data offset of last item - for pool types only
-    uint32_t Last;
+    CSize Last;
 
-    uint32_t Unused;
+    CSize Unused;
 } CContainerEx;
 
 // dynamic array list of items - interface similar to .NET List
@@ -73,23 +131,23 @@ typedef struct CMultiArrayList
     CArrayList ArrayLists[16];
 } CMultiArrayList;
 
-// header for a raw data array at 16 byte offset
+// header for a raw data array at 16 byte offset, 32 with CCOLLECTIONS_SIZE64
 typedef struct CArrayHeader
 {
-    uint32_t Count;
-    uint32_t Capacity;
-    uint32_t Stride;
-    uint32_t UserData;
+    CSize Count;
+    CSize Capacity;
+    CSize Stride;
+    CSize UserData;
 } CArrayHeader;
 
 // header for a block of data in a linked list
-// data at 16 byte offset
+// data at 16 byte offset, 32 with CCOLLECTIONS_SIZE64
 typedef struct CBlockHeader
 {
-    uint32_t Count;
-    uint32_t Prev;
-    uint32_t Next;
-    uint32_t unused;
+    CSize Count;
+    CSize Prev;
+    CSize Next;
+    CSize unused;
 }CBlockHeader;
 
 // dynamic array of block keys in a CBlockPool - key lookup O(2) (indirrect)
@@ -100,4 +158,58 @@ typedef struct CMultiBlockPool
     CBlockPool Pool;
 }CMultiBlockPool;
 
+// single producer single consumer ring of fixed stride items - see CRingBuffer.h
+// capacity is a power of 2, Base.Count is unused
+typedef struct CSpscRing
+{
+    CContainer Base;
+    uint8_t Pad0[CCOLLECTIONS_CACHE_LINE_ALIGNMENT - sizeof(CContainer)];
+    // producer cache line - next write index and the last read index it saw
+    volatile uint32_t Tail;
+    uint32_t HeadCache;
+    uint8_t Pad1[CCOLLECTIONS_CACHE_LINE_ALIGNMENT - 2 * sizeof(uint32_t)];
+    // consumer cache line - next read index and the last write index it saw
+    volatile uint32_t Head;
+    uint32_t TailCache;
+    uint8_t Pad2[CCOLLECTIONS_CACHE_LINE_ALIGNMENT - 2 * sizeof(uint32_t)];
+} CSpscRing;
+
+// bounded multi producer multi consumer ring of fixed stride items - see CRingBuffer.h
+// capacity is a power of 2, Base.Count is unused
+typedef struct CMpmcRing
+{
+    CContainer Base;
+    // per item sequence numbers, stored after the items in the same allocation
+    volatile uint32_t* Sequences;
+    uint8_t Pad0[CCOLLECTIONS_CACHE_LINE_ALIGNMENT - sizeof(CContainer) - sizeof(uint32_t*)];
+    volatile uint32_t Tail;
+    uint8_t Pad1[CCOLLECTIONS_CACHE_LINE_ALIGNMENT - sizeof(uint32_t)];
+    volatile uint32_t Head;
+    uint8_t Pad2[CCOLLECTIONS_CACHE_LINE_ALIGNMENT - sizeof(uint32_t)];
+} CMpmcRing;
+
+// open addressing hash map of fixed stride keys and values - see CHashMap.h
+// Base.Data is one control byte per slot, followed in the same allocation by the slots - a key then its value
+// Base.Capacity is the slot count, a power of 2, Base.Stride is KeyStride + ValueStride
+typedef struct CHashMap
+{
+    CContainer Base;
+    uint8_t* Slots;
+    // per group count of keys that probed past it, saturates at 255
+    uint8_t* Overflow;
+    CSize KeyStride;
+    CSize ValueStride;
+    // Count at which the map grows
+    CSize GrowthLimit;
+} CHashMap;
+
+// recorded peak count and growth events of a container, keyed by a user id - see CCapacityProfile.h
+typedef struct CCapacityProfileEntry
+{
+    uint32_t Key;
+    CSize PeakCount;
+    CSize GrowthCount;
+    CSize Capacity;
+} CCapacityProfileEntry;
+
 #endif // !CCOLLECTIONS_CTYPES_H
\ No newline at end of file
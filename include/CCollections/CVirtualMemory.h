@@ -0,0 +1,137 @@
+// MIT License - CCollections
+// Copyright(c) 2020 Dante Falcone (dantefalcone@gmail.com)
+#pragma once
+#if !defined(_WIN32)
+    // before any system header, strict ISO C hides MAP_ANONYMOUS, madvise and mremap - see also CTypes.h
+    #ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+    #endif
+    #ifndef _DEFAULT_SOURCE
+    #define _DEFAULT_SOURCE
+    #endif
+#endif
+#include <stddef.h>
+#include <stdint.h>
+
+/*  CVirtualMemory
+
+    Page granular reserve, commit and release of address space, for containers that grow in place
+    Linux can also remap, moving pages to a larger range instead of copying them
+    CVM_AVAILABLE is defined where supported, CVM_REMAP where remapping is supported - define CVM_NO_REMAP to opt out
+*/
+
+#if defined(_WIN32)
+    #ifndef WIN32_LEAN_AND_MEAN
+    #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+    #define CVM_AVAILABLE
+#elif defined(__unix__) || defined(__APPLE__)
+    #include <sys/mman.h>
+    #include <unistd.h>
+    #if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+        #define MAP_ANONYMOUS MAP_ANON
+    #endif
+    #if defined(MAP_ANONYMOUS)
+        #define CVM_AVAILABLE
+        #if defined(MREMAP_MAYMOVE) && !defined(CVM_NO_REMAP)
+            #define CVM_REMAP
+        #endif
+    #endif
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+// ask for transparent huge pages on a page aligned range - returns 0 where unsupported
+static inline uint32_t cvmAdviseHugePages(void* ptr, size_t size)
+{
+#if defined(MADV_HUGEPAGE)
+    return madvise(ptr, size, MADV_HUGEPAGE) == 0;
+#else
+    (void)ptr;
+    (void)size;
+    return 0;
+#endif
+}
+
+#if defined(CVM_AVAILABLE)
+
+static inline size_t cvmPageSize(void);
+// reserve address space without backing memory - returns NULL on failure
+static inline void* cvmReserve(size_t size);
+// back reserved pages with zeroed read/write memory, pages already committed keep their contents - returns 0 on failure
+static inline uint32_t cvmCommit(void* ptr, size_t size);
+// ptr and size as reserved
+static inline void cvmRelease(void* ptr, size_t size);
+#if defined(CVM_REMAP)
+// grow or shrink committed pages, moving them to a new range if needed without copying - returns NULL on failure
+static inline void* cvmRemap(void* ptr, size_t oldSize, size_t newSize);
+#endif // CVM_REMAP
+
+
+
+#if defined(_WIN32)
+
+size_t cvmPageSize(void)
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (size_t)info.dwPageSize;
+}
+
+void* cvmReserve(size_t size)
+{
+    return VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_NOACCESS);
+}
+
+uint32_t cvmCommit(void* ptr, size_t size)
+{
+    return VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE) != NULL;
+}
+
+void cvmRelease(void* ptr, size_t size)
+{
+    (void)size;
+    VirtualFree(ptr, 0, MEM_RELEASE);
+}
+
+#else
+
+size_t cvmPageSize(void)
+{
+    return (size_t)sysconf(_SC_PAGESIZE);
+}
+
+void* cvmReserve(size_t size)
+{
+    void* ptr = mmap(NULL, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return ptr == MAP_FAILED ? NULL : ptr;
+}
+
+uint32_t cvmCommit(void* ptr, size_t size)
+{
+    return mprotect(ptr, size, PROT_READ | PROT_WRITE) == 0;
+}
+
+void cvmRelease(void* ptr, size_t size)
+{
+    munmap(ptr, size);
+}
+
+#if defined(CVM_REMAP)
+void* cvmRemap(void* ptr, size_t oldSize, size_t newSize)
+{
+    void* newPtr = mremap(ptr, oldSize, newSize, MREMAP_MAYMOVE);
+    return newPtr == MAP_FAILED ? NULL : newPtr;
+}
+#endif // CVM_REMAP
+
+#endif // _WIN32
+
+#endif // CVM_AVAILABLE
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
@@ -1,62 +1,241 @@
 // MIT License - CCollections
 // Copyright(c) 2020 Dante Falcone (dantefalcone@gmail.com)
 
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L // mlock, sysconf
+#endif
+#if defined(_MSC_VER) && !defined(_CRT_SECURE_NO_WARNINGS)
+#define _CRT_SECURE_NO_WARNINGS // fopen
+#endif
+
 #include "CCollections/CEntityComponentSystem.h"
+#include "CCollections/CAtomic.h"
+#include "CCollections/CCapacityProfile.h"
 #include <malloc.h>
 #include <string.h>
 #include <stdarg.h>
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
 
-// aligned_alloc
-#if defined(_MSC_VER)           // MSVC
-    #define ecsAlloc(size,alignment) _aligned_malloc(size,alignment)
-    #define ecsRealloc(data,size,alignment) _aligned_realloc(data,size,alignment)
-    #define ecsFree _aligned_free
-#elif __STDC_VERSION__ >= 201112L || __cplusplus >= 201103L    // C11, C++11
-    #include <stdlib.h>
-    #define ecsAlloc(size,alignment) aligned_alloc(alignment,size)
-    #define ecsFree free
-#elif defined(__SSE__) || defined(_M_X64) || defined(_M_IA64) || defined(_M_IX86) || defined(__i386__) || defined(__x86_64__) // Intel Arch. Intrinsics
-    #include <xmmintrin.h>
-    #define ecsAlloc(size,alignment) _mm_malloc(size,alignment)
-    #define ecsFree _mm_free
-#endif
+// allocations of an instance go through the allocator it was created with, alignment follows size - see CAllocator.h
+// sizes passed to ecsRealloc and ecsFree are the allocated sizes, as callocatorFree requires
+static inline void* ecsAlloc(const EcsInstance* instance, size_t size)
+{
+    void* ptr = callocatorAlloc(instance->Allocator, size);
+    assert(ptr);
+    return ptr;
+}
 
-#ifndef ecsAlloc
-inline void* ecsAlloc(size_t size)
+// copies min(usedSize, size) - supports both growing and shrinking
+static inline void* ecsReallocUsed(const EcsInstance* instance, void* ptr, size_t oldSize, size_t size, size_t usedSize)
 {
-    byte* newPtr = (byte*)malloc(size + ECS_ALIGNMENT);
+    if (ptr == NULL)
+        return ecsAlloc(instance, size);
+    void* newPtr = callocatorRealloc(instance->Allocator, ptr, oldSize, size, usedSize);
     assert(newPtr);
-    byte offset = (byte)ECS_ALIGNMENT - (byte)((size_t)newPtr % ECS_ALIGNMENT);
-    newPtr += offset;
-    *(newPtr-1) = offset;
-    assert( ((size_t)newPtr & ECS_ALIGNMENT) == ECS_ALIGNMENT );
     return newPtr;
 }
-#endif // !ecsAlloc
 
-#ifndef ecsFree
-inline void ecsFree(void* ptr)
+// copies min(oldSize, size)
+static inline void* ecsRealloc(const EcsInstance* instance, void* ptr, size_t oldSize, size_t size)
+{
+    return ecsReallocUsed(instance, ptr, oldSize, size, oldSize);
+}
+
+static inline void ecsFree(const EcsInstance* instance, void* ptr, size_t size)
 {
-    byte* oldPtr = (byte*)ptr;
-    byte offset = *(oldPtr - 1);
-    oldPtr -= offset;
-    free(oldPtr);
+    if (ptr)
+        callocatorFree(instance->Allocator, ptr, size);
 }
+
+// threads
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+    typedef HANDLE EcsThread;
+    typedef CRITICAL_SECTION EcsMutex;
+    typedef CONDITION_VARIABLE EcsCondition;
+    #define ecsMutexInit(m) InitializeCriticalSection(m)
+    #define ecsMutexDestroy(m) DeleteCriticalSection(m)
+    #define ecsMutexLock(m) EnterCriticalSection(m)
+    #define ecsMutexUnlock(m) LeaveCriticalSection(m)
+    #define ecsConditionInit(c) InitializeConditionVariable(c)
+    #define ecsConditionDestroy(c) ((void)(c))
+    #define ecsConditionWait(c,m) SleepConditionVariableCS(c,m,INFINITE)
+    #define ecsConditionBroadcast(c) WakeAllConditionVariable(c)
+    #define ecsThreadYield() SwitchToThread()
+#else
+    #include <pthread.h>
+    #include <sched.h>
+    #include <time.h>
+    typedef pthread_t EcsThread;
+    typedef pthread_mutex_t EcsMutex;
+    typedef pthread_cond_t EcsCondition;
+    #define ecsMutexInit(m) pthread_mutex_init(m,NULL)
+    #define ecsMutexDestroy(m) pthread_mutex_destroy(m)
+    #define ecsMutexLock(m) pthread_mutex_lock(m)
+    #define ecsMutexUnlock(m) pthread_mutex_unlock(m)
+    #define ecsConditionInit(c) pthread_cond_init(c,NULL)
+    #define ecsConditionDestroy(c) pthread_cond_destroy(c)
+    #define ecsConditionWait(c,m) pthread_cond_wait(c,m)
+    #define ecsConditionBroadcast(c) pthread_cond_broadcast(c)
+    #define ecsThreadYield() sched_yield()
+#endif
+// !threads
+
+// memory locking
+#if defined(_WIN32)
+    #define ecsMemoryLock(ptr,size) (VirtualLock(ptr,size) != 0)
+    #define ecsMemoryUnlock(ptr,size) VirtualUnlock(ptr,size)
+    static size_t ecsPageSize(void) { SYSTEM_INFO info; GetSystemInfo(&info); return (size_t)info.dwPageSize; }
+#else
+    #include <sys/mman.h>
+    #include <unistd.h>
+    #define ecsMemoryLock(ptr,size) (mlock(ptr,size) == 0)
+    #define ecsMemoryUnlock(ptr,size) munlock(ptr,size)
+    static size_t ecsPageSize(void) { return (size_t)sysconf(_SC_PAGESIZE); }
+#endif
+// !memory locking
+
+// streaming stores - non-temporal, bypass the cache for large one-way copies
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define ECS_STREAMING_STORES
+#endif
+// !streaming stores
+
+// bit scan
+#if defined(_MSC_VER)
+    static inline uint ecsCountTrailingZeros64(uint64_t value) { unsigned long index; _BitScanForward64(&index, value); return (uint)index; }
+#else
+    #define ecsCountTrailingZeros64(value) ((uint)__builtin_ctzll(value))
+#endif
+// !bit scan
+
+// file mapping - private copy-on-write view of a whole file, writes are never written back. NULL on failure
+#if defined(_WIN32)
+    static const byte* ecsMapFile(const char* path, size_t* size)
+    {
+        HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (file == INVALID_HANDLE_VALUE)
+            return NULL;
+        LARGE_INTEGER fileSize;
+        HANDLE mapping = NULL;
+        const byte* data = NULL;
+        if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0)
+            mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+        if (mapping)
+        {
+            data = (const byte*)MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+            CloseHandle(mapping); // the view keeps the mapping
+        }
+        CloseHandle(file);
+        *size = (size_t)fileSize.QuadPart;
+        return data;
+    }
+    #define ecsUnmapFile(data,size) UnmapViewOfFile(data)
+#else
+    #include <fcntl.h>
+    #include <sys/stat.h>
+    static const byte* ecsMapFile(const char* path, size_t* size)
+    {
+        int fd = open(path, O_RDONLY);
+        if (fd < 0)
+            return NULL;
+        struct stat st;
+        void* data = MAP_FAILED;
+        if (fstat(fd, &st) == 0 && st.st_size > 0)
+            data = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        close(fd); // the mapping keeps the file
+        if (data == MAP_FAILED)
+            return NULL;
+        *size = (size_t)st.st_size;
+        return (const byte*)data;
+    }
+    #define ecsUnmapFile(data,size) munmap((void*)(data),size)
 #endif
+// !file mapping
+
+// arrays loaded by ecsLoadInstance point into the file mapping, they are copied out instead of reallocated, and never freed
+static inline uint ecsIsMapped(const EcsInstance* instance, const void* ptr)
+{
+    const byte* data = instance->FileContainer.data;
+    return data && (const byte*)ptr >= data && (const byte*)ptr < data + instance->FileContainer.size;
+}
 
-#ifndef ecsRealloc
-inline void* ecsRealloc(void* ptr, size_t size, size_t align)
+// oldSize is the allocated size, the first usedSize bytes are copied
+static void* ecsReallocArray(EcsInstance* instance, void* ptr, size_t oldSize, size_t size, size_t usedSize)
 {
-    void* oldPtr = ptr;
-    void* newPtr = ecsAlloc(size, align);
-    memcpy(ptr, oldPtr, size);
-    ecsFree(oldPtr);
+    if (ecsIsMapped(instance, ptr) == 0)
+        return ecsReallocUsed(instance, ptr, oldSize, size, usedSize);
+
+    void* newPtr = ecsAlloc(instance, size);
+    memcpy(newPtr, ptr, usedSize < size ? usedSize : size);
     return newPtr;
 }
-#endif // !ecsRealloc
-// !aligned_alloc
+
+static void ecsFreeArray(EcsInstance* instance, void* ptr, size_t size)
+{
+    if (ecsIsMapped(instance, ptr) == 0)
+        ecsFree(instance, ptr, size);
+}
+
+// structural events of ecsEncodeDelta, first value is the event type
+enum EcsDeltaEvent
+{
+    ECS_DELTA_CREATE_ARCHETYPE, // componentCount, initialCapacity, { id, stride, fieldSize } * componentCount
+    ECS_DELTA_CREATE_ENTITY, // entityId, archetypeId
+    ECS_DELTA_DESTROY_ENTITY, // entityId
+    ECS_DELTA_DESTROY_ENTITIES, // entityCount, entityIds * entityCount
+    ECS_DELTA_ADD_COMPONENT, // entityId, componentId, sizeofComponent
+    ECS_DELTA_ADD_SPARSE_COMPONENT, // entityId, componentId
+    ECS_DELTA_REMOVE_SPARSE_COMPONENT, // entityId, componentId
+    ECS_DELTA_SET_ENTITY_ENABLED, // entityId, bEnabled
+};
+
+static void ecsRealtimeAllocation(EcsInstance* instance);
+
+// structural changes are recorded unless delta is disabled or the change is part of a recorded call
+static uint ecsDeltaRecording(EcsInstance* instance)
+{
+    return instance->DeltaContainer.enabled && instance->DeltaContainer.depth == 0;
+}
+
+static void ecsDeltaAppend(EcsInstance* instance, uint count, const void* values)
+{
+    struct DeltaContainer_T* delta = &instance->DeltaContainer;
+    if (delta->eventCount + count > delta->eventCapacity)
+    {
+        uint newCapacity = delta->eventCapacity ? delta->eventCapacity * 2 : 1024;
+        while (newCapacity < delta->eventCount + count)
+            newCapacity *= 2;
+        ecsRealtimeAllocation(instance);
+        delta->events = (uint*)ecsRealloc(instance, delta->events, sizeof(uint) * delta->eventCapacity, sizeof(uint) * newCapacity);
+        delta->eventCapacity = newCapacity;
+    }
+    memcpy(delta->events + delta->eventCount, values, sizeof(uint) * count);
+    delta->eventCount += count;
+}
+
+static void ecsDeltaRecord(EcsInstance* instance, uint type, uint count, const uint* values)
+{
+    if (ecsDeltaRecording(instance) == 0)
+        return;
+    ecsDeltaAppend(instance, 1, &type);
+    ecsDeltaAppend(instance, count, values);
+}
+
+// count allocations made in real-time mode
+static void ecsRealtimeAllocation(EcsInstance* instance)
+{
+    if (instance->RealtimeContainer.enabled == 0)
+        return;
+    ++instance->RealtimeContainer.allocationCount;
+#if ECS_REALTIME_ASSERT
+    assert(0 && "allocation in real-time mode - reserve more capacity before ecsBeginRealtime");
+#endif
+}
 
 static void ecsSwapEntity(EcsArchetype* archetype, EcsArchetypeSignature* signature, EcsEntity* entityA, EcsEntity* entityB)
 {
@@ -92,7 +271,7 @@ static void ecsSwapEntity(EcsArchetype* archetype, EcsArchetypeSignature* signat
     }
 }
 
-inline void ecsSortComponentDescs(const uint count, EcsComponentDesc* descs)
+static inline void ecsSortComponentDescs(const uint count, EcsComponentDesc* descs)
 {
     // Implementation of insertion sort algorithm
     EcsComponentDesc temp;
@@ -109,20 +288,551 @@ inline void ecsSortComponentDescs(const uint count, EcsComponentDesc* descs)
     }
 }
 
+// byte offset of component at index within its array, AoS or AoSoA
+static inline size_t ecsComponentOffset(const EcsComponentArray* componentArray, uint componentIndex)
+{
+    if (componentArray->fieldSize == 0)
+        return componentArray->stride * componentIndex;
+
+    size_t block = componentIndex / ECS_AOSOA_LANES;
+    size_t lane = componentIndex % ECS_AOSOA_LANES;
+    return block * componentArray->stride * ECS_AOSOA_LANES + lane * componentArray->fieldSize;
+}
+
+// bytes in use by count components, AoSoA arrays are used in whole blocks
+static inline size_t ecsComponentArraySize(const EcsComponentArray* componentArray, uint count)
+{
+    if (componentArray->fieldSize == 0)
+        return componentArray->stride * count;
+
+    size_t blockCount = (count + ECS_AOSOA_LANES - 1) / ECS_AOSOA_LANES;
+    return blockCount * componentArray->stride * ECS_AOSOA_LANES;
+}
+
+// component at index within the archetype, rows not yet migrated by incremental growth are in the previous columns
+static inline byte* ecsComponentAt(const EcsArchetype* archetype, const EcsComponentArray* componentArray, uint componentIndex)
+{
+    byte* components = componentArray->components;
+    if (componentIndex - archetype->migrateBegin < archetype->migrateEnd - archetype->migrateBegin)
+        components = archetype->migrateColumns[componentArray - archetype->componentArrays];
+    return components + ecsComponentOffset(componentArray, componentIndex);
+}
+
+// columns holding row, rows [row, *regionEnd) are contiguous from them
+// migration boundaries are on AoSoA block boundaries, so byte offsets of rows are the same in both
+static inline const byte* ecsColumnRegion(const EcsArchetype* archetype, const EcsComponentArray* componentArray, uint row, uint* regionEnd)
+{
+    *regionEnd = ECS_INVALID_ID;
+    if (archetype->migrateEnd == 0 || row >= archetype->migrateEnd)
+        return componentArray->components;
+    if (row < archetype->migrateBegin)
+    {
+        *regionEnd = archetype->migrateBegin;
+        return componentArray->components;
+    }
+    *regionEnd = archetype->migrateEnd;
+    return archetype->migrateColumns[componentArray - archetype->componentArrays];
+}
+
+// copy one component between an array and a packed struct, bLoad copies from the array
+static void ecsTransferComponent(const EcsArchetype* archetype, EcsComponentArray* componentArray, uint componentIndex, byte* packed, uint bLoad)
+{
+    byte* component = ecsComponentAt(archetype, componentArray, componentIndex);
+    const size_t fieldSize = componentArray->fieldSize ? componentArray->fieldSize : componentArray->stride;
+    const size_t fieldStride = componentArray->fieldSize ? fieldSize * ECS_AOSOA_LANES : fieldSize;
+    for (size_t off = 0; off != componentArray->stride; off += fieldSize, component += fieldStride)
+    {
+        if (bLoad)
+            memcpy(packed + off, component, fieldSize);
+        else
+            memcpy(component, packed + off, fieldSize);
+    }
+}
+
+// copy one component between arrays of the same component type
+// archetypes with equal signatures may differ in layout, ex. an entity added to an archetype created from an AoS and an AoSoA archetype
+static void ecsCopyComponent(const EcsArchetype* dstArchetype, EcsComponentArray* dstArray, uint dstIndex, const EcsArchetype* srcArchetype, const EcsComponentArray* srcArray, uint srcIndex)
+{
+    assert(dstArray->stride == srcArray->stride);
+    if (dstArray->fieldSize != srcArray->fieldSize)
+    {
+        byte packed[ECS_MAX_COMPONENT_SIZE];
+        assert(srcArray->stride <= ECS_MAX_COMPONENT_SIZE);
+        ecsTransferComponent(srcArchetype, (EcsComponentArray*)srcArray, srcIndex, packed, 1);
+        ecsTransferComponent(dstArchetype, dstArray, dstIndex, packed, 0);
+        return;
+    }
+
+    byte* dst = ecsComponentAt(dstArchetype, dstArray, dstIndex);
+    const byte* src = ecsComponentAt(srcArchetype, srcArray, srcIndex);
+
+    if (srcArray->fieldSize == 0)
+    {
+        memcpy(dst, src, srcArray->stride);
+        return;
+    }
+
+    const size_t fieldSize = srcArray->fieldSize;
+    const size_t fieldStride = fieldSize * ECS_AOSOA_LANES;
+    for (size_t off = 0, end = srcArray->stride / fieldSize * fieldStride; off != end; off += fieldStride)
+    {
+        memcpy(dst + off, src + off, fieldSize);
+    }
+}
+
+#if 64 % ECS_AOSOA_LANES != 0
+#error "ECS_AOSOA_LANES must divide 64, enabled mask words hold whole blocks"
+#endif
+
+// enabled mask, one bit per row, rows at or past entityCount are 0
+static inline size_t ecsEnabledMaskSize(uint entityCount)
+{
+    return sizeof(uint64_t) * ((entityCount + 63) / 64);
+}
+
+static inline uint ecsRowEnabled(const EcsArchetype* archetype, uint row)
+{
+    return (uint)(archetype->enabledMask[row / 64] >> (row % 64)) & 1;
+}
+
+static inline void ecsSetRowEnabled(EcsArchetype* archetype, uint row, uint bEnabled)
+{
+    const uint64_t bit = (uint64_t)1 << (row % 64);
+    if (bEnabled)
+        archetype->enabledMask[row / 64] |= bit;
+    else
+        archetype->enabledMask[row / 64] &= ~bit;
+}
+
+// first enabled row at or after row, entityCount if none - 64 rows per word
+static inline uint ecsNextEnabledRow(const EcsArchetype* archetype, uint row)
+{
+    if (archetype->disabledCount == 0 || row >= archetype->entityCount)
+        return row;
+
+    const uint wordCount = (archetype->entityCount + 63) / 64;
+    uint word = row / 64;
+    uint64_t bits = archetype->enabledMask[word] & (~(uint64_t)0 << (row % 64));
+    while (bits == 0)
+    {
+        if (++word == wordCount)
+            return archetype->entityCount;
+        bits = archetype->enabledMask[word];
+    }
+    return word * 64 + ecsCountTrailingZeros64(bits);
+}
+
+// first disabled row at or after row, entityCount if none
+static inline uint ecsNextDisabledRow(const EcsArchetype* archetype, uint row)
+{
+    if (archetype->disabledCount == 0 || row >= archetype->entityCount)
+        return archetype->entityCount;
+
+    const uint wordCount = (archetype->entityCount + 63) / 64;
+    uint word = row / 64;
+    uint64_t bits = ~archetype->enabledMask[word] & (~(uint64_t)0 << (row % 64));
+    while (bits == 0)
+    {
+        if (++word == wordCount)
+            return archetype->entityCount;
+        bits = ~archetype->enabledMask[word];
+    }
+    row = word * 64 + ecsCountTrailingZeros64(bits);
+    return row < archetype->entityCount ? row : archetype->entityCount;
+}
+
+// enabled lanes of the block starting at row
+static inline uint ecsBlockEnabledMask(const EcsArchetype* archetype, uint row, uint laneCount)
+{
+    const uint allLanes = (uint)(((uint64_t)1 << laneCount) - 1);
+    if (archetype->disabledCount == 0)
+        return allLanes;
+    return (uint)(archetype->enabledMask[row / 64] >> (row % 64)) & allLanes;
+}
+
+// cache column base pointers of an archetype in query component order
+static void ecsSetQueryColumns(EcsQueryColumns* columns, const EcsQuery* query, const EcsArchetype* archetype)
+{
+    columns->bAoS = 1;
+    for (uint i = 0; i < query->componentCount; ++i)
+    {
+        if (query->sparseMask & (1u << i))
+        {
+            columns->components[i] = NULL;
+            columns->strides[i] = 0;
+            columns->fieldSizes[i] = 0;
+            continue;
+        }
+        const EcsComponentArray* comArray = &archetype->componentArrays[query->componentIds[i]];
+        columns->components[i] = comArray->components;
+        columns->strides[i] = (uint)comArray->stride;
+        columns->fieldSizes[i] = comArray->fieldSize;
+        columns->bAoS &= comArray->fieldSize == 0;
+    }
+}
+
+// append an archetype to a query and its column table
+static void ecsAppendQueryArchetype(EcsInstance* instance, uint queryId, EcsArchetype* archetype)
+{
+    EcsQuery* query = &instance->QueryContainer.queries[queryId];
+    EcsQueryColumnTable* table = &instance->QueryContainer.columnTables[queryId];
+    assert(query->archetypeCount < ECS_MAX_QUERY_ARCHETYPES && "query archetypes exceeds ECS_MAX_QUERY_ARCHETYPES");
+    if (query->archetypeCount == table->capacity)
+    {
+        const uint newCapacity = table->capacity ? table->capacity * 2 : 8;
+        ecsRealtimeAllocation(instance);
+        table->columns = (EcsQueryColumns*)ecsRealloc(instance, table->columns, sizeof(EcsQueryColumns) * table->capacity, sizeof(EcsQueryColumns) * newCapacity);
+        table->capacity = newCapacity;
+    }
+    ecsSetQueryColumns(&table->columns[query->archetypeCount], query, archetype);
+    query->archetypes[query->archetypeCount++] = archetype;
+}
+
+// refresh the cached columns of an archetype after its columns were reallocated
+static void ecsRefreshQueryColumns(EcsInstance* instance, const EcsArchetype* archetype)
+{
+    for (uint queryId = 0; queryId < instance->QueryContainer.count; ++queryId)
+    {
+        const EcsQuery* query = &instance->QueryContainer.queries[queryId];
+        for (uint archIdx = 0; archIdx != query->archetypeCount; ++archIdx)
+        {
+            if (query->archetypes[archIdx] != archetype)
+                continue;
+            ecsSetQueryColumns(&instance->QueryContainer.columnTables[queryId].columns[archIdx], query, archetype);
+            break;
+        }
+    }
+}
+
+// move rows [migrateBegin, rowEnd) of a growing archetype to its new columns, the previous columns are freed after the last row
+static void ecsMigrateArchetypeRows(EcsInstance* instance, EcsArchetype* archetype, const EcsArchetypeSignature* signature, uint rowEnd)
+{
+    assert(rowEnd % ECS_AOSOA_LANES == 0 && rowEnd <= archetype->migrateEnd);
+    for (const uint* sigIdItr = signature->componentIds; *sigIdItr != (uint)-1; ++sigIdItr)
+    {
+        EcsComponentArray* compArray = &archetype->componentArrays[*sigIdItr];
+        const size_t begin = compArray->stride * archetype->migrateBegin;
+        memcpy(compArray->components + begin, archetype->migrateColumns[*sigIdItr] + begin, compArray->stride * rowEnd - begin);
+    }
+    archetype->migrateBegin = rowEnd;
+    if (rowEnd != archetype->migrateEnd)
+        return;
+
+    for (const uint* sigIdItr = signature->componentIds; *sigIdItr != (uint)-1; ++sigIdItr)
+    {
+        ecsFreeArray(instance, archetype->migrateColumns[*sigIdItr], archetype->componentArrays[*sigIdItr].stride * archetype->migrateCapacity);
+    }
+    ecsFree(instance, archetype->migrateColumns, sizeof(byte*) * ECS_MAX_COMPONENT_TYPES);
+    archetype->migrateColumns = NULL;
+    archetype->migrateBegin = 0;
+    archetype->migrateEnd = 0;
+    archetype->migrateCapacity = 0;
+    --instance->GrowthContainer.migratingCount;
+}
+
+static void ecsFinishArchetypeGrowth(EcsInstance* instance, EcsArchetype* archetype, const EcsArchetypeSignature* signature)
+{
+    if (archetype->migrateEnd)
+        ecsMigrateArchetypeRows(instance, archetype, signature, archetype->migrateEnd);
+}
+
+// move every row left in previous columns, before columns are accessed as a whole
+static void ecsFinishGrowth(EcsInstance* instance)
+{
+    for (uint archId = 0; archId < instance->ArchetypeContainer.count && instance->GrowthContainer.migratingCount; ++archId)
+    {
+        ecsFinishArchetypeGrowth(instance, instance->ArchetypeContainer.archetypes + archId, instance->ArchetypeContainer.signatures + archId);
+    }
+}
+
+// bytes of one row of every column of an archetype
+static size_t ecsArchetypeRowSize(const EcsArchetype* archetype, const EcsArchetypeSignature* signature)
+{
+    size_t rowSize = 0;
+    for (const uint* sigIdItr = signature->componentIds; *sigIdItr != (uint)-1; ++sigIdItr)
+    {
+        rowSize += archetype->componentArrays[*sigIdItr].stride;
+    }
+    return rowSize;
+}
+
+// reallocate entity ids and enabled mask of an archetype, preserving entity data
+static void ecsResizeArchetypeEntities(EcsInstance* instance, EcsArchetype* archetype, uint newCapacity)
+{
+    archetype->entityIds = (uint*)ecsReallocArray(instance, archetype->entityIds, sizeof(uint) * archetype->entityCapacity, sizeof(uint) * newCapacity, sizeof(uint) * archetype->entityCount);
+    const size_t maskSize = ecsEnabledMaskSize(archetype->entityCount);
+    archetype->enabledMask = (uint64_t*)ecsReallocArray(instance, archetype->enabledMask, ecsEnabledMaskSize(archetype->entityCapacity), ecsEnabledMaskSize(newCapacity), maskSize);
+    memset((byte*)archetype->enabledMask + maskSize, 0, ecsEnabledMaskSize(newCapacity) - maskSize);
+    archetype->entityCapacity = newCapacity;
+}
+
+// reallocate all component arrays and entity ids of an archetype, preserving entity data
+// also used to reallocate archetypes freed by ecsCompact (entityCapacity of 0)
+static void ecsResizeArchetype(EcsInstance* instance, EcsArchetype* archetype, const EcsArchetypeSignature* signature, uint newCapacity)
+{
+    assert(newCapacity > archetype->entityCount);
+    assert(newCapacity % ECS_AOSOA_LANES == 0);
+    ecsFinishArchetypeGrowth(instance, archetype, signature);
+    for (const uint* sigIdItr = signature->componentIds; *sigIdItr != (uint)-1; ++sigIdItr)
+    {
+        EcsComponentArray* compArray = &archetype->componentArrays[*sigIdItr];
+        compArray->components = (byte*)ecsReallocArray(instance, compArray->components, compArray->stride * archetype->entityCapacity, compArray->stride * newCapacity, ecsComponentArraySize(compArray, archetype->entityCount));
+    }
+    ecsResizeArchetypeEntities(instance, archetype, newCapacity);
+    ecsRefreshQueryColumns(instance, archetype);
+}
+
+// allocate new component arrays of an archetype without copying, rows in use are left in the previous arrays for ecsStepIncrementalGrowth
+// entity ids and the enabled mask are small next to the columns and are reallocated at once
+static void ecsBeginArchetypeGrowth(EcsInstance* instance, EcsArchetype* archetype, const EcsArchetypeSignature* signature, uint newCapacity)
+{
+    assert(archetype->migrateEnd == 0);
+    assert(newCapacity % ECS_AOSOA_LANES == 0);
+    const uint migrateEnd = (archetype->entityCount + ECS_AOSOA_LANES - 1) / ECS_AOSOA_LANES * ECS_AOSOA_LANES;
+    assert(migrateEnd != 0 && migrateEnd <= archetype->entityCapacity);
+    // components not in the signature stay NULL, as in componentArrays
+    archetype->migrateColumns = (byte**)ecsAlloc(instance, sizeof(byte*) * ECS_MAX_COMPONENT_TYPES);
+    memset(archetype->migrateColumns, 0, sizeof(byte*) * ECS_MAX_COMPONENT_TYPES);
+    for (const uint* sigIdItr = signature->componentIds; *sigIdItr != (uint)-1; ++sigIdItr)
+    {
+        EcsComponentArray* compArray = &archetype->componentArrays[*sigIdItr];
+        archetype->migrateColumns[*sigIdItr] = compArray->components;
+        compArray->components = (byte*)ecsAlloc(instance, compArray->stride * newCapacity);
+    }
+    archetype->migrateCapacity = archetype->entityCapacity;
+    ecsResizeArchetypeEntities(instance, archetype, newCapacity);
+    archetype->migrateBegin = 0;
+    archetype->migrateEnd = migrateEnd;
+    ++instance->GrowthContainer.migratingCount;
+    ecsRefreshQueryColumns(instance, archetype);
+}
+
+// release all storage of an empty archetype, component strides are kept for reallocation
+static void ecsFreeArchetype(EcsInstance* instance, EcsArchetype* archetype, const EcsArchetypeSignature* signature)
+{
+    assert(archetype->entityCount == 0);
+    ecsFinishArchetypeGrowth(instance, archetype, signature);
+    for (const uint* sigIdItr = signature->componentIds; *sigIdItr != (uint)-1; ++sigIdItr)
+    {
+        EcsComponentArray* compArray = &archetype->componentArrays[*sigIdItr];
+        ecsFreeArray(instance, compArray->components, compArray->stride * archetype->entityCapacity);
+        compArray->components = NULL;
+    }
+    ecsFreeArray(instance, archetype->entityIds, sizeof(uint) * archetype->entityCapacity);
+    ecsFreeArray(instance, archetype->enabledMask, ecsEnabledMaskSize(archetype->entityCapacity));
+    archetype->entityIds = NULL;
+    archetype->enabledMask = NULL;
+    archetype->entityCapacity = 0;
+}
+
+// returns 1 if every component id of the query is in the signature
+static uint ecsSignatureHasQuery(const EcsArchetypeSignature* signature, const EcsQuery* query)
+{
+    for (uint i = 0; i < query->componentCount; ++i)
+    {
+        // sparse components are not part of signatures, they are joined per entity
+        if (query->sparseMask & (1u << i))
+            continue;
+
+        uint bContainsId = 0;
+        for (const uint* sigIdItr = signature->componentIds; *sigIdItr != (uint)-1; ++sigIdItr)
+        {
+            bContainsId += query->componentIds[i] == *sigIdItr;
+        }
+
+        if (bContainsId == 0)
+            return 0;
+    }
+    return 1;
+}
+
+// register archetype with every compatible query it is not already part of
+static void ecsAddArchetypeToQueries(EcsInstance* instance, uint archetypeId)
+{
+    EcsArchetype* archetype = instance->ArchetypeContainer.archetypes + archetypeId;
+    const EcsArchetypeSignature* signature = instance->ArchetypeContainer.signatures + archetypeId;
+    EcsQuery* queryItr = instance->QueryContainer.queries;
+    EcsQuery* queryEnd = queryItr + instance->QueryContainer.count;
+    for (; queryItr != queryEnd; ++queryItr)
+    {
+        if (ecsSignatureHasQuery(signature, queryItr) == 0)
+            continue;
+
+        uint archIdx = 0;
+        while (archIdx != queryItr->archetypeCount && queryItr->archetypes[archIdx] != archetype)
+            ++archIdx;
+        if (archIdx != queryItr->archetypeCount)
+            continue;
+
+        ecsAppendQueryArchetype(instance, (uint)(queryItr - instance->QueryContainer.queries), archetype);
+    }
+}
+
+// unregister archetype from all queries, order of remaining archetypes is preserved
+static void ecsRemoveArchetypeFromQueries(EcsInstance* instance, const EcsArchetype* archetype)
+{
+    EcsQuery* queryItr = instance->QueryContainer.queries;
+    EcsQuery* queryEnd = queryItr + instance->QueryContainer.count;
+    for (; queryItr != queryEnd; ++queryItr)
+    {
+        for (uint archIdx = 0; archIdx != queryItr->archetypeCount; ++archIdx)
+        {
+            if (queryItr->archetypes[archIdx] != archetype)
+                continue;
+            --queryItr->archetypeCount;
+            memmove(&queryItr->archetypes[archIdx], &queryItr->archetypes[archIdx + 1], sizeof(EcsArchetype*) * (queryItr->archetypeCount - archIdx));
+            EcsQueryColumns* columns = instance->QueryContainer.columnTables[queryItr - instance->QueryContainer.queries].columns;
+            memmove(&columns[archIdx], &columns[archIdx + 1], sizeof(EcsQueryColumns) * (queryItr->archetypeCount - archIdx));
+            break;
+        }
+    }
+}
+
+// queries point into the archetype container, fix them up after it moves
+static void ecsRebaseQueries(EcsInstance* instance, uintptr_t oldArchetypes)
+{
+    uintptr_t newArchetypes = (uintptr_t)instance->ArchetypeContainer.archetypes;
+    if (newArchetypes == oldArchetypes)
+        return;
+
+    EcsQuery* queryItr = instance->QueryContainer.queries;
+    EcsQuery* queryEnd = queryItr + instance->QueryContainer.count;
+    for (; queryItr != queryEnd; ++queryItr)
+    {
+        for (uint archIdx = 0; archIdx != queryItr->archetypeCount; ++archIdx)
+        {
+            uintptr_t offset = (uintptr_t)queryItr->archetypes[archIdx] - oldArchetypes;
+            queryItr->archetypes[archIdx] = (EcsArchetype*)(newArchetypes + offset);
+        }
+    }
+}
+
+// tracker chunk bit of ecsEncodeDelta, bits 0 and 1 are snapshot frames
+#define ECS_DELTA_BIT 0x4
+
+#if ECS_SNAPSHOT_CHUNK_ENTITIES % ECS_AOSOA_LANES != 0
+#error "ECS_SNAPSHOT_CHUNK_ENTITIES must be a multiple of ECS_AOSOA_LANES"
+#endif
+
+// mark chunk containing row of a snapshot column changed for all frames, chunk tracking grows with the archetype
+static void ecsSnapshotMarkChunk(EcsInstance* instance, uint snapshotId, uint row)
+{
+    EcsSnapshotTracker* tracker = &instance->SnapshotContainer.trackers[snapshotId];
+    const uint chunk = row / ECS_SNAPSHOT_CHUNK_ENTITIES;
+    if (chunk >= tracker->chunkCapacity)
+    {
+        uint oldCapacity = tracker->chunkCapacity;
+        uint newCapacity = oldCapacity ? oldCapacity * 2 : 64;
+        while (newCapacity <= chunk)
+            newCapacity *= 2;
+        ecsRealtimeAllocation(instance);
+        tracker->chunks = (byte*)ecsRealloc(instance, tracker->chunks, oldCapacity, newCapacity);
+        memset(tracker->chunks + oldCapacity, 0, newCapacity - oldCapacity);
+        tracker->chunkCapacity = newCapacity;
+    }
+    tracker->chunks[chunk] = 0x3 | ECS_DELTA_BIT;
+}
+
+// mark a row changed in all snapshot columns of an archetype
+static void ecsSnapshotMarkRow(EcsInstance* instance, uint archetypeId, uint row)
+{
+    if (instance->SnapshotContainer.count == 0)
+        return;
+
+    const EcsArchetype* archetype = instance->ArchetypeContainer.archetypes + archetypeId;
+    const EcsArchetypeSignature* signature = instance->ArchetypeContainer.signatures + archetypeId;
+    for (const uint* sigIdItr = signature->componentIds; *sigIdItr != (uint)-1; ++sigIdItr)
+    {
+        uint snapshotId = archetype->componentArrays[*sigIdItr].snapshotId;
+        if (snapshotId != ECS_INVALID_ID)
+            ecsSnapshotMarkChunk(instance, snapshotId, row);
+    }
+}
+
+// start tracking a component array of an archetype, all current entities are published by the next publish
+static void ecsCreateSnapshotTracker(EcsInstance* instance, uint archetypeId, uint componentId)
+{
+    struct SnapshotContainer_T* snap = &instance->SnapshotContainer;
+    if (snap->count == snap->capacity)
+    {
+        uint oldCapacity = snap->capacity;
+        uint newCapacity = oldCapacity ? oldCapacity * 2 : 64;
+        ecsRealtimeAllocation(instance);
+        snap->trackers = (EcsSnapshotTracker*)ecsRealloc(instance, snap->trackers, sizeof(EcsSnapshotTracker) * oldCapacity, sizeof(EcsSnapshotTracker) * newCapacity);
+        snap->capacity = newCapacity;
+    }
+
+    EcsArchetype* archetype = instance->ArchetypeContainer.archetypes + archetypeId;
+    const uint snapshotId = snap->count++;
+    EcsSnapshotTracker* tracker = &snap->trackers[snapshotId];
+    tracker->archetypeId = archetypeId;
+    tracker->componentId = componentId;
+    tracker->chunks = NULL;
+    tracker->chunkCapacity = 0;
+    archetype->componentArrays[componentId].snapshotId = snapshotId;
+
+    for (uint row = 0; row < archetype->entityCount; row += ECS_SNAPSHOT_CHUNK_ENTITIES)
+    {
+        ecsSnapshotMarkChunk(instance, snapshotId, row);
+    }
+}
+
+// entity capacity of an archetype in whole AoSoA blocks, raised to hold the peak of a loaded capacity profile without growing
+static uint ecsProfileArchetypeCapacity(const EcsInstance* instance, uint archetypeId, uint capacity)
+{
+    const struct ProfileContainer_T* profile = &instance->ProfileContainer;
+    if (archetypeId < profile->archetypeCount && profile->archetypePeaks[archetypeId] + 2 > capacity)
+        capacity = profile->archetypePeaks[archetypeId] + 2;
+    return (capacity + ECS_AOSOA_LANES - 1) / ECS_AOSOA_LANES * ECS_AOSOA_LANES;
+}
+
+// grow archetype if needed - leave space at end for one empty (used for temp swap data)
+// archetypes freed by ecsCompact are reallocated and returned to their queries
+static void ecsGrowArchetype(EcsInstance* instance, uint archetypeId)
+{
+    EcsArchetype* archetype = instance->ArchetypeContainer.archetypes + archetypeId;
+    const EcsArchetypeSignature* signature = instance->ArchetypeContainer.signatures + archetypeId;
+
+    if (archetype->entityCapacity == 0)
+    {
+        ecsRealtimeAllocation(instance);
+        ecsResizeArchetype(instance, archetype, signature, ecsProfileArchetypeCapacity(instance, archetypeId, ECS_DEFAULT_ARCHETYPE_ENTITY_CAPACITY));
+        ecsAddArchetypeToQueries(instance, archetypeId);
+        ++archetype->growthCount;
+    }
+    else if ((archetype->entityCount + 2) >= archetype->entityCapacity)
+    {
+        ecsRealtimeAllocation(instance);
+        ++archetype->growthCount;
+        ecsFinishArchetypeGrowth(instance, archetype, signature);
+        if (instance->GrowthContainer.stepBytes && ecsArchetypeRowSize(archetype, signature) * archetype->entityCapacity >= ECS_INCREMENTAL_GROWTH_MIN_BYTES)
+            ecsBeginArchetypeGrowth(instance, archetype, signature, archetype->entityCapacity * 2);
+        else
+            ecsResizeArchetype(instance, archetype, signature, archetype->entityCapacity * 2);
+    }
+    assert(archetype->entityCount < archetype->entityCapacity);
+    if (archetype->entityCount >= archetype->peakEntityCount)
+        archetype->peakEntityCount = archetype->entityCount + 1;
+}
+
 EcsInstance ecsCreateInstance()
 {
     EcsInstance instance;
     memset(&instance, 0, sizeof(EcsInstance));
+    instance.Allocator = callocatorDefault();
 
     instance.EntityContainer.capacity = ECS_DEFAULT_ENTITY_COUNT;
-    instance.EntityContainer.entities = (EcsEntity*)ecsAlloc(sizeof(EcsEntity) * ECS_DEFAULT_ENTITY_COUNT, ECS_ALIGNMENT);
+    instance.EntityContainer.entities = (EcsEntity*)ecsAlloc(&instance, sizeof(EcsEntity) * ECS_DEFAULT_ENTITY_COUNT);
+    instance.EntityContainer.infos = (EcsEntityInfo*)ecsAlloc(&instance, sizeof(EcsEntityInfo) * ECS_DEFAULT_ENTITY_COUNT);
 
     instance.ArchetypeContainer.capacity = ECS_DEFAULT_ARCHETYPE_COUNT;
-    instance.ArchetypeContainer.archetypes = (EcsArchetype*)ecsAlloc(sizeof(EcsArchetype) * ECS_DEFAULT_ARCHETYPE_COUNT, ECS_ALIGNMENT);
-    instance.ArchetypeContainer.signatures = (EcsArchetypeSignature*)ecsAlloc(sizeof(EcsArchetypeSignature) * ECS_DEFAULT_ARCHETYPE_COUNT, ECS_ALIGNMENT);
+    instance.ArchetypeContainer.archetypes = (EcsArchetype*)ecsAlloc(&instance, sizeof(EcsArchetype) * ECS_DEFAULT_ARCHETYPE_COUNT);
+    instance.ArchetypeContainer.signatures = (EcsArchetypeSignature*)ecsAlloc(&instance, sizeof(EcsArchetypeSignature) * ECS_DEFAULT_ARCHETYPE_COUNT);
 
     instance.QueryContainer.capacity = ECS_DEFAULT_QUERY_COUNT;
-    instance.QueryContainer.queries = (EcsQuery*)ecsAlloc(sizeof(EcsQuery) * ECS_DEFAULT_QUERY_COUNT, ECS_ALIGNMENT);
+    instance.QueryContainer.queries = (EcsQuery*)ecsAlloc(&instance, sizeof(EcsQuery) * ECS_DEFAULT_QUERY_COUNT);
+    instance.QueryContainer.columnTables = (EcsQueryColumnTable*)ecsAlloc(&instance, sizeof(EcsQueryColumnTable) * ECS_DEFAULT_QUERY_COUNT);
+    memset(instance.QueryContainer.columnTables, 0, sizeof(EcsQueryColumnTable) * ECS_DEFAULT_QUERY_COUNT);
 
 
     return instance;
@@ -130,8 +840,14 @@ EcsInstance ecsCreateInstance()
 
 // policy: look for existing matching signiture archetype or create new archetype and move all component data
 // adding components is expensive
-void ecsAddComponentToEntity(EcsInstance* instance, uint entityId, uint componentId, size_t sizeofComponent)
+static void ecsAddComponentToEntityUnrecorded(EcsInstance* instance, uint entityId, uint componentId, size_t sizeofComponent)
 {
+    if (instance->SparseContainer.components[componentId])
+    {
+        ecsAddSparseComponent(instance, entityId, componentId);
+        return;
+    }
+
     // get archetype signiture of entity
     EcsEntity* entity = &instance->EntityContainer.entities[entityId];
     EcsArchetypeSignature signature = instance->ArchetypeContainer.signatures[entity->archetypeId];
@@ -190,7 +906,14 @@ void ecsAddComponentToEntity(EcsInstance* instance, uint entityId, uint componen
             if (*sigIdItr == (uint)-1)
                 break;
             comDescItr->id = *sigIdItr;
+            if (*sigIdItr == componentId)
+            {
+                comDescItr->stride = (uint)sizeofComponent;
+                comDescItr->fieldSize = 0;
+                continue;
+            }
             comDescItr->stride = (uint)arch->componentArrays[*sigIdItr].stride;
+            comDescItr->fieldSize = arch->componentArrays[*sigIdItr].fieldSize;
         }
 
 
@@ -201,51 +924,51 @@ void ecsAddComponentToEntity(EcsInstance* instance, uint entityId, uint componen
     // move entity data to new archetype
     EcsArchetype* newarchetype = ecsGetArchetype(instance, archId);
     EcsArchetype* oldarchetype = ecsGetArchetype(instance, entity->archetypeId);
+    const EcsArchetypeSignature* oldsignature = &instance->ArchetypeContainer.signatures[entity->archetypeId];
+    const uint oldarchid = entity->archetypeId;
     uint oldcomponentsid = entity->componentsId;
     assert(oldarchetype->entityIds[oldcomponentsid] == entityId);
 
-    // grow newarchetype if needed - leave space at end for one empty (used for temp swap data)
-    if ((newarchetype->entityCount + 2) >= newarchetype->entityCapacity)
-    {
-        uint newCapacity = newarchetype->entityCapacity * 2;
-        for (uint* sigIdItr = signature.componentIds; *sigIdItr != (uint)-1; ++sigIdItr)
-        {
-            EcsComponentArray* compArray = &newarchetype->componentArrays[*sigIdItr];
-            compArray->components = (byte*)ecsRealloc(compArray->components, compArray->stride * newCapacity, ECS_ALIGNMENT);
-        }
-        newarchetype->entityIds = (uint*)ecsRealloc(newarchetype->entityIds, sizeof(uint) * newCapacity, ECS_ALIGNMENT);
-        newarchetype->entityCapacity = newCapacity;
-    }
-    assert(newarchetype->entityCount < newarchetype->entityCapacity);
+    // grow newarchetype if needed
+    ecsGrowArchetype(instance, archId);
 
     // copy component data to new archetype
     {
-        EcsComponentsResultEx componentsDataOld;
-        ecsGetComponentsFromEntityIdEx(instance, &componentsDataOld, entityId);
-    
-        entity->archetypeId = archId;
-        entity->componentsId = newarchetype->entityCount;
-    
-        EcsComponentsResult componentsDataNew;
-        ecsGetComponentsFromEntityId(instance, &componentsDataNew, entityId);
-
-        for (uint i = 0, n = componentsDataOld.count; i < n; ++i)
+        const uint newcomponentsid = newarchetype->entityCount;
+        for (const uint* sigIdItr = oldsignature->componentIds; *sigIdItr != (uint)-1; ++sigIdItr)
         {
-            memcpy(componentsDataNew.components[i], componentsDataOld.descs[i].data, componentsDataOld.descs[i].stride);
+            ecsCopyComponent(newarchetype, &newarchetype->componentArrays[*sigIdItr], newcomponentsid, oldarchetype, &oldarchetype->componentArrays[*sigIdItr], oldcomponentsid);
         }
-    }
 
+        // disabled entities stay disabled
+        const uint bEnabled = ecsRowEnabled(oldarchetype, oldcomponentsid);
+        ecsSetRowEnabled(newarchetype, newcomponentsid, bEnabled);
+        oldarchetype->disabledCount -= bEnabled ^ 1;
+        newarchetype->disabledCount += bEnabled ^ 1;
+
+        entity->archetypeId = archId;
+        entity->componentsId = newcomponentsid;
+        ecsSnapshotMarkRow(instance, archId, newcomponentsid);
+    }
 
-    // remove entity from old archetype
-    {
-        // shift entity data over removed
-        byte* mvdst = (byte*)(oldarchetype->entityIds + oldcomponentsid);
-        byte* mvsrc = (byte*)(oldarchetype->entityIds + oldcomponentsid + 1);
-        byte* mvend = (byte*)(oldarchetype->entityIds + oldarchetype->entityCount);
-        size_t mvsize = mvend - mvsrc;
-        memmove(mvdst, mvsrc, mvsize);
 
-        --oldarchetype->entityCount;
+    // remove entity from old archetype, the last entity is moved into the removed slot
+    {
+        const uint lastcomponentsid = --oldarchetype->entityCount;
+        if (oldcomponentsid != lastcomponentsid)
+        {
+            const uint lastentityid = oldarchetype->entityIds[lastcomponentsid];
+            for (const uint* sigIdItr = oldsignature->componentIds; *sigIdItr != (uint)-1; ++sigIdItr)
+            {
+                EcsComponentArray* componentGroup = &oldarchetype->componentArrays[*sigIdItr];
+                ecsCopyComponent(oldarchetype, componentGroup, oldcomponentsid, oldarchetype, componentGroup, lastcomponentsid);
+            }
+            oldarchetype->entityIds[oldcomponentsid] = lastentityid;
+            instance->EntityContainer.entities[lastentityid].componentsId = oldcomponentsid;
+            ecsSetRowEnabled(oldarchetype, oldcomponentsid, ecsRowEnabled(oldarchetype, lastcomponentsid));
+            ecsSnapshotMarkRow(instance, oldarchid, oldcomponentsid);
+        }
+        ecsSetRowEnabled(oldarchetype, lastcomponentsid, 0);
     }
 
     assert(newarchetype->entityIds);
@@ -253,11 +976,52 @@ void ecsAddComponentToEntity(EcsInstance* instance, uint entityId, uint componen
     ++newarchetype->entityCount;
 }
 
+void ecsAddComponentToEntity(EcsInstance* instance, uint entityId, uint componentId, size_t sizeofComponent)
+{
+    // sparse adds record their own event, replicas reject ADD_COMPONENT for sparse ids
+    if (instance->SparseContainer.components[componentId])
+    {
+        ecsAddSparseComponent(instance, entityId, componentId);
+        return;
+    }
+    const uint event[3] = { entityId, componentId, (uint)sizeofComponent };
+    ecsDeltaRecord(instance, ECS_DELTA_ADD_COMPONENT, 3, event);
+    ++instance->DeltaContainer.depth;
+    ecsAddComponentToEntityUnrecorded(instance, entityId, componentId, sizeofComponent);
+    --instance->DeltaContainer.depth;
+}
+
 EcsEntity* ecsGetEntity(EcsInstance* instance, uint entityId)
 {
     return &instance->EntityContainer.entities[entityId];
 }
 
+EcsEntityInfo* ecsGetEntityInfo(EcsInstance* instance, uint entityId)
+{
+    return &instance->EntityContainer.infos[entityId];
+}
+
+void ecsSetEntityEnabled(EcsInstance* instance, uint entityId, uint bEnabled)
+{
+    const EcsEntity* entity = &instance->EntityContainer.entities[entityId];
+    assert(entity->archetypeId != ECS_INVALID_ID && "entity destroyed");
+    EcsArchetype* archetype = &instance->ArchetypeContainer.archetypes[entity->archetypeId];
+    bEnabled = bEnabled != 0;
+    if (ecsRowEnabled(archetype, entity->componentsId) == bEnabled)
+        return;
+
+    const uint event[2] = { entityId, bEnabled };
+    ecsDeltaRecord(instance, ECS_DELTA_SET_ENTITY_ENABLED, 2, event);
+    ecsSetRowEnabled(archetype, entity->componentsId, bEnabled);
+    archetype->disabledCount += bEnabled ? (uint)-1 : 1;
+}
+
+uint ecsIsEntityEnabled(EcsInstance* instance, uint entityId)
+{
+    const EcsEntity* entity = &instance->EntityContainer.entities[entityId];
+    return ecsRowEnabled(&instance->ArchetypeContainer.archetypes[entity->archetypeId], entity->componentsId);
+}
+
 EcsArchetype* ecsGetArchetype(EcsInstance* instance, uint archetypeId)
 {
     return &instance->ArchetypeContainer.archetypes[archetypeId];
@@ -274,28 +1038,27 @@ EcsArchetype* ecsGetArchetypeFromEntityId(EcsInstance* instance, uint entityId)
     return &instance->ArchetypeContainer.archetypes[entity->archetypeId];
 }
 
-inline EcsArchetypeSignature* ecsGetArchetypeSignature(EcsInstance* instance, uint archetypeId)
+static inline EcsArchetypeSignature* ecsGetArchetypeSignature(EcsInstance* instance, uint archetypeId)
 {
     return &instance->ArchetypeContainer.signatures[archetypeId];
 }
 
 void* ecsGetComponentFromArchetype(const EcsArchetype* archetype, uint componentTypeId, uint componentIndex)
 {
-    const EcsComponentArray* componentArray = &archetype->componentArrays[componentTypeId];
-    byte* component = &componentArray->components[componentIndex * componentArray->stride];
-    return (void*)component;
+    return (void*)ecsComponentAt(archetype, &archetype->componentArrays[componentTypeId], componentIndex);
 }
 
 void* ecsGetComponentFromArchetypeId(EcsInstance* instance, uint archetypeId, uint componentTypeId, uint componentIndex)
 {
     EcsArchetype* archetype = &instance->ArchetypeContainer.archetypes[archetypeId];
-    EcsComponentArray* componentArray = &archetype->componentArrays[componentTypeId];
-    byte* component = &componentArray->components[componentIndex * componentArray->stride];
-    return (void*)component;
+    return (void*)ecsComponentAt(archetype, &archetype->componentArrays[componentTypeId], componentIndex);
 }
 
 void* ecsGetComponentFromEntityId(EcsInstance* instance, uint entityId, uint componentTypeId)
 {
+    if (instance->SparseContainer.components[componentTypeId])
+        return ecsGetSparseComponent(instance, entityId, componentTypeId);
+
     const EcsEntity* entity = &instance->EntityContainer.entities[entityId];
     return ecsGetComponentFromArchetypeId(instance, entity->archetypeId, componentTypeId, entity->componentsId);
 }
@@ -316,7 +1079,7 @@ void ecsGetComponentsFromEntityId(EcsInstance* instance, EcsComponentsResult* ds
             break;
 
         EcsComponentArray* pComArray = &archetype->componentArrays[*pSigComId];
-        *pDstPtr = (uintptr_t)pComArray->components[pComArray->stride * componentsId];
+        *pDstPtr = (uintptr_t)ecsComponentAt(archetype, pComArray, componentsId);
 
         ++pSigComId;
         ++pDstPtr;
@@ -339,11 +1102,28 @@ void ecsGetComponentsFromEntityIdEx(EcsInstance* instance, EcsComponentsResultEx
         comArray = &archetype->componentArrays[*comIdItr];
         descsItr->id = *comIdItr;
         descsItr->stride = (uint)comArray->stride;
-        descsItr->data = &comArray->components[comIdx * comArray->stride];
+        descsItr->data = ecsComponentAt(archetype, comArray, comIdx);
     }
     dst->count = count;
 }
 
+void ecsLoadComponentFromEntityId(EcsInstance* instance, uint entityId, uint componentTypeId, void* dst)
+{
+    const EcsEntity* entity = &instance->EntityContainer.entities[entityId];
+    EcsArchetype* archetype = &instance->ArchetypeContainer.archetypes[entity->archetypeId];
+    ecsTransferComponent(archetype, &archetype->componentArrays[componentTypeId], entity->componentsId, (byte*)dst, 1);
+}
+
+void ecsStoreComponentToEntityId(EcsInstance* instance, uint entityId, uint componentTypeId, const void* src)
+{
+    const EcsEntity* entity = &instance->EntityContainer.entities[entityId];
+    EcsArchetype* archetype = &instance->ArchetypeContainer.archetypes[entity->archetypeId];
+    EcsComponentArray* componentArray = &archetype->componentArrays[componentTypeId];
+    ecsTransferComponent(archetype, componentArray, entity->componentsId, (byte*)src, 0);
+    if (componentArray->snapshotId != ECS_INVALID_ID)
+        ecsSnapshotMarkChunk(instance, componentArray->snapshotId, entity->componentsId);
+}
+
 EcsQuery* ecsGetQuery(EcsInstance* instance, uint queryId)
 {
     return &instance->QueryContainer.queries[queryId];
@@ -368,15 +1148,22 @@ uint ecsCreateArchetype(EcsInstance* instance, uint componentCount, EcsComponent
 {
     uint archId = instance->ArchetypeContainer.count;
 
+    if (ecsDeltaRecording(instance))
+    {
+        uint event[2 + ECS_MAX_COMPONENT_TYPES * 3];
+        event[0] = componentCount;
+        event[1] = initialCapacity;
+        memcpy(event + 2, componentDescs, sizeof(EcsComponentDesc) * componentCount);
+        ecsDeltaRecord(instance, ECS_DELTA_CREATE_ARCHETYPE, 2 + componentCount * 3, event);
+    }
+
     // allocate archetype capacity
     if (instance->ArchetypeContainer.count == instance->ArchetypeContainer.capacity)
     {
-        uint newCapacity = instance->ArchetypeContainer.capacity * 2;
-        instance->ArchetypeContainer.archetypes = (EcsArchetype*)ecsRealloc(instance->ArchetypeContainer.archetypes, sizeof(EcsArchetype) * newCapacity, ECS_ALIGNMENT);
-        instance->ArchetypeContainer.signatures = (EcsArchetypeSignature*)ecsRealloc(instance->ArchetypeContainer.signatures, sizeof(EcsArchetypeSignature) * newCapacity, ECS_ALIGNMENT);
-        instance->ArchetypeContainer.capacity = newCapacity;
+        ecsReserveArchetypeCapacity(instance, instance->ArchetypeContainer.capacity * 2);
     }
     assert(instance->ArchetypeContainer.count < instance->ArchetypeContainer.capacity);
+    ecsRealtimeAllocation(instance);
 
     ++instance->ArchetypeContainer.count;
 
@@ -384,26 +1171,41 @@ uint ecsCreateArchetype(EcsInstance* instance, uint componentCount, EcsComponent
     EcsArchetype* arch = instance->ArchetypeContainer.archetypes + archId;
     assert(arch);
     memset(arch, 0, sizeof(EcsArchetype));
-    uint capacity = initialCapacity ? initialCapacity : ECS_DEFAULT_ARCHETYPE_ENTITY_CAPACITY;
+    const uint capacity = ecsProfileArchetypeCapacity(instance, archId, initialCapacity ? initialCapacity : ECS_DEFAULT_ARCHETYPE_ENTITY_CAPACITY);
     arch->entityCapacity = capacity;
 
     // allocate entities capacity
     {
-        arch->entityIds = (uint*)ecsAlloc(sizeof(uint) * capacity, ECS_ALIGNMENT);
+        arch->entityIds = (uint*)ecsAlloc(instance, sizeof(uint) * capacity);
+        arch->enabledMask = (uint64_t*)ecsAlloc(instance, ecsEnabledMaskSize(capacity));
+        memset(arch->enabledMask, 0, ecsEnabledMaskSize(capacity));
     }
 
     for (uint i = 0; i < componentCount; ++i)
     {
         EcsComponentDesc comDesc = componentDescs[i];
         assert(comDesc.id < ECS_MAX_COMPONENT_TYPES);
+        assert(instance->SparseContainer.components[comDesc.id] == 0 && "sparse components are not stored in archetypes");
         EcsComponentArray* comArray = &arch->componentArrays[comDesc.id];
         // allocate a component for each entity
-        comArray->components = (byte*)ecsAlloc((size_t)comDesc.stride * capacity, ECS_ALIGNMENT);
+        assert((comDesc.fieldSize == 0 || comDesc.stride % comDesc.fieldSize == 0) && "AoSoA component stride must be a multiple of fieldSize");
+        comArray->components = (byte*)ecsAlloc(instance, (size_t)comDesc.stride * capacity);
         comArray->stride = (size_t)comDesc.stride;
+        comArray->fieldSize = comDesc.fieldSize;
+        comArray->snapshotId = ECS_INVALID_ID;
     }
 
     ecsCreateArchetypeSigniture(instance, archId, componentCount, componentDescs);
 
+    // queries created before this archetype also iterate it
+    ecsAddArchetypeToQueries(instance, archId);
+
+    for (uint i = 0; i < componentCount; ++i)
+    {
+        if (instance->SnapshotContainer.components[componentDescs[i].id])
+            ecsCreateSnapshotTracker(instance, archId, componentDescs[i].id);
+    }
+
     return archId;
 }
 
@@ -415,9 +1217,7 @@ uint ecsCreateQuery(EcsInstance* instance, uint componentCount, uint componentId
     // allocate capacity
     if (instance->QueryContainer.count == instance->QueryContainer.capacity)
     {
-        uint newCapacity = instance->QueryContainer.capacity * 2;
-        instance->QueryContainer.queries = (EcsQuery*)ecsRealloc(instance->QueryContainer.queries, sizeof(EcsQuery) * newCapacity, ECS_ALIGNMENT);
-        instance->QueryContainer.capacity = newCapacity;
+        ecsReserveQueryCapacity(instance, instance->QueryContainer.capacity * 2);
     }
     assert(instance->QueryContainer.count < instance->QueryContainer.capacity);
     assert(instance->QueryContainer.queries);
@@ -428,20 +1228,28 @@ uint ecsCreateQuery(EcsInstance* instance, uint componentCount, uint componentId
     query->componentCount = componentCount;
     ++instance->QueryContainer.count;
 
+    // first component id is named, remaining are variadic
     va_list args;
-    va_start(args, componentCount);
-    for (uint i = 0; i < componentCount; ++i)
+    va_start(args, componentIds);
+    query->componentIds[0] = componentIds;
+    for (uint i = 1; i < componentCount; ++i)
     {
         query->componentIds[i] = va_arg(args, uint);
     }
     va_end(args);
 
+    query->sparseMask = 0;
+    for (uint i = 0; i < componentCount; ++i)
+    {
+        query->sparseMask |= (uint)instance->SparseContainer.components[query->componentIds[i]] << i;
+    }
+
 #if !defined(NDEBUG)
     // check if query already exists
     for (uint i = 0; i < queryId; ++i)
     {
         EcsQuery* queryItr = &instance->QueryContainer.queries[i];
-        if (memcmp(query, queryItr->componentIds, sizeof(queryItr->componentIds)) == 0)
+        if (queryItr->componentCount == query->componentCount && memcmp(query->componentIds, queryItr->componentIds, sizeof(uint) * componentCount) == 0)
         {
             // log warning
             fprintf(stderr, "warning: ecsCreateQuery: attempt to create query that already exists, returning found query");
@@ -451,39 +1259,21 @@ uint ecsCreateQuery(EcsInstance* instance, uint componentCount, uint componentId
     }
 #endif
 
-    EcsArchetypeSignature* sigBgn = instance->ArchetypeContainer.signatures;
-    EcsArchetypeSignature* sigItr = sigBgn;
-    EcsArchetypeSignature* sigEnd = sigBgn + instance->ArchetypeContainer.count;
-    EcsArchetype** archItr = query->archetypes;
-
+    // archetypes freed by ecsCompact are added back when they are reallocated
     uint bQueryValid = 0;
-    for (; sigItr != sigEnd; ++sigItr, ++archItr, ++query->archetypeCount)
+    for (uint archId = 0; archId < instance->ArchetypeContainer.count; ++archId)
     {
-        uint bContainsQuery = 1;
-
-        for (uint* qIdItr = query->componentIds, *qIdEnd = qIdItr+componentCount; qIdItr != qIdEnd; ++qIdItr)
-        {
-            uint bContainsId = 0;
-            for (uint* sigIdItr = sigItr->componentIds; *sigIdItr != (uint)-1; ++sigIdItr)
-            {
-                bContainsId += *qIdItr == *sigIdItr;
-            }
-
-            if (bContainsId == 0)
-            {
-                bContainsQuery = 0;
-                break;
-            }
-        }
-
-        if (bContainsQuery == 0)
+        if (ecsSignatureHasQuery(&instance->ArchetypeContainer.signatures[archId], query) == 0)
             continue;
 
-        uint archId = (uint)(sigItr - sigBgn);
-        *archItr = &instance->ArchetypeContainer.archetypes[archId];
         bQueryValid = 1;
+        if (instance->ArchetypeContainer.archetypes[archId].entityCapacity == 0)
+            continue;
+
+        ecsAppendQueryArchetype(instance, queryId, &instance->ArchetypeContainer.archetypes[archId]);
     }
     assert(bQueryValid && "Invalid query paramaters - no archetypes found");
+    (void)bQueryValid;
 
     return queryId;
 }
@@ -492,11 +1282,13 @@ uint ecsCreateEntity(EcsInstance* instance, uint archetypeId)
 {
     uint entityId = instance->EntityContainer.count;
 
+    const uint event[2] = { entityId, archetypeId };
+    ecsDeltaRecord(instance, ECS_DELTA_CREATE_ENTITY, 2, event);
+
     if (instance->EntityContainer.count == instance->EntityContainer.capacity)
     {
-        uint newCapacity = instance->EntityContainer.capacity * 2;
-        instance->EntityContainer.entities = (EcsEntity*)ecsRealloc(instance->EntityContainer.entities, sizeof(EcsEntity) * newCapacity, ECS_ALIGNMENT);
-        instance->EntityContainer.capacity = newCapacity;
+        ecsReserveEntityCapacity(instance, instance->EntityContainer.capacity * 2);
+        ++instance->ProfileContainer.entityGrowthCount;
     }
     assert(instance->EntityContainer.count < instance->EntityContainer.capacity);
 
@@ -505,26 +1297,21 @@ uint ecsCreateEntity(EcsInstance* instance, uint archetypeId)
     ++instance->EntityContainer.count;
 
     EcsArchetype* archetype = instance->ArchetypeContainer.archetypes + archetypeId;
-    EcsArchetypeSignature* signiture = instance->ArchetypeContainer.signatures + archetypeId;
 
     entity->archetypeId = archetypeId;
     entity->componentsId = archetype->entityCount;
 
+    EcsEntityInfo* info = instance->EntityContainer.infos + entityId;
+    info->sortOrder = 0;
+    info->flags = 0;
+
     // grow archetype if needed - allocates 1 extra at end for temp swap data
-    if ((archetype->entityCount + 2) >= archetype->entityCapacity)
-    {
-        uint newCapacity = archetype->entityCapacity * 2;
-        for (uint* sigIdItr = signiture->componentIds; *sigIdItr != 0xFFFFFFFF; ++sigIdItr)
-        {
-            EcsComponentArray* compArray = &archetype->componentArrays[*sigIdItr];
-            compArray->components = (byte*)ecsRealloc(compArray->components, compArray->stride * newCapacity, ECS_ALIGNMENT);
-        }
-        archetype->entityIds = (uint*)ecsRealloc(archetype->entityIds, sizeof(uint) * newCapacity, ECS_ALIGNMENT);
-        archetype->entityCapacity = newCapacity;
-    }
+    ecsGrowArchetype(instance, archetypeId);
 
     assert(archetype->entityIds);
     archetype->entityIds[archetype->entityCount] = entityId;
+    ecsSetRowEnabled(archetype, archetype->entityCount, 1);
+    ecsSnapshotMarkRow(instance, archetypeId, archetype->entityCount);
     ++archetype->entityCount;
 
     return entityId;
@@ -535,91 +1322,206 @@ EcsQueryIterator ecsCreateQueryIterator(EcsInstance* instance, uint queryId)
     EcsQuery* query = &instance->QueryContainer.queries[queryId];
     EcsQueryIterator out;
     out.query = query;
+    out.columnTable = &instance->QueryContainer.columnTables[queryId];
+    out.sparseSets = instance->SparseContainer.sets;
     out.archIdIndex = 0;
     out.archEntityIndex = -1;
+    out.laneMask = 0;
     return out;
 }
 
-EcsQueryIterator* ecsIterateQuery(EcsQueryIterator* itr, void** componentsArray)
+// pointers to the sparse components of a query for an entity, returns 0 if the entity is missing any
+static inline uint ecsJoinSparseComponents(const EcsSparseSet* sets, const EcsQuery* query, uint entityId, void** componentsArray)
 {
-    // initial value is -1, so first call sets to 0
-    ++itr->archEntityIndex;
+    for (uint i = 0, n = query->componentCount; i < n; ++i)
+    {
+        if ((query->sparseMask & (1u << i)) == 0)
+            continue;
 
-    EcsQuery* query = itr->query;
-    EcsArchetype* archetype = query->archetypes[itr->archIdIndex];
+        const EcsSparseSet* set = &sets[query->componentIds[i]];
+        if (entityId >= set->sparseCapacity || set->sparse[entityId] == ECS_INVALID_ID)
+            return 0;
+        componentsArray[i] = &set->components[set->stride * set->sparse[entityId]];
+    }
+    return 1;
+}
 
-    if (itr->archEntityIndex == archetype->entityCount)
+// pointers to the archetype components of a query for an archetype row, from the cached columns
+static inline void ecsGetQueryComponents(const EcsQuery* query, const EcsQueryColumns* columns, uint archEntityIndex, void** componentsArray)
+{
+    if (columns->bAoS && query->sparseMask == 0)
     {
-        ++itr->archIdIndex;
-        // end of query
-        if (itr->archIdIndex == query->archetypeCount)
-            return NULL;
-        archetype = query->archetypes[itr->archIdIndex];
-        itr->archEntityIndex = 0;
+        for (uint i = 0, n = query->componentCount; i < n; ++i)
+            componentsArray[i] = columns->components[i] + (size_t)columns->strides[i] * archEntityIndex;
+        return;
     }
 
+    const uint block = archEntityIndex / ECS_AOSOA_LANES;
+    const uint lane = archEntityIndex % ECS_AOSOA_LANES;
     for (uint i = 0, n = query->componentCount; i < n; ++i)
     {
-        uint comId = query->componentIds[i];
-        EcsComponentArray* comArray = &archetype->componentArrays[comId];
-        void* comp = &comArray->components[itr->archEntityIndex * comArray->stride];
-        componentsArray[i] = comp;
+        if (query->sparseMask & (1u << i))
+            continue;
+
+        if (columns->fieldSizes[i] == 0)
+            componentsArray[i] = columns->components[i] + (size_t)columns->strides[i] * archEntityIndex;
+        else
+            componentsArray[i] = columns->components[i] + (size_t)columns->strides[i] * ECS_AOSOA_LANES * block + (size_t)columns->fieldSizes[i] * lane;
     }
+}
 
-    return itr;
+// pointers to the archetype components of a query for a row of an archetype migrated by incremental growth
+static void ecsGetMigratingQueryComponents(const EcsQuery* query, const EcsArchetype* archetype, uint archEntityIndex, void** componentsArray)
+{
+    for (uint i = 0, n = query->componentCount; i < n; ++i)
+    {
+        if ((query->sparseMask & (1u << i)) == 0)
+            componentsArray[i] = ecsComponentAt(archetype, &archetype->componentArrays[query->componentIds[i]], archEntityIndex);
+    }
+}
+
+// advance to the next entity with all query components, returns its archetype or NULL when the query has ended
+static inline EcsArchetype* ecsIterateQueryNext(EcsQueryIterator* itr, void** componentsArray)
+{
+    EcsQuery* query = itr->query;
+    for (;;)
+    {
+        // initial value is -1, so first call sets to 0
+        ++itr->archEntityIndex;
+
+        // advance past disabled entities, finished and empty archetypes
+        while (itr->archIdIndex < query->archetypeCount)
+        {
+            const EcsArchetype* archetype = query->archetypes[itr->archIdIndex];
+            itr->archEntityIndex = ecsNextEnabledRow(archetype, itr->archEntityIndex);
+            if (itr->archEntityIndex < archetype->entityCount)
+                break;
+            ++itr->archIdIndex;
+            itr->archEntityIndex = 0;
+        }
+
+        // end of query
+        if (itr->archIdIndex >= query->archetypeCount)
+            return NULL;
+
+        EcsArchetype* archetype = query->archetypes[itr->archIdIndex];
+
+        // skip entities without the sparse components
+        if (query->sparseMask && ecsJoinSparseComponents(itr->sparseSets, query, archetype->entityIds[itr->archEntityIndex], componentsArray) == 0)
+            continue;
+
+        if (archetype->migrateEnd)
+            ecsGetMigratingQueryComponents(query, archetype, itr->archEntityIndex, componentsArray);
+        else
+            ecsGetQueryComponents(query, &itr->columnTable->columns[itr->archIdIndex], itr->archEntityIndex, componentsArray);
+        return archetype;
+    }
+}
+
+EcsQueryIterator* ecsIterateQuery(EcsQueryIterator* itr, void** componentsArray)
+{
+    return ecsIterateQueryNext(itr, componentsArray) ? itr : NULL;
 }
 
 EcsQueryIterator* ecsIterateQueryEx(EcsQueryIterator* itr, uint* entityId, void** componentsArray)
+{
+    EcsArchetype* archetype = ecsIterateQueryNext(itr, componentsArray);
+    if (archetype == NULL)
+        return NULL;
+
+    *entityId = archetype->entityIds[itr->archEntityIndex];
+    
+    return itr;
+}
+
+EcsQueryIterator* ecsIterateQueryBlock(EcsQueryIterator* itr, uint* laneCount, void** componentsArray)
 {
     // initial value is -1, so first call sets to 0
-    ++itr->archEntityIndex;
+    itr->archEntityIndex = itr->archEntityIndex == (uint)-1 ? 0 : itr->archEntityIndex + ECS_AOSOA_LANES;
 
     EcsQuery* query = itr->query;
-    EcsArchetype* archetype = query->archetypes[itr->archIdIndex];
+    assert(query->sparseMask == 0 && "queries with sparse components can not be block iterated");
 
-    if (itr->archEntityIndex == archetype->entityCount)
+    // advance past fully disabled blocks, finished and empty archetypes
+    while (itr->archIdIndex < query->archetypeCount)
     {
+        const EcsArchetype* archetype = query->archetypes[itr->archIdIndex];
+        const uint row = ecsNextEnabledRow(archetype, itr->archEntityIndex);
+        if (row < archetype->entityCount)
+        {
+            itr->archEntityIndex = row / ECS_AOSOA_LANES * ECS_AOSOA_LANES;
+            break;
+        }
         ++itr->archIdIndex;
-        // end of query
-        if (itr->archIdIndex == query->archetypeCount)
-            return NULL;
-        archetype = query->archetypes[itr->archIdIndex];
         itr->archEntityIndex = 0;
     }
 
+    // end of query
+    if (itr->archIdIndex >= query->archetypeCount)
+        return NULL;
+
+    EcsArchetype* archetype = query->archetypes[itr->archIdIndex];
+    uint remaining = archetype->entityCount - itr->archEntityIndex;
+    *laneCount = remaining < ECS_AOSOA_LANES ? remaining : ECS_AOSOA_LANES;
+    itr->laneMask = ecsBlockEnabledMask(archetype, itr->archEntityIndex, *laneCount);
+
+    // block start, AoSoA offset of lane 0 is the block itself
+    if (archetype->migrateEnd)
+    {
+        ecsGetMigratingQueryComponents(query, archetype, itr->archEntityIndex, componentsArray);
+        return itr;
+    }
+    const EcsQueryColumns* columns = &itr->columnTable->columns[itr->archIdIndex];
     for (uint i = 0, n = query->componentCount; i < n; ++i)
     {
-        uint comId = query->componentIds[i];
-        EcsComponentArray* comArray = &archetype->componentArrays[comId];
-        void* comp = &comArray->components[itr->archEntityIndex * comArray->stride];
-        componentsArray[i] = comp;
+        componentsArray[i] = columns->components[i] + (size_t)columns->strides[i] * itr->archEntityIndex;
     }
 
-    *entityId = archetype->entityIds[itr->archEntityIndex];
-    
     return itr;
 }
 
 void ecsIterateQueryCallback(EcsInstance* instance, uint queryId, EcsQueryCallback callback)
 {
     EcsQuery* query = &instance->QueryContainer.queries[queryId];
+    const EcsQueryColumnTable* table = &instance->QueryContainer.columnTables[queryId];
+    const EcsSparseSet* sets = instance->SparseContainer.sets;
     uint archCount = query->archetypeCount;
     uint comCount = query->componentCount;
     EcsArchetype* archetype;
+    const EcsQueryColumns* columns;
     uint entCount;
-    EcsComponentArray* comArray;
+    byte* rows[ECS_MAX_QUERY_COMPONENTS];
     void* coms[ECS_MAX_QUERY_COMPONENTS];
     for (uint archIdx = 0; archIdx < archCount; ++archIdx)
     {
         archetype = query->archetypes[archIdx];
+        columns = &table->columns[archIdx];
         entCount = archetype->entityCount;
-        for (uint entIdx = 0; entIdx < entCount; ++entIdx)
+
+        // every row of AoS columns, pointer increments only
+        if (query->sparseMask == 0 && columns->bAoS && archetype->disabledCount == 0 && archetype->migrateEnd == 0)
         {
-            for (uint comIdx = 0; comIdx < comCount; ++comIdx)
+            memcpy(rows, columns->components, sizeof(byte*) * comCount);
+            for (uint entIdx = 0; entIdx < entCount; ++entIdx)
             {
-                comArray = &archetype->componentArrays[query->componentIds[comIdx]];
-                coms[comIdx] = &comArray->components[comArray->stride * entIdx];
+                for (uint comIdx = 0; comIdx < comCount; ++comIdx)
+                {
+                    coms[comIdx] = rows[comIdx];
+                    rows[comIdx] += columns->strides[comIdx];
+                }
+                callback(coms);
             }
+            continue;
+        }
+
+        for (uint entIdx = ecsNextEnabledRow(archetype, 0); entIdx < entCount; entIdx = ecsNextEnabledRow(archetype, entIdx + 1))
+        {
+            if (query->sparseMask && ecsJoinSparseComponents(sets, query, archetype->entityIds[entIdx], coms) == 0)
+                continue;
+            if (archetype->migrateEnd)
+                ecsGetMigratingQueryComponents(query, archetype, entIdx, coms);
+            else
+                ecsGetQueryComponents(query, columns, entIdx, coms);
             callback(coms);
         }
     }
@@ -628,35 +1530,260 @@ void ecsIterateQueryCallback(EcsInstance* instance, uint queryId, EcsQueryCallba
 void ecsIterateQueryCallbackEx(EcsInstance* instance, uint queryId, EcsQueryCallbackEx callback)
 {
     EcsQuery* query = &instance->QueryContainer.queries[queryId];
+    const EcsQueryColumnTable* table = &instance->QueryContainer.columnTables[queryId];
+    const EcsSparseSet* sets = instance->SparseContainer.sets;
     uint archCount = query->archetypeCount;
     uint comCount = query->componentCount;
     EcsArchetype* archetype;
+    const EcsQueryColumns* columns;
     uint entCount;
     uint entId;
-    EcsComponentArray* comArray;
+    byte* rows[ECS_MAX_QUERY_COMPONENTS];
     void* coms[ECS_MAX_QUERY_COMPONENTS];
     for (uint archIdx = 0; archIdx < archCount; ++archIdx)
     {
         archetype = query->archetypes[archIdx];
+        columns = &table->columns[archIdx];
         entCount = archetype->entityCount;
-        for (uint entIdx = 0; entIdx < entCount; ++entIdx)
+
+        // every row of AoS columns, pointer increments only
+        if (query->sparseMask == 0 && columns->bAoS && archetype->disabledCount == 0 && archetype->migrateEnd == 0)
+        {
+            memcpy(rows, columns->components, sizeof(byte*) * comCount);
+            for (uint entIdx = 0; entIdx < entCount; ++entIdx)
+            {
+                for (uint comIdx = 0; comIdx < comCount; ++comIdx)
+                {
+                    coms[comIdx] = rows[comIdx];
+                    rows[comIdx] += columns->strides[comIdx];
+                }
+                callback(archetype->entityIds[entIdx], coms);
+            }
+            continue;
+        }
+
+        for (uint entIdx = ecsNextEnabledRow(archetype, 0); entIdx < entCount; entIdx = ecsNextEnabledRow(archetype, entIdx + 1))
         {
             entId = archetype->entityIds[entIdx];
+            if (query->sparseMask && ecsJoinSparseComponents(sets, query, entId, coms) == 0)
+                continue;
+            if (archetype->migrateEnd)
+                ecsGetMigratingQueryComponents(query, archetype, entIdx, coms);
+            else
+                ecsGetQueryComponents(query, columns, entIdx, coms);
+            callback(entId, coms);
+        }
+    }
+}
+
+uint ecsGetQueryEntityCount(EcsInstance* instance, uint queryId)
+{
+    const EcsQuery* query = &instance->QueryContainer.queries[queryId];
+    void* coms[ECS_MAX_QUERY_COMPONENTS];
+    uint count = 0;
+    for (uint archIdx = 0; archIdx < query->archetypeCount; ++archIdx)
+    {
+        const EcsArchetype* archetype = query->archetypes[archIdx];
+        if (query->sparseMask == 0)
+        {
+            count += archetype->entityCount - archetype->disabledCount;
+            continue;
+        }
+        for (uint entIdx = ecsNextEnabledRow(archetype, 0); entIdx < archetype->entityCount; entIdx = ecsNextEnabledRow(archetype, entIdx + 1))
+            count += ecsJoinSparseComponents(instance->SparseContainer.sets, query, archetype->entityIds[entIdx], coms);
+    }
+    return count;
+}
+
+// copy with non-temporal stores where available, caller fences once after all copies
+static void ecsStreamCopy(byte* dst, const byte* src, size_t size)
+{
+#if defined(ECS_STREAMING_STORES)
+    // align destination, stream 64 bytes at a time
+    size_t head = (16 - ((uintptr_t)dst & 15)) & 15;
+    if (head > size)
+        head = size;
+    memcpy(dst, src, head);
+    dst += head;
+    src += head;
+    size -= head;
+    for (; size >= 64; size -= 64, dst += 64, src += 64)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i*)src);
+        __m128i b = _mm_loadu_si128((const __m128i*)(src + 16));
+        __m128i c = _mm_loadu_si128((const __m128i*)(src + 32));
+        __m128i d = _mm_loadu_si128((const __m128i*)(src + 48));
+        _mm_stream_si128((__m128i*)dst, a);
+        _mm_stream_si128((__m128i*)(dst + 16), b);
+        _mm_stream_si128((__m128i*)(dst + 32), c);
+        _mm_stream_si128((__m128i*)(dst + 48), d);
+    }
+    for (; size >= 16; size -= 16, dst += 16, src += 16)
+        _mm_stream_si128((__m128i*)dst, _mm_loadu_si128((const __m128i*)src));
+#endif
+    memcpy(dst, src, size);
+}
+
+static void ecsStreamFence(void)
+{
+#if defined(ECS_STREAMING_STORES)
+    _mm_sfence();
+#endif
+}
+
+// AoSoA block of laneCount entities to packed structs
+static void ecsTransposeBlock(const EcsComponentArray* componentArray, const byte* block, uint laneCount, byte* dst)
+{
+    const size_t fieldSize = componentArray->fieldSize;
+    const size_t fieldCount = componentArray->stride / fieldSize;
+    if (fieldSize == 4)
+    {
+        // destination may be unaligned
+        const uint* src = (const uint*)block;
+        for (uint lane = 0; lane < laneCount; ++lane, dst += componentArray->stride)
+        {
+            for (size_t field = 0; field < fieldCount; ++field)
+                memcpy(dst + field * 4, &src[field * ECS_AOSOA_LANES + lane], 4);
+        }
+        return;
+    }
+    for (uint lane = 0; lane < laneCount; ++lane, dst += componentArray->stride)
+    {
+        for (size_t field = 0; field < fieldCount; ++field)
+            memcpy(dst + field * fieldSize, block + (field * ECS_AOSOA_LANES + lane) * fieldSize, fieldSize);
+    }
+}
+
+// export count rows of a dense column from row begin, AoSoA components are converted to structs through a cached staging buffer
+// the rows are contiguous from components, see ecsColumnRegion
+static void ecsExportColumn(const EcsArchetype* archetype, EcsComponentArray* componentArray, const byte* components, uint begin, uint count, byte* dst)
+{
+    if (componentArray->fieldSize == 0)
+    {
+        ecsStreamCopy(dst, components + componentArray->stride * begin, componentArray->stride * count);
+        return;
+    }
+
+    // rows before the first whole block
+    uint entIdx = 0;
+    for (; entIdx < count && (begin + entIdx) % ECS_AOSOA_LANES != 0; ++entIdx)
+        ecsTransferComponent(archetype, componentArray, begin + entIdx, dst + componentArray->stride * entIdx, 1);
 
+    const size_t blockSize = componentArray->stride * ECS_AOSOA_LANES;
+    byte staging[4096];
+    const uint stagingBlocks = blockSize <= sizeof(staging) ? (uint)(sizeof(staging) / blockSize) : 0;
+    const byte* block = components + (begin + entIdx) / ECS_AOSOA_LANES * blockSize;
+    while (entIdx < count)
+    {
+        // blocks too large to stage are written directly
+        if (stagingBlocks == 0)
+        {
+            const uint laneCount = count - entIdx < ECS_AOSOA_LANES ? count - entIdx : ECS_AOSOA_LANES;
+            ecsTransposeBlock(componentArray, block, laneCount, dst + componentArray->stride * entIdx);
+            block += blockSize;
+            entIdx += laneCount;
+            continue;
+        }
+
+        const uint stagedBegin = entIdx;
+        for (uint i = 0; i < stagingBlocks && entIdx < count; ++i)
+        {
+            const uint laneCount = count - entIdx < ECS_AOSOA_LANES ? count - entIdx : ECS_AOSOA_LANES;
+            ecsTransposeBlock(componentArray, block, laneCount, staging + componentArray->stride * (entIdx - stagedBegin));
+            block += blockSize;
+            entIdx += laneCount;
+        }
+        ecsStreamCopy(dst + componentArray->stride * stagedBegin, staging, componentArray->stride * (entIdx - stagedBegin));
+    }
+}
+
+uint ecsExportQuery(EcsInstance* instance, uint queryId, void** columns, uint* entityIds, uint capacity)
+{
+    const EcsQuery* query = &instance->QueryContainer.queries[queryId];
+    const EcsSparseSet* sets = instance->SparseContainer.sets;
+    const uint comCount = query->componentCount;
+    uint row = 0;
+
+    for (uint archIdx = 0; archIdx < query->archetypeCount && row < capacity; ++archIdx)
+    {
+        EcsArchetype* archetype = query->archetypes[archIdx];
+
+        // runs of enabled rows, one streaming copy per component - whole columns when no entity is disabled
+        if (query->sparseMask == 0)
+        {
+            for (uint begin = ecsNextEnabledRow(archetype, 0); begin < archetype->entityCount && row < capacity; )
+            {
+                const uint end = ecsNextDisabledRow(archetype, begin);
+                const uint count = end - begin < capacity - row ? end - begin : capacity - row;
+                for (uint comIdx = 0; comIdx < comCount; ++comIdx)
+                {
+                    if (columns[comIdx] == NULL)
+                        continue;
+                    EcsComponentArray* componentArray = &archetype->componentArrays[query->componentIds[comIdx]];
+                    byte* dst = (byte*)columns[comIdx] + componentArray->stride * row;
+                    for (uint regionBegin = begin, regionEnd; regionBegin < begin + count; regionBegin = regionEnd)
+                    {
+                        const byte* components = ecsColumnRegion(archetype, componentArray, regionBegin, &regionEnd);
+                        if (regionEnd > begin + count)
+                            regionEnd = begin + count;
+                        ecsExportColumn(archetype, componentArray, components, regionBegin, regionEnd - regionBegin, dst + componentArray->stride * (regionBegin - begin));
+                    }
+                }
+                if (entityIds)
+                    ecsStreamCopy((byte*)(entityIds + row), (const byte*)(archetype->entityIds + begin), sizeof(uint) * count);
+                row += count;
+                begin = ecsNextEnabledRow(archetype, end);
+            }
+            continue;
+        }
+
+        // joined rows, gathered one entity at a time
+        void* coms[ECS_MAX_QUERY_COMPONENTS];
+        for (uint entIdx = ecsNextEnabledRow(archetype, 0); entIdx < archetype->entityCount && row < capacity; entIdx = ecsNextEnabledRow(archetype, entIdx + 1))
+        {
+            const uint entId = archetype->entityIds[entIdx];
+            if (ecsJoinSparseComponents(sets, query, entId, coms) == 0)
+                continue;
             for (uint comIdx = 0; comIdx < comCount; ++comIdx)
             {
-                comArray = &archetype->componentArrays[query->componentIds[comIdx]];
-                coms[comIdx] = &comArray->components[comArray->stride * entIdx];
+                if (columns[comIdx] == NULL)
+                    continue;
+                const uint comId = query->componentIds[comIdx];
+                if (query->sparseMask & (1u << comIdx))
+                {
+                    memcpy((byte*)columns[comIdx] + sets[comId].stride * row, coms[comIdx], sets[comId].stride);
+                    continue;
+                }
+                EcsComponentArray* componentArray = &archetype->componentArrays[comId];
+                ecsTransferComponent(archetype, componentArray, entIdx, (byte*)columns[comIdx] + componentArray->stride * row, 1);
             }
-            callback(entId, coms);
+            if (entityIds)
+                entityIds[row] = entId;
+            ++row;
         }
     }
+
+    ecsStreamFence();
+    return row;
 }
 
+// remove every sparse component of a destroyed entity
+static void ecsRemoveSparseComponents(EcsInstance* instance, uint entityId)
+{
+    for (uint i = 0; i < instance->SparseContainer.count; ++i)
+    {
+        ecsRemoveSparseComponent(instance, entityId, instance->SparseContainer.ids[i]);
+    }
+}
 
 void ecsDestroyEntity(EcsInstance* instance, uint entityId)
 {
     EcsEntity* entity = ecsGetEntity(instance, entityId);
+    assert(entity->archetypeId != ECS_INVALID_ID && "entity already destroyed");
+    ecsDeltaRecord(instance, ECS_DELTA_DESTROY_ENTITY, 1, &entityId);
+    ++instance->DeltaContainer.depth;
+    ecsRemoveSparseComponents(instance, entityId);
+    --instance->DeltaContainer.depth;
     const EcsArchetypeSignature* signature = ecsGetArchetypeSignature(instance, entity->archetypeId);
     EcsArchetype* archetype = ecsGetArchetype(instance, entity->archetypeId);
     const uint comIdA = entity->componentsId; // componentsId is the index of both the entity and components
@@ -665,19 +1792,1848 @@ void ecsDestroyEntity(EcsInstance* instance, uint entityId)
 
     // move last to removed
     archetype->entityIds[comIdA] = entityIdB;
-    *entity = *ecsGetEntity(instance, entityIdB);
+    ecsGetEntity(instance, entityIdB)->componentsId = comIdA;
+    archetype->disabledCount -= ecsRowEnabled(archetype, comIdA) ^ 1;
+    ecsSetRowEnabled(archetype, comIdA, ecsRowEnabled(archetype, comIdB));
+    ecsSetRowEnabled(archetype, comIdB, 0);
 
     const uint* comIdItr = signature->componentIds;
     EcsComponentArray* componentGroup;
-    size_t comStride;
-    for (; *comIdItr != (uint)-1; ++comIdItr)
+    for (; comIdA != comIdB && *comIdItr != (uint)-1; ++comIdItr)
     {
         componentGroup = &archetype->componentArrays[*comIdItr];
-        comStride = componentGroup->stride;
-        memcpy(&componentGroup->components[comIdA * comStride], &componentGroup->components[comIdB * comStride], comStride);
+        ecsCopyComponent(archetype, componentGroup, comIdA, archetype, componentGroup, comIdB);
     }
+    if (comIdA != comIdB)
+        ecsSnapshotMarkRow(instance, entity->archetypeId, comIdA);
+
+    entity->archetypeId = ECS_INVALID_ID;
+    entity->componentsId = ECS_INVALID_ID;
+}
+
+static int ecsCompareKeys(const void* a, const void* b)
+{
+    uint64_t keyA = *(const uint64_t*)a;
+    uint64_t keyB = *(const uint64_t*)b;
+    return (keyA > keyB) - (keyA < keyB);
+}
+
+// 1 if entityId is in range and not destroyed
+static uint ecsEntityAlive(EcsInstance* instance, uint entityId)
+{
+    return entityId < instance->EntityContainer.count && instance->EntityContainer.entities[entityId].archetypeId != ECS_INVALID_ID;
 }
 
+void ecsDestroyEntities(EcsInstance* instance, uint entityCount, const uint* entityIds)
+{
+    if (entityCount == 0)
+        return;
+
+    // sort removals by archetype then component index - key is archetypeId << 32 | componentsId
+    ecsReserveDestroyCapacity(instance, entityCount);
+    uint64_t* keys = instance->ScratchContainer.keys;
+    uint keyCount = 0;
+    for (uint i = 0; i < entityCount; ++i)
+    {
+        if (ecsEntityAlive(instance, entityIds[i]) == 0)
+            continue;
+        const EcsEntity* entity = &instance->EntityContainer.entities[entityIds[i]];
+        keys[keyCount++] = (uint64_t)entity->archetypeId << 32 | entity->componentsId;
+    }
+    if (keyCount == 0)
+        return;
+
+    // only the entities destroyed are recorded, replicas reject invalid ids
+    if (ecsDeltaRecording(instance))
+    {
+        ecsDeltaRecord(instance, ECS_DELTA_DESTROY_ENTITIES, 1, &keyCount);
+        for (uint i = 0; i < entityCount; ++i)
+        {
+            if (ecsEntityAlive(instance, entityIds[i]))
+                ecsDeltaAppend(instance, 1, entityIds + i);
+        }
+    }
+    qsort(keys, keyCount, sizeof(uint64_t), ecsCompareKeys);
+
+    uint groupBegin = 0;
+    while (groupBegin < keyCount)
+    {
+        const uint archId = (uint)(keys[groupBegin] >> 32);
+
+        // gather group of unique removals from this archetype
+        uint groupEnd = groupBegin;
+        uint removeCount = 0;
+        for (; groupEnd < keyCount && (uint)(keys[groupEnd] >> 32) == archId; ++groupEnd)
+        {
+            if (removeCount && keys[groupEnd] == keys[groupBegin + removeCount - 1])
+                continue; // duplicate entityId
+            keys[groupBegin + removeCount++] = keys[groupEnd];
+        }
+
+        EcsArchetype* archetype = &instance->ArchetypeContainer.archetypes[archId];
+        const EcsArchetypeSignature* signature = &instance->ArchetypeContainer.signatures[archId];
+        uint64_t* rows = keys + groupBegin;
+        const uint oldCount = archetype->entityCount;
+        const uint newCount = oldCount - removeCount;
+
+        // invalidate removed entities before their slots are overwritten
+        for (uint i = 0; i < removeCount; ++i)
+        {
+            const uint removedEntityId = archetype->entityIds[(uint)rows[i]];
+            EcsEntity* entity = &instance->EntityContainer.entities[removedEntityId];
+            archetype->disabledCount -= ecsRowEnabled(archetype, (uint)rows[i]) ^ 1;
+            ++instance->DeltaContainer.depth;
+            ecsRemoveSparseComponents(instance, removedEntityId);
+            --instance->DeltaContainer.depth;
+            entity->archetypeId = ECS_INVALID_ID;
+            entity->componentsId = ECS_INVALID_ID;
+        }
+
+        // build moves, removed slots below newCount are filled by the last remaining entities
+        // rows is reused in place as moves - dst << 32 | src, tail removals above newCount are never overwritten before read
+        uint moveCount = 0;
+        uint tailRemoved = removeCount;
+        uint src = oldCount;
+        for (; moveCount < removeCount && (uint)rows[moveCount] < newCount; ++moveCount)
+        {
+            // next remaining entity from the end
+            --src;
+            while (tailRemoved > moveCount && (uint)rows[tailRemoved - 1] == src)
+            {
+                --tailRemoved;
+                --src;
+            }
+            rows[moveCount] = (uint64_t)(uint)rows[moveCount] << 32 | src;
+        }
 
+        // single pass per component array
+        for (const uint* comIdItr = signature->componentIds; *comIdItr != (uint)-1; ++comIdItr)
+        {
+            EcsComponentArray* componentGroup = &archetype->componentArrays[*comIdItr];
+            for (uint i = 0; i < moveCount; ++i)
+            {
+                ecsCopyComponent(archetype, componentGroup, (uint)(rows[i] >> 32), archetype, componentGroup, (uint)rows[i]);
+            }
+        }
 
+        // relocate moved entities
+        for (uint i = 0; i < moveCount; ++i)
+        {
+            const uint dst = (uint)(rows[i] >> 32);
+            const uint movedEntityId = archetype->entityIds[(uint)rows[i]];
+            archetype->entityIds[dst] = movedEntityId;
+            instance->EntityContainer.entities[movedEntityId].componentsId = dst;
+            ecsSetRowEnabled(archetype, dst, ecsRowEnabled(archetype, (uint)rows[i]));
+            ecsSnapshotMarkRow(instance, archId, dst);
+        }
+        for (uint row = newCount; row < oldCount; ++row)
+            ecsSetRowEnabled(archetype, row, 0);
 
+        archetype->entityCount = newCount;
+        groupBegin = groupEnd;
+    }
+}
+
+uint ecsCompact(EcsInstance* instance, uint archetypeBudget)
+{
+    const uint archCount = instance->ArchetypeContainer.count;
+    if (archCount == 0)
+        return 0;
+
+    uint visitCount = (archetypeBudget == 0 || archetypeBudget > archCount) ? archCount : archetypeBudget;
+    uint archId = instance->ArchetypeContainer.compactIndex;
+    uint compactedCount = 0;
+
+    for (; visitCount; --visitCount, ++archId)
+    {
+        if (archId >= archCount)
+            archId = 0;
+
+        EcsArchetype* archetype = instance->ArchetypeContainer.archetypes + archId;
+        const EcsArchetypeSignature* signature = instance->ArchetypeContainer.signatures + archId;
+        const uint entityCount = archetype->entityCount;
+        const uint entityCapacity = archetype->entityCapacity;
+
+        // already freed
+        if (entityCapacity == 0)
+            continue;
+
+        // free storage, stop visiting in queries
+        if (entityCount == 0)
+        {
+            ecsRemoveArchetypeFromQueries(instance, archetype);
+            ecsFreeArchetype(instance, archetype, signature);
+            ++compactedCount;
+            continue;
+        }
+
+        if ((uint64_t)entityCount * 100 >= (uint64_t)entityCapacity * ECS_COMPACT_SHRINK_LOAD)
+            continue;
+
+        // shrink to target load, keeping space at end for one empty (used for temp swap data)
+        uint64_t targetCapacity = ((uint64_t)entityCount + 2) * 100 / ECS_COMPACT_TARGET_LOAD;
+        uint newCapacity = ECS_COMPACT_MIN_ARCHETYPE_ENTITY_CAPACITY;
+        while (newCapacity < targetCapacity)
+            newCapacity <<= 1;
+
+        if (newCapacity < entityCapacity)
+        {
+            ecsRealtimeAllocation(instance);
+            ecsResizeArchetype(instance, archetype, signature, newCapacity);
+            ++compactedCount;
+        }
+    }
+
+    instance->ArchetypeContainer.compactIndex = archId >= archCount ? 0 : archId;
+    return compactedCount;
+}
+
+void ecsEnableIncrementalGrowth(EcsInstance* instance, size_t stepBytes)
+{
+    instance->GrowthContainer.stepBytes = stepBytes;
+    if (stepBytes == 0)
+        ecsFinishGrowth(instance);
+}
+
+uint ecsStepIncrementalGrowth(EcsInstance* instance)
+{
+    struct GrowthContainer_T* growth = &instance->GrowthContainer;
+    size_t budget = growth->stepBytes;
+    for (uint archId = 0; archId < instance->ArchetypeContainer.count && growth->migratingCount; ++archId)
+    {
+        EcsArchetype* archetype = instance->ArchetypeContainer.archetypes + archId;
+        const EcsArchetypeSignature* signature = instance->ArchetypeContainer.signatures + archId;
+        if (archetype->migrateEnd == 0)
+            continue;
+
+        // whole AoSoA blocks, at least one per call so that growth always finishes
+        const size_t blockSize = ecsArchetypeRowSize(archetype, signature) * ECS_AOSOA_LANES;
+        size_t blockCount = budget / blockSize;
+        if (blockCount == 0)
+        {
+            if (budget != growth->stepBytes)
+                break;
+            blockCount = 1;
+        }
+        const uint remaining = (archetype->migrateEnd - archetype->migrateBegin) / ECS_AOSOA_LANES;
+        if (blockCount > remaining)
+            blockCount = remaining;
+        ecsMigrateArchetypeRows(instance, archetype, signature, archetype->migrateBegin + (uint)blockCount * ECS_AOSOA_LANES);
+
+        const size_t moved = blockCount * blockSize;
+        budget = moved < budget ? budget - moved : 0;
+        if (budget == 0)
+            break;
+    }
+    return growth->migratingCount;
+}
+
+void ecsEnableSnapshot(EcsInstance* instance, uint componentId)
+{
+    assert(componentId < ECS_MAX_COMPONENT_TYPES);
+    assert(instance->SparseContainer.components[componentId] == 0 && "sparse components can not be snapshotted");
+    if (instance->SnapshotContainer.components[componentId])
+        return;
+    instance->SnapshotContainer.components[componentId] = 1;
+
+    for (uint archId = 0; archId < instance->ArchetypeContainer.count; ++archId)
+    {
+        const EcsArchetypeSignature* signature = instance->ArchetypeContainer.signatures + archId;
+        for (const uint* sigIdItr = signature->componentIds; *sigIdItr != (uint)-1; ++sigIdItr)
+        {
+            if (*sigIdItr == componentId)
+            {
+                ecsCreateSnapshotTracker(instance, archId, componentId);
+                break;
+            }
+        }
+    }
+}
+
+void ecsMarkSnapshotWritten(EcsInstance* instance, uint entityId, uint componentId)
+{
+    const EcsEntity* entity = &instance->EntityContainer.entities[entityId];
+    const EcsArchetype* archetype = &instance->ArchetypeContainer.archetypes[entity->archetypeId];
+    uint snapshotId = archetype->componentArrays[componentId].snapshotId;
+    if (snapshotId != ECS_INVALID_ID)
+        ecsSnapshotMarkChunk(instance, snapshotId, entity->componentsId);
+}
+
+void ecsMarkSnapshotArchetypeWritten(EcsInstance* instance, uint archetypeId, uint componentId)
+{
+    const EcsArchetype* archetype = &instance->ArchetypeContainer.archetypes[archetypeId];
+    uint snapshotId = archetype->componentArrays[componentId].snapshotId;
+    if (snapshotId == ECS_INVALID_ID)
+        return;
+    for (uint row = 0; row < archetype->entityCount; row += ECS_SNAPSHOT_CHUNK_ENTITIES)
+    {
+        ecsSnapshotMarkChunk(instance, snapshotId, row);
+    }
+}
+
+uint ecsPublishSnapshot(EcsInstance* instance)
+{
+    struct SnapshotContainer_T* snap = &instance->SnapshotContainer;
+
+    // readers only acquire the front frame, the back frame is free once its last reader released it
+    const uint back = 1 - catomicLoad32(&snap->front);
+    if (catomicLoad32(&snap->readers[back]) != 0)
+        return 0;
+
+    EcsSnapshotFrame* frame = &snap->frames[back];
+    const byte frameBit = (byte)(1u << back);
+
+    // columns tracked since this frame was last published
+    if (frame->columnCapacity < snap->count)
+    {
+        ecsRealtimeAllocation(instance);
+        frame->columns = (EcsSnapshotColumn*)ecsRealloc(instance, frame->columns, sizeof(EcsSnapshotColumn) * frame->columnCapacity, sizeof(EcsSnapshotColumn) * snap->capacity);
+        frame->columnCapacity = snap->capacity;
+    }
+    for (; frame->columnCount < snap->count; ++frame->columnCount)
+    {
+        EcsSnapshotColumn* column = &frame->columns[frame->columnCount];
+        memset(column, 0, sizeof(EcsSnapshotColumn));
+        column->archetypeId = snap->trackers[frame->columnCount].archetypeId;
+        column->componentId = snap->trackers[frame->columnCount].componentId;
+    }
+
+    for (uint i = 0; i < snap->count; ++i)
+    {
+        EcsSnapshotTracker* tracker = &snap->trackers[i];
+        EcsSnapshotColumn* column = &frame->columns[i];
+        const EcsArchetype* archetype = &instance->ArchetypeContainer.archetypes[tracker->archetypeId];
+        const EcsComponentArray* componentArray = &archetype->componentArrays[tracker->componentId];
+        const uint entityCount = archetype->entityCount;
+
+        column->stride = componentArray->stride;
+        column->fieldSize = componentArray->fieldSize;
+        if (column->entityCapacity < entityCount)
+        {
+            const uint newCapacity = archetype->entityCapacity;
+            ecsRealtimeAllocation(instance);
+            column->components = (byte*)ecsRealloc(instance, column->components, column->stride * column->entityCapacity, column->stride * newCapacity);
+            column->entityIds = (uint*)ecsRealloc(instance, column->entityIds, sizeof(uint) * column->entityCapacity, sizeof(uint) * newCapacity);
+            column->entityCapacity = newCapacity;
+        }
+
+        // copy changed chunks only, chunks start on AoSoA block boundaries
+        for (uint chunk = 0, row = 0; row < entityCount && chunk < tracker->chunkCapacity; ++chunk, row += ECS_SNAPSHOT_CHUNK_ENTITIES)
+        {
+            if ((tracker->chunks[chunk] & frameBit) == 0)
+                continue;
+            tracker->chunks[chunk] &= (byte)~frameBit;
+
+            const uint rowEnd = row + ECS_SNAPSHOT_CHUNK_ENTITIES < entityCount ? row + ECS_SNAPSHOT_CHUNK_ENTITIES : entityCount;
+            for (uint regionBegin = row, regionEnd; regionBegin < rowEnd; regionBegin = regionEnd)
+            {
+                const byte* components = ecsColumnRegion(archetype, componentArray, regionBegin, &regionEnd);
+                if (regionEnd > rowEnd)
+                    regionEnd = rowEnd;
+                const size_t begin = componentArray->stride * regionBegin;
+                memcpy(column->components + begin, components + begin, ecsComponentArraySize(componentArray, regionEnd) - begin);
+            }
+            memcpy(column->entityIds + row, archetype->entityIds + row, sizeof(uint) * (rowEnd - row));
+        }
+        column->entityCount = entityCount;
+    }
+
+    frame->frame = ++snap->frame;
+    catomicStore32(&snap->front, back);
+    return 1;
+}
+
+const EcsSnapshotFrame* ecsAcquireSnapshot(EcsInstance* instance, uint* frameIndex)
+{
+    struct SnapshotContainer_T* snap = &instance->SnapshotContainer;
+    uint front;
+    for (;;)
+    {
+        front = catomicLoad32(&snap->front);
+        catomicFetchAdd32(&snap->readers[front], 1);
+        // the writer may have started publishing to this frame after it was loaded, retry on the new front
+        if (catomicLoad32(&snap->front) == front)
+            break;
+        catomicFetchAdd32(&snap->readers[front], (uint)-1);
+    }
+    *frameIndex = front;
+    return &snap->frames[front];
+}
+
+void ecsReleaseSnapshot(EcsInstance* instance, uint frameIndex)
+{
+    catomicFetchAdd32(&instance->SnapshotContainer.readers[frameIndex], (uint)-1);
+}
+
+//=======================================================================
+// Systems
+// - dependency graph rebuilt per ecsRunSystems from read/write conflicts, as bit masks of dependent systems
+// - ready systems are pushed to a lock-free queue, each system is pushed exactly once per run
+// - worker threads sleep between runs and spin while a run is in progress
+
+#if ECS_MAX_SYSTEMS > 64
+#error "ECS_MAX_SYSTEMS must be 64 or less, dependencies are 64 bit masks"
+#endif
+
+typedef struct EcsScheduler
+{
+    EcsInstance* instance;
+    uint threadCount;
+    EcsThread threads[ECS_MAX_SYSTEM_THREADS];
+
+    EcsMutex mutex;
+    EcsCondition wake;
+    EcsCondition finished; // broadcast when the last worker finishes a run
+    uint generation; // incremented per run, guarded by mutex
+    uint quit;
+
+    // per run state
+    uint systemCount;
+    uint64_t dependents[ECS_MAX_SYSTEMS];
+    volatile uint pending[ECS_MAX_SYSTEMS]; // unfinished dependencies per system
+    volatile uint ready[ECS_MAX_SYSTEMS]; // queue of system ids, ECS_INVALID_ID until pushed
+    volatile uint readyHead;
+    volatile uint readyTail;
+    volatile uint completed;
+    uint finishedWorkers; // guarded by mutex
+} EcsScheduler;
+
+static uint64_t ecsTimeNs(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER counter, frequency;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    return (uint64_t)((double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static void ecsSchedulerPush(EcsScheduler* scheduler, uint systemId)
+{
+    uint index = catomicFetchAdd32(&scheduler->readyTail, 1);
+    catomicStore32(&scheduler->ready[index], systemId);
+}
+
+// run ready systems until every system of the run has completed
+static void ecsSchedulerWork(EcsScheduler* scheduler)
+{
+    EcsInstance* instance = scheduler->instance;
+    while (catomicLoad32(&scheduler->completed) != scheduler->systemCount)
+    {
+        uint head = catomicLoad32(&scheduler->readyHead);
+        uint systemId = head < scheduler->systemCount ? catomicLoad32(&scheduler->ready[head]) : ECS_INVALID_ID;
+        if (systemId == ECS_INVALID_ID)
+        {
+            // nothing ready, or a push is reserved but not yet written
+            ecsThreadYield();
+            continue;
+        }
+        if (catomicCompareExchange32(&scheduler->readyHead, head, head + 1) == 0)
+            continue;
+
+        EcsSystem* system = &instance->SystemContainer.systems[systemId];
+        uint64_t begin = ecsTimeNs();
+        system->callback(instance, system->queryId, system->userData);
+        system->timeNs = ecsTimeNs() - begin;
+
+        // release dependents, the last finished dependency pushes
+        uint64_t dependents = scheduler->dependents[systemId];
+        for (uint j = systemId + 1; j < ECS_MAX_SYSTEMS && (dependents >> j); ++j)
+        {
+            if ((dependents >> j & 1) && catomicFetchAdd32(&scheduler->pending[j], (uint)-1) == 1)
+                ecsSchedulerPush(scheduler, j);
+        }
+        catomicFetchAdd32(&scheduler->completed, 1);
+    }
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI ecsSchedulerThread(LPVOID arg)
+#else
+static void* ecsSchedulerThread(void* arg)
+#endif
+{
+    EcsScheduler* scheduler = (EcsScheduler*)arg;
+    uint seenGeneration = 0;
+    for (;;)
+    {
+        ecsMutexLock(&scheduler->mutex);
+        while (scheduler->quit == 0 && scheduler->generation == seenGeneration)
+            ecsConditionWait(&scheduler->wake, &scheduler->mutex);
+        uint quit = scheduler->quit;
+        seenGeneration = scheduler->generation;
+        ecsMutexUnlock(&scheduler->mutex);
+        if (quit)
+            break;
+
+        ecsSchedulerWork(scheduler);
+        ecsMutexLock(&scheduler->mutex);
+        if (++scheduler->finishedWorkers == scheduler->threadCount)
+            ecsConditionBroadcast(&scheduler->finished);
+        ecsMutexUnlock(&scheduler->mutex);
+    }
+    return 0;
+}
+
+static uint ecsSystemsConflict(const EcsSystem* a, const EcsSystem* b)
+{
+    uint64_t conflict = 0;
+    for (uint w = 0; w < ECS_COMPONENT_MASK_WORDS; ++w)
+    {
+        conflict |= a->writes[w] & (b->reads[w] | b->writes[w]);
+        conflict |= a->reads[w] & b->writes[w];
+    }
+    return conflict != 0;
+}
+
+uint ecsCreateSystem(EcsInstance* instance, uint queryId, EcsSystemCallback callback, void* userData,
+    uint readCount, const uint* readIds, uint writeCount, const uint* writeIds)
+{
+    if (instance->SystemContainer.systems == NULL)
+    {
+        instance->SystemContainer.systems = (EcsSystem*)ecsAlloc(instance, sizeof(EcsSystem) * ECS_MAX_SYSTEMS);
+        instance->SystemContainer.capacity = ECS_MAX_SYSTEMS;
+    }
+    assert(instance->SystemContainer.count < instance->SystemContainer.capacity && "system count exceeds ECS_MAX_SYSTEMS");
+
+    uint systemId = instance->SystemContainer.count++;
+    EcsSystem* system = &instance->SystemContainer.systems[systemId];
+    memset(system, 0, sizeof(EcsSystem));
+    system->callback = callback;
+    system->userData = userData;
+    system->queryId = queryId;
+
+    const EcsQuery* query = ecsGetQuery(instance, queryId);
+    for (uint i = 0; i < query->componentCount; ++i)
+        system->reads[query->componentIds[i] / 64] |= 1ull << (query->componentIds[i] % 64);
+    for (uint i = 0; i < readCount; ++i)
+        system->reads[readIds[i] / 64] |= 1ull << (readIds[i] % 64);
+    for (uint i = 0; i < writeCount; ++i)
+        system->writes[writeIds[i] / 64] |= 1ull << (writeIds[i] % 64);
+
+    return systemId;
+}
+
+uint ecsCreateSystemThreads(EcsInstance* instance, uint threadCount)
+{
+    assert(instance->SystemContainer.scheduler == NULL && "system threads already created");
+    assert(threadCount <= ECS_MAX_SYSTEM_THREADS);
+
+    EcsScheduler* scheduler = (EcsScheduler*)ecsAlloc(instance, sizeof(EcsScheduler));
+    assert(scheduler);
+    memset(scheduler, 0, sizeof(EcsScheduler));
+    scheduler->instance = instance;
+    ecsMutexInit(&scheduler->mutex);
+    ecsConditionInit(&scheduler->wake);
+    ecsConditionInit(&scheduler->finished);
+    instance->SystemContainer.scheduler = scheduler;
+
+    // threads that fail to start are left out, runs wait only for the started ones
+    uint startedCount = 0;
+    for (uint i = 0; i < threadCount; ++i)
+    {
+#if defined(_WIN32)
+        scheduler->threads[startedCount] = CreateThread(NULL, 0, ecsSchedulerThread, scheduler, 0, NULL);
+        startedCount += scheduler->threads[startedCount] != NULL;
+#else
+        startedCount += pthread_create(&scheduler->threads[startedCount], NULL, ecsSchedulerThread, scheduler) == 0;
+#endif
+    }
+    ecsMutexLock(&scheduler->mutex);
+    scheduler->threadCount = startedCount;
+    ecsMutexUnlock(&scheduler->mutex);
+    return startedCount;
+}
+
+void ecsDestroySystemThreads(EcsInstance* instance)
+{
+    EcsScheduler* scheduler = instance->SystemContainer.scheduler;
+    if (scheduler == NULL)
+        return;
+
+    ecsMutexLock(&scheduler->mutex);
+    scheduler->quit = 1;
+    ecsConditionBroadcast(&scheduler->wake);
+    ecsMutexUnlock(&scheduler->mutex);
+
+    for (uint i = 0; i < scheduler->threadCount; ++i)
+    {
+#if defined(_WIN32)
+        WaitForSingleObject(scheduler->threads[i], INFINITE);
+        CloseHandle(scheduler->threads[i]);
+#else
+        pthread_join(scheduler->threads[i], NULL);
+#endif
+    }
+
+    ecsConditionDestroy(&scheduler->finished);
+    ecsConditionDestroy(&scheduler->wake);
+    ecsMutexDestroy(&scheduler->mutex);
+    ecsFree(instance, scheduler, sizeof(EcsScheduler));
+    instance->SystemContainer.scheduler = NULL;
+}
+
+void ecsRunSystems(EcsInstance* instance)
+{
+    const uint systemCount = instance->SystemContainer.count;
+    if (systemCount == 0)
+        return;
+
+    // without threads, run state lives on the stack
+    EcsScheduler local;
+    EcsScheduler* scheduler = instance->SystemContainer.scheduler;
+    if (scheduler == NULL)
+    {
+        scheduler = &local;
+        scheduler->instance = instance;
+        scheduler->threadCount = 0;
+    }
+
+    // build dependency graph - later systems depend on earlier conflicting systems
+    const EcsSystem* systems = instance->SystemContainer.systems;
+    scheduler->systemCount = systemCount;
+    scheduler->readyHead = 0;
+    scheduler->readyTail = 0;
+    scheduler->completed = 0;
+    scheduler->finishedWorkers = 0;
+    for (uint j = 0; j < systemCount; ++j)
+    {
+        scheduler->dependents[j] = 0;
+        scheduler->pending[j] = 0;
+        scheduler->ready[j] = ECS_INVALID_ID;
+        for (uint i = 0; i < j; ++i)
+        {
+            if (ecsSystemsConflict(&systems[i], &systems[j]))
+            {
+                scheduler->dependents[i] |= 1ull << j;
+                ++scheduler->pending[j];
+            }
+        }
+    }
+    for (uint j = 0; j < systemCount; ++j)
+    {
+        if (scheduler->pending[j] == 0)
+            ecsSchedulerPush(scheduler, j);
+    }
+
+    if (scheduler->threadCount)
+    {
+        ecsMutexLock(&scheduler->mutex);
+        ++scheduler->generation;
+        ecsConditionBroadcast(&scheduler->wake);
+        ecsMutexUnlock(&scheduler->mutex);
+    }
+
+    ecsSchedulerWork(scheduler);
+
+    // workers must be out of the run state before the next run rebuilds it
+    if (scheduler->threadCount)
+    {
+        ecsMutexLock(&scheduler->mutex);
+        while (scheduler->finishedWorkers != scheduler->threadCount)
+            ecsConditionWait(&scheduler->finished, &scheduler->mutex);
+        ecsMutexUnlock(&scheduler->mutex);
+    }
+}
+
+uint64_t ecsGetSystemTime(EcsInstance* instance, uint systemId)
+{
+    return instance->SystemContainer.systems[systemId].timeNs;
+}
+
+//=======================================================================
+// Sparse components
+
+void ecsCreateSparseComponent(EcsInstance* instance, uint componentId, size_t sizeofComponent)
+{
+    assert(componentId < ECS_MAX_COMPONENT_TYPES);
+    assert(instance->SnapshotContainer.components[componentId] == 0 && "sparse components can not be snapshotted");
+    struct SparseContainer_T* sparse = &instance->SparseContainer;
+    if (sparse->components[componentId])
+        return;
+
+#if !defined(NDEBUG)
+    for (uint archId = 0; archId < instance->ArchetypeContainer.count; ++archId)
+    {
+        assert(instance->ArchetypeContainer.archetypes[archId].componentArrays[componentId].stride == 0 && "register sparse components before creating archetypes with them");
+    }
+#endif
+
+    if (sparse->sets == NULL)
+    {
+        ecsRealtimeAllocation(instance);
+        sparse->sets = (EcsSparseSet*)ecsAlloc(instance, sizeof(EcsSparseSet) * ECS_MAX_COMPONENT_TYPES);
+        assert(sparse->sets);
+        memset(sparse->sets, 0, sizeof(EcsSparseSet) * ECS_MAX_COMPONENT_TYPES);
+    }
+
+    EcsSparseSet* set = &sparse->sets[componentId];
+    memset(set, 0, sizeof(EcsSparseSet));
+    set->stride = sizeofComponent;
+    sparse->components[componentId] = 1;
+    sparse->ids[sparse->count++] = componentId;
+
+    if (instance->ProfileContainer.sparsePeaks[componentId])
+        ecsReserveSparseCapacity(instance, componentId, instance->ProfileContainer.sparsePeaks[componentId]);
+}
+
+// grow the sparse index to cover entityId, or all entities the instance has capacity for
+static void ecsGrowSparseIndex(EcsInstance* instance, EcsSparseSet* set, uint entityId)
+{
+    uint newCapacity = instance->EntityContainer.capacity;
+    if (newCapacity <= entityId)
+        newCapacity = entityId + 1;
+    const uint oldCapacity = set->sparseCapacity;
+    if (newCapacity <= oldCapacity)
+        return;
+
+    ecsRealtimeAllocation(instance);
+    set->sparse = (uint*)ecsRealloc(instance, set->sparse, sizeof(uint) * oldCapacity, sizeof(uint) * newCapacity);
+    assert(set->sparse);
+    memset(set->sparse + oldCapacity, 0xFF, sizeof(uint) * (newCapacity - oldCapacity));
+    set->sparseCapacity = newCapacity;
+}
+
+void* ecsAddSparseComponent(EcsInstance* instance, uint entityId, uint componentId)
+{
+    assert(instance->SparseContainer.components[componentId] && "component is not sparse stored - see ecsCreateSparseComponent");
+    assert(instance->EntityContainer.entities[entityId].archetypeId != ECS_INVALID_ID && "entity destroyed");
+    EcsSparseSet* set = &instance->SparseContainer.sets[componentId];
+
+    if (entityId >= set->sparseCapacity)
+        ecsGrowSparseIndex(instance, set, entityId);
+
+    uint index = set->sparse[entityId];
+    if (index != ECS_INVALID_ID)
+        return &set->components[set->stride * index];
+
+    if (set->count == set->capacity)
+        ecsReserveSparseCapacity(instance, componentId, set->capacity ? set->capacity * 2 : ECS_DEFAULT_SPARSE_COMPONENT_CAPACITY);
+
+    const uint event[2] = { entityId, componentId };
+    ecsDeltaRecord(instance, ECS_DELTA_ADD_SPARSE_COMPONENT, 2, event);
+    index = set->count++;
+    set->peakCount = set->count > set->peakCount ? set->count : set->peakCount;
+    set->sparse[entityId] = index;
+    set->entityIds[index] = entityId;
+    byte* component = &set->components[set->stride * index];
+    memset(component, 0, set->stride);
+    return component;
+}
+
+void ecsRemoveSparseComponent(EcsInstance* instance, uint entityId, uint componentId)
+{
+    assert(instance->SparseContainer.components[componentId] && "component is not sparse stored - see ecsCreateSparseComponent");
+    EcsSparseSet* set = &instance->SparseContainer.sets[componentId];
+    if (entityId >= set->sparseCapacity || set->sparse[entityId] == ECS_INVALID_ID)
+        return;
+
+    const uint event[2] = { entityId, componentId };
+    ecsDeltaRecord(instance, ECS_DELTA_REMOVE_SPARSE_COMPONENT, 2, event);
+
+    // move last to removed
+    const uint index = set->sparse[entityId];
+    const uint last = --set->count;
+    if (index != last)
+    {
+        const uint lastEntityId = set->entityIds[last];
+        memcpy(&set->components[set->stride * index], &set->components[set->stride * last], set->stride);
+        set->entityIds[index] = lastEntityId;
+        set->sparse[lastEntityId] = index;
+    }
+    set->sparse[entityId] = ECS_INVALID_ID;
+}
+
+void* ecsGetSparseComponent(EcsInstance* instance, uint entityId, uint componentId)
+{
+    EcsSparseSet* set = &instance->SparseContainer.sets[componentId];
+    if (entityId >= set->sparseCapacity || set->sparse[entityId] == ECS_INVALID_ID)
+        return NULL;
+    return &set->components[set->stride * set->sparse[entityId]];
+}
+
+EcsSparseSet* ecsGetSparseSet(EcsInstance* instance, uint componentId)
+{
+    assert(instance->SparseContainer.components[componentId] && "component is not sparse stored - see ecsCreateSparseComponent");
+    return &instance->SparseContainer.sets[componentId];
+}
+
+//=======================================================================
+// Reserve and real-time mode
+
+void ecsReserveArchetypeCapacity(EcsInstance* instance, uint newCapacity)
+{
+    const uint oldCapacity = instance->ArchetypeContainer.capacity;
+    if (newCapacity <= oldCapacity)
+        return;
+
+    ecsRealtimeAllocation(instance);
+    uintptr_t oldArchetypes = (uintptr_t)instance->ArchetypeContainer.archetypes;
+    instance->ArchetypeContainer.archetypes = (EcsArchetype*)ecsRealloc(instance, instance->ArchetypeContainer.archetypes, sizeof(EcsArchetype) * oldCapacity, sizeof(EcsArchetype) * newCapacity);
+    instance->ArchetypeContainer.signatures = (EcsArchetypeSignature*)ecsRealloc(instance, instance->ArchetypeContainer.signatures, sizeof(EcsArchetypeSignature) * oldCapacity, sizeof(EcsArchetypeSignature) * newCapacity);
+    instance->ArchetypeContainer.capacity = newCapacity;
+    ecsRebaseQueries(instance, oldArchetypes);
+}
+
+void ecsReserveEntityCapacity(EcsInstance* instance, uint newCapacity)
+{
+    const uint oldCapacity = instance->EntityContainer.capacity;
+    if (newCapacity <= oldCapacity)
+        return;
+
+    ecsRealtimeAllocation(instance);
+    instance->EntityContainer.entities = (EcsEntity*)ecsReallocArray(instance, instance->EntityContainer.entities, sizeof(EcsEntity) * oldCapacity, sizeof(EcsEntity) * newCapacity, sizeof(EcsEntity) * oldCapacity);
+    instance->EntityContainer.infos = (EcsEntityInfo*)ecsReallocArray(instance, instance->EntityContainer.infos, sizeof(EcsEntityInfo) * oldCapacity, sizeof(EcsEntityInfo) * newCapacity, sizeof(EcsEntityInfo) * oldCapacity);
+    instance->EntityContainer.capacity = newCapacity;
+}
+
+void ecsReserveQueryCapacity(EcsInstance* instance, uint newCapacity)
+{
+    const uint oldCapacity = instance->QueryContainer.capacity;
+    if (newCapacity <= oldCapacity)
+        return;
+
+    ecsRealtimeAllocation(instance);
+    instance->QueryContainer.queries = (EcsQuery*)ecsRealloc(instance, instance->QueryContainer.queries, sizeof(EcsQuery) * oldCapacity, sizeof(EcsQuery) * newCapacity);
+    instance->QueryContainer.columnTables = (EcsQueryColumnTable*)ecsRealloc(instance, instance->QueryContainer.columnTables, sizeof(EcsQueryColumnTable) * oldCapacity, sizeof(EcsQueryColumnTable) * newCapacity);
+    memset(instance->QueryContainer.columnTables + oldCapacity, 0, sizeof(EcsQueryColumnTable) * (newCapacity - oldCapacity));
+    instance->QueryContainer.capacity = newCapacity;
+}
+
+void ecsReserveArchetypeEntityCapacity(EcsInstance* instance, uint archetypeId, uint newCapacity)
+{
+    EcsArchetype* archetype = instance->ArchetypeContainer.archetypes + archetypeId;
+    const EcsArchetypeSignature* signature = instance->ArchetypeContainer.signatures + archetypeId;
+
+    // growth is triggered with 2 slots left (one empty at end for temp swap data), in whole AoSoA blocks
+    uint capacity = newCapacity + 3;
+    capacity = (capacity + ECS_AOSOA_LANES - 1) / ECS_AOSOA_LANES * ECS_AOSOA_LANES;
+    if (capacity <= archetype->entityCapacity)
+        return;
+
+    const uint bFreed = archetype->entityCapacity == 0;
+    ecsRealtimeAllocation(instance);
+    ecsResizeArchetype(instance, archetype, signature, capacity);
+    if (bFreed)
+        ecsAddArchetypeToQueries(instance, archetypeId);
+}
+
+void ecsReserveDestroyCapacity(EcsInstance* instance, uint newCapacity)
+{
+    const uint oldCapacity = instance->ScratchContainer.capacity;
+    if (newCapacity <= oldCapacity)
+        return;
+
+    // contents are scratch, no copy
+    ecsRealtimeAllocation(instance);
+    ecsFree(instance, instance->ScratchContainer.keys, sizeof(uint64_t) * oldCapacity);
+    instance->ScratchContainer.keys = (uint64_t*)ecsAlloc(instance, sizeof(uint64_t) * newCapacity);
+    assert(instance->ScratchContainer.keys);
+    instance->ScratchContainer.capacity = newCapacity;
+}
+
+void ecsReserveSparseCapacity(EcsInstance* instance, uint componentId, uint newCapacity)
+{
+    assert(instance->SparseContainer.components[componentId] && "component is not sparse stored - see ecsCreateSparseComponent");
+    EcsSparseSet* set = &instance->SparseContainer.sets[componentId];
+    ecsGrowSparseIndex(instance, set, 0);
+
+    const uint oldCapacity = set->capacity;
+    if (newCapacity <= oldCapacity)
+        return;
+
+    ecsRealtimeAllocation(instance);
+    set->components = (byte*)ecsRealloc(instance, set->components, set->stride * oldCapacity, set->stride * newCapacity);
+    set->entityIds = (uint*)ecsRealloc(instance, set->entityIds, sizeof(uint) * oldCapacity, sizeof(uint) * newCapacity);
+    assert(set->components && set->entityIds);
+    set->capacity = newCapacity;
+}
+
+// prefault and lock, or unlock, a region - returns 1 on success
+static uint ecsLockRegion(void* ptr, size_t size, uint bLock)
+{
+    if (ptr == NULL || size == 0)
+        return 1;
+
+    if (bLock == 0)
+    {
+        ecsMemoryUnlock(ptr, size);
+        return 1;
+    }
+
+    // write each page so it is backed by RAM, not the shared zero page
+    const size_t pageSize = ecsPageSize();
+    volatile byte* bytes = (volatile byte*)ptr;
+    for (size_t off = 0; off < size; off += pageSize)
+        bytes[off] = bytes[off];
+
+    return ecsMemoryLock(ptr, size) ? 1 : 0;
+}
+
+// every reserved allocation of the instance
+static uint ecsLockInstance(EcsInstance* instance, uint bLock)
+{
+    ecsFinishGrowth(instance);
+    uint bLocked = 1;
+    bLocked &= ecsLockRegion(instance->EntityContainer.entities, sizeof(EcsEntity) * instance->EntityContainer.capacity, bLock);
+    bLocked &= ecsLockRegion(instance->EntityContainer.infos, sizeof(EcsEntityInfo) * instance->EntityContainer.capacity, bLock);
+    bLocked &= ecsLockRegion(instance->ArchetypeContainer.archetypes, sizeof(EcsArchetype) * instance->ArchetypeContainer.capacity, bLock);
+    bLocked &= ecsLockRegion(instance->ArchetypeContainer.signatures, sizeof(EcsArchetypeSignature) * instance->ArchetypeContainer.capacity, bLock);
+    bLocked &= ecsLockRegion(instance->QueryContainer.queries, sizeof(EcsQuery) * instance->QueryContainer.capacity, bLock);
+    bLocked &= ecsLockRegion(instance->QueryContainer.columnTables, sizeof(EcsQueryColumnTable) * instance->QueryContainer.capacity, bLock);
+    bLocked &= ecsLockRegion(instance->SystemContainer.systems, sizeof(EcsSystem) * instance->SystemContainer.capacity, bLock);
+    bLocked &= ecsLockRegion(instance->ScratchContainer.keys, sizeof(uint64_t) * instance->ScratchContainer.capacity, bLock);
+    bLocked &= ecsLockRegion(instance->SparseContainer.sets, instance->SparseContainer.sets ? sizeof(EcsSparseSet) * ECS_MAX_COMPONENT_TYPES : 0, bLock);
+    for (uint i = 0; i < instance->SparseContainer.count; ++i)
+    {
+        EcsSparseSet* set = &instance->SparseContainer.sets[instance->SparseContainer.ids[i]];
+        bLocked &= ecsLockRegion(set->components, set->stride * set->capacity, bLock);
+        bLocked &= ecsLockRegion(set->entityIds, sizeof(uint) * set->capacity, bLock);
+        bLocked &= ecsLockRegion(set->sparse, sizeof(uint) * set->sparseCapacity, bLock);
+    }
+    for (uint i = 0; i < instance->QueryContainer.count; ++i)
+    {
+        EcsQueryColumnTable* table = &instance->QueryContainer.columnTables[i];
+        bLocked &= ecsLockRegion(table->columns, sizeof(EcsQueryColumns) * table->capacity, bLock);
+    }
+
+    for (uint archId = 0; archId < instance->ArchetypeContainer.count; ++archId)
+    {
+        EcsArchetype* archetype = instance->ArchetypeContainer.archetypes + archId;
+        const EcsArchetypeSignature* signature = instance->ArchetypeContainer.signatures + archId;
+        bLocked &= ecsLockRegion(archetype->entityIds, sizeof(uint) * archetype->entityCapacity, bLock);
+        bLocked &= ecsLockRegion(archetype->enabledMask, ecsEnabledMaskSize(archetype->entityCapacity), bLock);
+        for (const uint* sigIdItr = signature->componentIds; *sigIdItr != (uint)-1; ++sigIdItr)
+        {
+            EcsComponentArray* compArray = &archetype->componentArrays[*sigIdItr];
+            bLocked &= ecsLockRegion(compArray->components, compArray->stride * archetype->entityCapacity, bLock);
+        }
+    }
+
+    struct SnapshotContainer_T* snap = &instance->SnapshotContainer;
+    bLocked &= ecsLockRegion(snap->trackers, sizeof(EcsSnapshotTracker) * snap->capacity, bLock);
+    for (uint i = 0; i < snap->count; ++i)
+        bLocked &= ecsLockRegion(snap->trackers[i].chunks, snap->trackers[i].chunkCapacity, bLock);
+    for (uint f = 0; f < 2; ++f)
+    {
+        EcsSnapshotFrame* frame = &snap->frames[f];
+        bLocked &= ecsLockRegion(frame->columns, sizeof(EcsSnapshotColumn) * frame->columnCapacity, bLock);
+        for (uint i = 0; i < frame->columnCount; ++i)
+        {
+            EcsSnapshotColumn* column = &frame->columns[i];
+            bLocked &= ecsLockRegion(column->components, column->stride * column->entityCapacity, bLock);
+            bLocked &= ecsLockRegion(column->entityIds, sizeof(uint) * column->entityCapacity, bLock);
+        }
+    }
+
+    struct DeltaContainer_T* delta = &instance->DeltaContainer;
+    bLocked &= ecsLockRegion(delta->events, sizeof(uint) * delta->eventCapacity, bLock);
+    bLocked &= ecsLockRegion(delta->buffer, delta->bufferCapacity, bLock);
+    bLocked &= ecsLockRegion(delta->columns, sizeof(EcsDeltaBaseline) * delta->columnCapacity, bLock);
+    for (uint i = 0; i < delta->columnCapacity; ++i)
+        bLocked &= ecsLockRegion(delta->columns[i].data, delta->columns[i].size, bLock);
+    for (uint i = 0; i < ECS_MAX_COMPONENT_TYPES; ++i)
+        bLocked &= ecsLockRegion(delta->sparse[i].data, delta->sparse[i].size, bLock);
+
+    return bLocked;
+}
+
+uint ecsBeginRealtime(EcsInstance* instance)
+{
+    uint bLocked = ecsLockInstance(instance, 1);
+    instance->RealtimeContainer.enabled = 1;
+    instance->RealtimeContainer.allocationCount = 0;
+    return bLocked;
+}
+
+void ecsEndRealtime(EcsInstance* instance)
+{
+    instance->RealtimeContainer.enabled = 0;
+    ecsLockInstance(instance, 0);
+}
+
+uint ecsGetRealtimeAllocationCount(EcsInstance* instance)
+{
+    return instance->RealtimeContainer.allocationCount;
+}
+
+//=======================================================================
+// Save and load
+
+#define ECS_FILE_MAGIC 0x31534345 // "ECS1"
+#define ECS_FILE_VERSION 4
+
+// on-disk layout of ecsSaveInstance, every section starts at an ECS_FILE_ALIGNMENT aligned offset
+// entities and archetype columns are written as in memory up to capacity, rows not in use are zero
+// so that ecsLoadInstance maps them in place. archetypes and queries are written as in memory, pointers replaced with offsets:
+// archetype entityIds, enabledMask and components: file offset, 0 for archetypes freed by ecsCompact
+// archetype migrateColumns: NULL, incremental growth is finished before saving
+// query archetypes: byte offset from the first archetype, see ecsRebaseQueries
+typedef struct EcsFileHeader
+{
+    uint magic;
+    uint version;
+    // configuration the file was saved with, loading requires the same
+    uint sizeofArchetype;
+    uint sizeofQuery;
+    uint maxComponentTypes;
+    uint aosoaLanes;
+
+    uint entityCount;
+    uint entityCapacity;
+    uint archetypeCount;
+    uint queryCount;
+    uint sparseCount;
+    uint unused;
+    uint64_t entitiesOffset; // EcsEntity[entityCapacity]
+    uint64_t infosOffset; // EcsEntityInfo[entityCapacity]
+    uint64_t signaturesOffset; // EcsArchetypeSignature[archetypeCount]
+    uint64_t archetypesOffset; // EcsArchetype[archetypeCount]
+    uint64_t queriesOffset; // EcsQuery[queryCount]
+    uint64_t sparseOffset; // EcsFileSparseSet[sparseCount]
+    uint64_t fileSize;
+} EcsFileHeader;
+
+typedef struct EcsFileSparseSet
+{
+    uint componentId;
+    uint count;
+    uint64_t stride;
+    uint64_t componentsOffset; // components[count]
+    uint64_t entityIdsOffset; // uint[count], the sparse index is rebuilt on load
+} EcsFileSparseSet;
+
+// write a section at the next ECS_FILE_ALIGNMENT aligned offset, zero filled from size to capacitySize, returns the section offset
+static uint64_t ecsFileWrite(FILE* file, uint64_t* fileOffset, const void* data, size_t size, size_t capacitySize, uint* bWritten)
+{
+    static const byte zeros[4096] = { 0 };
+    const uint64_t offset = (*fileOffset + ECS_FILE_ALIGNMENT - 1) / ECS_FILE_ALIGNMENT * ECS_FILE_ALIGNMENT;
+    size_t zerosSize = (size_t)(offset - *fileOffset);
+    if (zerosSize && fwrite(zeros, 1, zerosSize, file) != zerosSize)
+        *bWritten = 0;
+    if (size && fwrite(data, 1, size, file) != size)
+        *bWritten = 0;
+    for (zerosSize = capacitySize > size ? capacitySize - size : 0; zerosSize; )
+    {
+        const size_t writeSize = zerosSize < sizeof(zeros) ? zerosSize : sizeof(zeros);
+        if (fwrite(zeros, 1, writeSize, file) != writeSize)
+            *bWritten = 0;
+        zerosSize -= writeSize;
+    }
+    *fileOffset = offset + (capacitySize > size ? capacitySize : size);
+    return offset;
+}
+
+uint ecsSaveInstance(EcsInstance* instance, const char* path)
+{
+    ecsFinishGrowth(instance);
+    FILE* file = fopen(path, "wb");
+    if (file == NULL)
+        return 0;
+
+    EcsFileHeader header;
+    memset(&header, 0, sizeof(EcsFileHeader));
+    header.magic = ECS_FILE_MAGIC;
+    header.version = ECS_FILE_VERSION;
+    header.sizeofArchetype = sizeof(EcsArchetype);
+    header.sizeofQuery = sizeof(EcsQuery);
+    header.maxComponentTypes = ECS_MAX_COMPONENT_TYPES;
+    header.aosoaLanes = ECS_AOSOA_LANES;
+    header.entityCount = instance->EntityContainer.count;
+    header.entityCapacity = instance->EntityContainer.capacity;
+    header.archetypeCount = instance->ArchetypeContainer.count;
+    header.queryCount = instance->QueryContainer.count;
+    header.sparseCount = instance->SparseContainer.count;
+
+    uint bWritten = 1;
+    uint64_t fileOffset = 0;
+    ecsFileWrite(file, &fileOffset, &header, sizeof(EcsFileHeader), 0, &bWritten); // rewritten with offsets at end
+
+    header.entitiesOffset = ecsFileWrite(file, &fileOffset, instance->EntityContainer.entities, sizeof(EcsEntity) * header.entityCount, sizeof(EcsEntity) * header.entityCapacity, &bWritten);
+    header.infosOffset = ecsFileWrite(file, &fileOffset, instance->EntityContainer.infos, sizeof(EcsEntityInfo) * header.entityCount, sizeof(EcsEntityInfo) * header.entityCapacity, &bWritten);
+    header.signaturesOffset = ecsFileWrite(file, &fileOffset, instance->ArchetypeContainer.signatures, sizeof(EcsArchetypeSignature) * header.archetypeCount, 0, &bWritten);
+
+    // columns, rows in use and zeros to capacity - whole blocks for AoSoA arrays
+    EcsArchetype* fileArchetypes = NULL;
+    if (header.archetypeCount)
+    {
+        fileArchetypes = (EcsArchetype*)ecsAlloc(instance, sizeof(EcsArchetype) * header.archetypeCount);
+        assert(fileArchetypes);
+        memcpy(fileArchetypes, instance->ArchetypeContainer.archetypes, sizeof(EcsArchetype) * header.archetypeCount);
+    }
+    for (uint archId = 0; archId < header.archetypeCount; ++archId)
+    {
+        EcsArchetype* archetype = fileArchetypes + archId;
+        const EcsArchetypeSignature* signature = instance->ArchetypeContainer.signatures + archId;
+        if (archetype->entityCapacity == 0)
+            continue;
+
+        archetype->entityIds = (uint*)(uintptr_t)ecsFileWrite(file, &fileOffset, archetype->entityIds, sizeof(uint) * archetype->entityCount, sizeof(uint) * archetype->entityCapacity, &bWritten);
+        archetype->enabledMask = (uint64_t*)(uintptr_t)ecsFileWrite(file, &fileOffset, archetype->enabledMask, ecsEnabledMaskSize(archetype->entityCount), ecsEnabledMaskSize(archetype->entityCapacity), &bWritten);
+        for (const uint* sigIdItr = signature->componentIds; *sigIdItr != (uint)-1; ++sigIdItr)
+        {
+            EcsComponentArray* compArray = &archetype->componentArrays[*sigIdItr];
+            uint64_t offset = ecsFileWrite(file, &fileOffset, compArray->components, ecsComponentArraySize(compArray, archetype->entityCount), compArray->stride * archetype->entityCapacity, &bWritten);
+            compArray->components = (byte*)(uintptr_t)offset;
+            compArray->snapshotId = ECS_INVALID_ID;
+        }
+    }
+    header.archetypesOffset = ecsFileWrite(file, &fileOffset, fileArchetypes, sizeof(EcsArchetype) * header.archetypeCount, 0, &bWritten);
+    ecsFree(instance, fileArchetypes, sizeof(EcsArchetype) * header.archetypeCount);
+
+    // query archetypes relative to the first archetype, written as one packed EcsQuery[queryCount] section
+    const uintptr_t archetypesBase = (uintptr_t)instance->ArchetypeContainer.archetypes;
+    EcsQuery* fileQueries = NULL;
+    if (header.queryCount)
+    {
+        fileQueries = (EcsQuery*)ecsAlloc(instance, sizeof(EcsQuery) * header.queryCount);
+        assert(fileQueries);
+        memcpy(fileQueries, instance->QueryContainer.queries, sizeof(EcsQuery) * header.queryCount);
+    }
+    for (uint queryId = 0; queryId < header.queryCount; ++queryId)
+    {
+        EcsQuery* query = fileQueries + queryId;
+        for (uint archIdx = 0; archIdx < query->archetypeCount; ++archIdx)
+        {
+            query->archetypes[archIdx] = (EcsArchetype*)((uintptr_t)query->archetypes[archIdx] - archetypesBase);
+        }
+    }
+    header.queriesOffset = ecsFileWrite(file, &fileOffset, fileQueries, sizeof(EcsQuery) * header.queryCount, 0, &bWritten);
+    ecsFree(instance, fileQueries, sizeof(EcsQuery) * header.queryCount);
+
+    EcsFileSparseSet fileSets[ECS_MAX_COMPONENT_TYPES];
+    for (uint i = 0; i < header.sparseCount; ++i)
+    {
+        const EcsSparseSet* set = &instance->SparseContainer.sets[instance->SparseContainer.ids[i]];
+        fileSets[i].componentId = instance->SparseContainer.ids[i];
+        fileSets[i].count = set->count;
+        fileSets[i].stride = set->stride;
+        fileSets[i].componentsOffset = ecsFileWrite(file, &fileOffset, set->components, set->stride * set->count, 0, &bWritten);
+        fileSets[i].entityIdsOffset = ecsFileWrite(file, &fileOffset, set->entityIds, sizeof(uint) * set->count, 0, &bWritten);
+    }
+    header.sparseOffset = ecsFileWrite(file, &fileOffset, fileSets, sizeof(EcsFileSparseSet) * header.sparseCount, 0, &bWritten);
+
+    header.fileSize = fileOffset;
+    if (fseek(file, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(EcsFileHeader), 1, file) != 1)
+        bWritten = 0;
+    if (fclose(file) != 0)
+        bWritten = 0;
+    return bWritten;
+}
+
+// 1 if a section is inside the file
+static inline uint ecsFileHasSection(const EcsFileHeader* header, uint64_t offset, uint64_t size)
+{
+    return size == 0 || (offset >= sizeof(EcsFileHeader) && offset <= header->fileSize && size <= header->fileSize - offset);
+}
+
+// validate every section before the instance is modified
+static uint ecsFileIsValid(const byte* data, size_t fileSize)
+{
+    if (fileSize < sizeof(EcsFileHeader))
+        return 0;
+
+    const EcsFileHeader* header = (const EcsFileHeader*)data;
+    if (header->magic != ECS_FILE_MAGIC || header->version != ECS_FILE_VERSION || header->fileSize != fileSize ||
+        header->sizeofArchetype != sizeof(EcsArchetype) || header->sizeofQuery != sizeof(EcsQuery) ||
+        header->maxComponentTypes != ECS_MAX_COMPONENT_TYPES || header->aosoaLanes != ECS_AOSOA_LANES ||
+        header->entityCount > header->entityCapacity || header->entityCapacity == 0 || header->sparseCount > ECS_MAX_COMPONENT_TYPES)
+        return 0;
+
+    if (!ecsFileHasSection(header, header->entitiesOffset, sizeof(EcsEntity) * (uint64_t)header->entityCapacity) ||
+        !ecsFileHasSection(header, header->infosOffset, sizeof(EcsEntityInfo) * (uint64_t)header->entityCapacity) ||
+        !ecsFileHasSection(header, header->signaturesOffset, sizeof(EcsArchetypeSignature) * (uint64_t)header->archetypeCount) ||
+        !ecsFileHasSection(header, header->archetypesOffset, sizeof(EcsArchetype) * (uint64_t)header->archetypeCount) ||
+        !ecsFileHasSection(header, header->queriesOffset, sizeof(EcsQuery) * (uint64_t)header->queryCount) ||
+        !ecsFileHasSection(header, header->sparseOffset, sizeof(EcsFileSparseSet) * (uint64_t)header->sparseCount))
+        return 0;
+
+    const EcsArchetypeSignature* signatures = (const EcsArchetypeSignature*)(data + header->signaturesOffset);
+    const EcsArchetype* archetypes = (const EcsArchetype*)(data + header->archetypesOffset);
+    for (uint archId = 0; archId < header->archetypeCount; ++archId)
+    {
+        const EcsArchetype* archetype = archetypes + archId;
+        if (archetype->entityCapacity == 0)
+            continue;
+        if (archetype->entityCount >= archetype->entityCapacity || archetype->entityCapacity % ECS_AOSOA_LANES != 0 ||
+            archetype->disabledCount > archetype->entityCount ||
+            !ecsFileHasSection(header, (uintptr_t)archetype->entityIds, sizeof(uint) * (uint64_t)archetype->entityCapacity) ||
+            !ecsFileHasSection(header, (uintptr_t)archetype->enabledMask, ecsEnabledMaskSize(archetype->entityCapacity)))
+            return 0;
+
+        const uint* sigIdItr = signatures[archId].componentIds;
+        for (uint i = 0; i <= ECS_MAX_COMPONENT_TYPES && *sigIdItr != (uint)-1; ++i, ++sigIdItr)
+        {
+            if (*sigIdItr >= ECS_MAX_COMPONENT_TYPES || i == ECS_MAX_COMPONENT_TYPES)
+                return 0;
+            const EcsComponentArray* compArray = &archetype->componentArrays[*sigIdItr];
+            if (!ecsFileHasSection(header, (uintptr_t)compArray->components, compArray->stride * archetype->entityCapacity))
+                return 0;
+        }
+    }
+
+    const EcsQuery* queries = (const EcsQuery*)(data + header->queriesOffset);
+    for (uint queryId = 0; queryId < header->queryCount; ++queryId)
+    {
+        const EcsQuery* query = queries + queryId;
+        // a query read at the wrong stride shows up as zero padding or stray ids
+        if (query->archetypeCount > ECS_MAX_QUERY_ARCHETYPES || query->componentCount == 0 || query->componentCount > ECS_MAX_QUERY_COMPONENTS)
+            return 0;
+        for (uint i = 0; i < query->componentCount; ++i)
+        {
+            if (query->componentIds[i] >= ECS_MAX_COMPONENT_TYPES)
+                return 0;
+        }
+        for (uint archIdx = 0; archIdx < query->archetypeCount; ++archIdx)
+        {
+            const uintptr_t offset = (uintptr_t)query->archetypes[archIdx];
+            if (offset % sizeof(EcsArchetype) != 0 || offset / sizeof(EcsArchetype) >= header->archetypeCount)
+                return 0;
+        }
+    }
+
+    const EcsFileSparseSet* fileSets = (const EcsFileSparseSet*)(data + header->sparseOffset);
+    for (uint i = 0; i < header->sparseCount; ++i)
+    {
+        if (fileSets[i].componentId >= ECS_MAX_COMPONENT_TYPES ||
+            !ecsFileHasSection(header, fileSets[i].componentsOffset, fileSets[i].stride * fileSets[i].count) ||
+            !ecsFileHasSection(header, fileSets[i].entityIdsOffset, sizeof(uint) * (uint64_t)fileSets[i].count))
+            return 0;
+    }
+    return 1;
+}
+
+uint ecsLoadInstance(EcsInstance* instance, const char* path)
+{
+    assert(instance->EntityContainer.count == 0 && instance->ArchetypeContainer.count == 0 && instance->QueryContainer.count == 0 && "load into a new instance");
+    assert(instance->FileContainer.data == NULL);
+
+    size_t fileSize = 0;
+    byte* data = (byte*)ecsMapFile(path, &fileSize);
+    if (data == NULL)
+        return 0;
+    if (ecsFileIsValid(data, fileSize) == 0)
+    {
+        ecsUnmapFile(data, fileSize);
+        return 0;
+    }
+    const EcsFileHeader* header = (const EcsFileHeader*)data;
+    instance->FileContainer.data = data;
+    instance->FileContainer.size = fileSize;
+
+    // entities, in place
+    ecsFree(instance, instance->EntityContainer.entities, sizeof(EcsEntity) * instance->EntityContainer.capacity);
+    ecsFree(instance, instance->EntityContainer.infos, sizeof(EcsEntityInfo) * instance->EntityContainer.capacity);
+    instance->EntityContainer.entities = (EcsEntity*)(data + header->entitiesOffset);
+    instance->EntityContainer.infos = (EcsEntityInfo*)(data + header->infosOffset);
+    instance->EntityContainer.count = header->entityCount;
+    instance->EntityContainer.capacity = header->entityCapacity;
+
+    // sparse sets, before archetypes and queries like ecsCreateSparseComponent requires
+    const EcsFileSparseSet* fileSets = (const EcsFileSparseSet*)(data + header->sparseOffset);
+    for (uint i = 0; i < header->sparseCount; ++i)
+    {
+        const EcsFileSparseSet* fileSet = fileSets + i;
+        ecsCreateSparseComponent(instance, fileSet->componentId, (size_t)fileSet->stride);
+        if (fileSet->count == 0)
+            continue;
+
+        ecsReserveSparseCapacity(instance, fileSet->componentId, fileSet->count);
+        EcsSparseSet* set = &instance->SparseContainer.sets[fileSet->componentId];
+        memcpy(set->components, data + fileSet->componentsOffset, set->stride * fileSet->count);
+        memcpy(set->entityIds, data + fileSet->entityIdsOffset, sizeof(uint) * fileSet->count);
+        set->count = fileSet->count;
+        for (uint index = 0; index < set->count; ++index)
+        {
+            ecsGrowSparseIndex(instance, set, set->entityIds[index]);
+            set->sparse[set->entityIds[index]] = index;
+        }
+    }
+
+    // archetypes, columns in place
+    ecsReserveArchetypeCapacity(instance, header->archetypeCount);
+    memcpy(instance->ArchetypeContainer.signatures, data + header->signaturesOffset, sizeof(EcsArchetypeSignature) * header->archetypeCount);
+    memcpy(instance->ArchetypeContainer.archetypes, data + header->archetypesOffset, sizeof(EcsArchetype) * header->archetypeCount);
+    instance->ArchetypeContainer.count = header->archetypeCount;
+    for (uint archId = 0; archId < header->archetypeCount; ++archId)
+    {
+        EcsArchetype* archetype = instance->ArchetypeContainer.archetypes + archId;
+        const EcsArchetypeSignature* signature = instance->ArchetypeContainer.signatures + archId;
+        archetype->migrateColumns = NULL;
+        archetype->migrateBegin = 0;
+        archetype->migrateEnd = 0;
+        archetype->migrateCapacity = 0;
+        if (archetype->entityCapacity == 0)
+            continue;
+
+        archetype->entityIds = (uint*)(data + (uintptr_t)archetype->entityIds);
+        archetype->enabledMask = (uint64_t*)(data + (uintptr_t)archetype->enabledMask);
+        for (const uint* sigIdItr = signature->componentIds; *sigIdItr != (uint)-1; ++sigIdItr)
+        {
+            EcsComponentArray* compArray = &archetype->componentArrays[*sigIdItr];
+            compArray->components = data + (uintptr_t)compArray->components;
+        }
+    }
+
+    // queries, archetype offsets to pointers
+    ecsReserveQueryCapacity(instance, header->queryCount);
+    memcpy(instance->QueryContainer.queries, data + header->queriesOffset, sizeof(EcsQuery) * header->queryCount);
+    instance->QueryContainer.count = header->queryCount;
+    ecsRebaseQueries(instance, 0);
+
+    // column tables, from the mapped columns
+    for (uint queryId = 0; queryId < header->queryCount; ++queryId)
+    {
+        EcsQuery* query = &instance->QueryContainer.queries[queryId];
+        const uint archetypeCount = query->archetypeCount;
+        query->archetypeCount = 0;
+        for (uint archIdx = 0; archIdx < archetypeCount; ++archIdx)
+            ecsAppendQueryArchetype(instance, queryId, query->archetypes[archIdx]);
+    }
+
+    return 1;
+}
+
+//=======================================================================
+// Delta encoding
+
+#define ECS_DELTA_MAGIC 0x44534345 // "ECSD"
+
+typedef struct EcsDeltaHeader
+{
+    uint magic;
+    uint fromFrame;
+    uint toFrame;
+    uint eventCount; // uints of structural events following the header
+    uint recordCount; // column ranges following the events
+    uint reserved;
+    uint64_t size; // total bytes of the delta
+} EcsDeltaHeader;
+
+// a changed byte range of a column, or of a sparse set when archetypeId is ECS_INVALID_ID
+// followed by encodedSize bytes of zero run / literal pairs of the range xor its baseline
+typedef struct EcsDeltaRecord
+{
+    uint archetypeId;
+    uint componentId;
+    uint64_t begin;
+    uint size;
+    uint encodedSize;
+} EcsDeltaRecord;
+
+// grow a baseline to size bytes, new bytes are zero on both sides
+static void ecsDeltaGrowBaseline(EcsInstance* instance, EcsDeltaBaseline* baseline, size_t size)
+{
+    if (size <= baseline->size)
+        return;
+    ecsRealtimeAllocation(instance);
+    baseline->data = (byte*)ecsRealloc(instance, baseline->data, baseline->size, size);
+    assert(baseline->data);
+    memset(baseline->data + baseline->size, 0, size - baseline->size);
+    baseline->size = size;
+}
+
+// baseline of a snapshot tracker
+static EcsDeltaBaseline* ecsDeltaColumn(EcsInstance* instance, uint snapshotId)
+{
+    struct DeltaContainer_T* delta = &instance->DeltaContainer;
+    if (snapshotId >= delta->columnCapacity)
+    {
+        const uint oldCapacity = delta->columnCapacity;
+        const uint newCapacity = instance->SnapshotContainer.capacity;
+        ecsRealtimeAllocation(instance);
+        delta->columns = (EcsDeltaBaseline*)ecsRealloc(instance, delta->columns, sizeof(EcsDeltaBaseline) * oldCapacity, sizeof(EcsDeltaBaseline) * newCapacity);
+        memset(delta->columns + oldCapacity, 0, sizeof(EcsDeltaBaseline) * (newCapacity - oldCapacity));
+        delta->columnCapacity = newCapacity;
+    }
+    return &delta->columns[snapshotId];
+}
+
+static void ecsDeltaReserveBuffer(EcsInstance* instance, size_t size)
+{
+    struct DeltaContainer_T* delta = &instance->DeltaContainer;
+    if (size <= delta->bufferCapacity)
+        return;
+    size_t newCapacity = delta->bufferCapacity ? delta->bufferCapacity * 2 : 64 * 1024;
+    while (newCapacity < size)
+        newCapacity *= 2;
+    ecsRealtimeAllocation(instance);
+    delta->buffer = (byte*)ecsRealloc(instance, delta->buffer, delta->bufferCapacity, newCapacity);
+    delta->bufferCapacity = newCapacity;
+}
+
+static byte* ecsDeltaWriteVarint(byte* dst, uint value)
+{
+    while (value >= 0x80)
+    {
+        *dst++ = (byte)(value | 0x80);
+        value >>= 7;
+    }
+    *dst++ = (byte)value;
+    return dst;
+}
+
+static const byte* ecsDeltaReadVarint(const byte* src, const byte* end, uint* value)
+{
+    uint result = 0;
+    for (uint shift = 0; src != end && shift < 35; shift += 7)
+    {
+        byte b = *src++;
+        result |= (uint)(b & 0x7F) << shift;
+        if ((b & 0x80) == 0)
+        {
+            *value = result;
+            return src;
+        }
+    }
+    return NULL;
+}
+
+// encode current xor baseline as zero run / literal pairs, literals end at 4 unchanged bytes
+// baseline is updated to current, returns end of the encoded bytes
+// worst case is about size + 2 * size / 5 bytes, pairs other than the first start with a zero run of 4 or more
+static byte* ecsDeltaEncodeRange(byte* dst, const byte* current, byte* baseline, size_t size)
+{
+    size_t i = 0;
+    while (i < size)
+    {
+        // unchanged bytes, 8 at a time
+        const size_t runBegin = i;
+        for (uint64_t a, b; i + 8 <= size; i += 8)
+        {
+            memcpy(&a, current + i, 8);
+            memcpy(&b, baseline + i, 8);
+            if (a != b)
+                break;
+        }
+        while (i < size && current[i] == baseline[i])
+            ++i;
+        if (i == size)
+            break;
+
+        const size_t literalBegin = i;
+        uint unchanged = 0;
+        for (; i < size && unchanged < 4; ++i)
+            unchanged = current[i] == baseline[i] ? unchanged + 1 : 0;
+        if (unchanged == 4)
+            i -= 4;
+        else
+            i -= unchanged;
+
+        dst = ecsDeltaWriteVarint(dst, (uint)(literalBegin - runBegin));
+        dst = ecsDeltaWriteVarint(dst, (uint)(i - literalBegin));
+        for (size_t j = literalBegin; j < i; ++j)
+            *dst++ = current[j] ^ baseline[j];
+    }
+    memcpy(baseline, current, size);
+    return dst;
+}
+
+// decode zero run / literal pairs into baseline, returns 0 if malformed
+static uint ecsDeltaDecodeRange(byte* baseline, size_t size, const byte* src, size_t encodedSize)
+{
+    const byte* end = src + encodedSize;
+    size_t i = 0;
+    while (src != end)
+    {
+        uint run, literal;
+        src = ecsDeltaReadVarint(src, end, &run);
+        if (src == NULL)
+            return 0;
+        src = ecsDeltaReadVarint(src, end, &literal);
+        if (src == NULL || (size_t)run + literal > size - i || (size_t)(end - src) < literal)
+            return 0;
+        i += run;
+        for (const byte* literalEnd = src + literal; src != literalEnd; ++i)
+            baseline[i] ^= *src++;
+    }
+    return 1;
+}
+
+// append a record for a changed range, dropped if nothing changed
+static size_t ecsDeltaEncodeRecord(EcsInstance* instance, size_t offset, uint archetypeId, uint componentId, const byte* current, byte* baseline, size_t begin, size_t size, uint* recordCount)
+{
+    ecsDeltaReserveBuffer(instance, offset + sizeof(EcsDeltaRecord) + size + size / 2 + 16);
+    byte* recordBegin = instance->DeltaContainer.buffer + offset;
+    byte* encodedBegin = recordBegin + sizeof(EcsDeltaRecord);
+    byte* encodedEnd = ecsDeltaEncodeRange(encodedBegin, current + begin, baseline + begin, size);
+    if (encodedEnd == encodedBegin)
+        return offset;
+
+    EcsDeltaRecord record = { archetypeId, componentId, begin, (uint)size, (uint)(encodedEnd - encodedBegin) };
+    memcpy(recordBegin, &record, sizeof(EcsDeltaRecord));
+    ++*recordCount;
+    return offset + sizeof(EcsDeltaRecord) + record.encodedSize;
+}
+
+void ecsEnableDelta(EcsInstance* instance)
+{
+    if (instance->DeltaContainer.enabled)
+        return;
+    instance->DeltaContainer.enabled = 1;
+
+    // every dense component is tracked, sparse sets are encoded whole
+    for (uint componentId = 0; componentId < ECS_MAX_COMPONENT_TYPES; ++componentId)
+    {
+        if (instance->SparseContainer.components[componentId] == 0)
+            ecsEnableSnapshot(instance, componentId);
+    }
+}
+
+const void* ecsEncodeDelta(EcsInstance* instance, size_t* size)
+{
+    struct DeltaContainer_T* delta = &instance->DeltaContainer;
+    assert(delta->enabled && "see ecsEnableDelta");
+
+    size_t offset = sizeof(EcsDeltaHeader) + sizeof(uint) * delta->eventCount;
+    ecsDeltaReserveBuffer(instance, offset);
+    memcpy(delta->buffer + sizeof(EcsDeltaHeader), delta->events, sizeof(uint) * delta->eventCount);
+    uint recordCount = 0;
+
+    // changed chunks of columns
+    struct SnapshotContainer_T* snap = &instance->SnapshotContainer;
+    for (uint snapshotId = 0; snapshotId < snap->count; ++snapshotId)
+    {
+        EcsSnapshotTracker* tracker = &snap->trackers[snapshotId];
+        const EcsArchetype* archetype = &instance->ArchetypeContainer.archetypes[tracker->archetypeId];
+        const EcsComponentArray* componentArray = &archetype->componentArrays[tracker->componentId];
+        const uint entityCount = archetype->entityCount;
+        EcsDeltaBaseline* baseline = ecsDeltaColumn(instance, snapshotId);
+
+        for (uint chunk = 0, row = 0; chunk < tracker->chunkCapacity; ++chunk, row += ECS_SNAPSHOT_CHUNK_ENTITIES)
+        {
+            if ((tracker->chunks[chunk] & ECS_DELTA_BIT) == 0)
+                continue;
+            tracker->chunks[chunk] &= (byte)~ECS_DELTA_BIT;
+            if (row >= entityCount)
+                continue;
+
+            const uint rowEnd = row + ECS_SNAPSHOT_CHUNK_ENTITIES < entityCount ? row + ECS_SNAPSHOT_CHUNK_ENTITIES : entityCount;
+            ecsDeltaGrowBaseline(instance, baseline, ecsComponentArraySize(componentArray, archetype->entityCapacity));
+            for (uint regionBegin = row, regionEnd; regionBegin < rowEnd; regionBegin = regionEnd)
+            {
+                const byte* components = ecsColumnRegion(archetype, componentArray, regionBegin, &regionEnd);
+                if (regionEnd > rowEnd)
+                    regionEnd = rowEnd;
+                const size_t begin = componentArray->stride * regionBegin;
+                const size_t end = ecsComponentArraySize(componentArray, regionEnd);
+                offset = ecsDeltaEncodeRecord(instance, offset, tracker->archetypeId, tracker->componentId, components, baseline->data, begin, end - begin, &recordCount);
+            }
+        }
+    }
+
+    // sparse sets whole, membership is replayed from the events
+    for (uint i = 0; i < instance->SparseContainer.count; ++i)
+    {
+        const uint componentId = instance->SparseContainer.ids[i];
+        const EcsSparseSet* set = &instance->SparseContainer.sets[componentId];
+        EcsDeltaBaseline* baseline = &delta->sparse[componentId];
+        ecsDeltaGrowBaseline(instance, baseline, set->stride * set->capacity);
+        if (set->count)
+            offset = ecsDeltaEncodeRecord(instance, offset, ECS_INVALID_ID, componentId, set->components, baseline->data, 0, set->stride * set->count, &recordCount);
+    }
+
+    EcsDeltaHeader header;
+    memset(&header, 0, sizeof(EcsDeltaHeader));
+    header.magic = ECS_DELTA_MAGIC;
+    header.fromFrame = delta->frame;
+    header.toFrame = delta->frame + 1;
+    header.eventCount = delta->eventCount;
+    header.recordCount = recordCount;
+    header.size = offset;
+    memcpy(delta->buffer, &header, sizeof(EcsDeltaHeader));
+
+    delta->eventCount = 0;
+    ++delta->frame;
+    *size = offset;
+    return delta->buffer;
+}
+
+// replay structural events, returns 0 if malformed
+static uint ecsDeltaApplyEvents(EcsInstance* instance, const uint* events, uint eventCount)
+{
+    const uint* end = events + eventCount;
+    while (events != end)
+    {
+        const uint type = *events++;
+        const uint remaining = (uint)(end - events);
+        switch (type)
+        {
+        case ECS_DELTA_CREATE_ARCHETYPE:
+        {
+            if (remaining < 2 || events[0] > ECS_MAX_COMPONENT_TYPES || remaining - 2 < events[0] * 3)
+                return 0;
+            EcsComponentDesc descs[ECS_MAX_COMPONENT_TYPES];
+            memcpy(descs, events + 2, sizeof(EcsComponentDesc) * events[0]);
+            for (uint i = 0; i < events[0]; ++i)
+            {
+                if (descs[i].id >= ECS_MAX_COMPONENT_TYPES || instance->SparseContainer.components[descs[i].id])
+                    return 0;
+            }
+            ecsCreateArchetype(instance, events[0], descs, events[1]);
+            events += 2 + events[0] * 3;
+            break;
+        }
+        case ECS_DELTA_CREATE_ENTITY:
+            if (remaining < 2 || events[0] != instance->EntityContainer.count || events[1] >= instance->ArchetypeContainer.count)
+                return 0;
+            ecsCreateEntity(instance, events[1]);
+            events += 2;
+            break;
+        case ECS_DELTA_DESTROY_ENTITY:
+            if (remaining < 1 || ecsEntityAlive(instance, events[0]) == 0)
+                return 0;
+            ecsDestroyEntity(instance, events[0]);
+            events += 1;
+            break;
+        case ECS_DELTA_DESTROY_ENTITIES:
+            if (remaining < 1 || remaining - 1 < events[0])
+                return 0;
+            for (uint i = 0; i < events[0]; ++i)
+            {
+                if (events[1 + i] >= instance->EntityContainer.count)
+                    return 0;
+            }
+            ecsDestroyEntities(instance, events[0], events + 1);
+            events += 1 + events[0];
+            break;
+        case ECS_DELTA_ADD_COMPONENT:
+            if (remaining < 3 || ecsEntityAlive(instance, events[0]) == 0 || events[1] >= ECS_MAX_COMPONENT_TYPES || instance->SparseContainer.components[events[1]])
+                return 0;
+            ecsAddComponentToEntity(instance, events[0], events[1], events[2]);
+            events += 3;
+            break;
+        case ECS_DELTA_ADD_SPARSE_COMPONENT:
+        case ECS_DELTA_REMOVE_SPARSE_COMPONENT:
+            if (remaining < 2 || ecsEntityAlive(instance, events[0]) == 0 || events[1] >= ECS_MAX_COMPONENT_TYPES || instance->SparseContainer.components[events[1]] == 0)
+                return 0;
+            if (type == ECS_DELTA_ADD_SPARSE_COMPONENT)
+                ecsAddSparseComponent(instance, events[0], events[1]);
+            else
+                ecsRemoveSparseComponent(instance, events[0], events[1]);
+            events += 2;
+            break;
+        case ECS_DELTA_SET_ENTITY_ENABLED:
+            if (remaining < 2 || ecsEntityAlive(instance, events[0]) == 0)
+                return 0;
+            ecsSetEntityEnabled(instance, events[0], events[1]);
+            events += 2;
+            break;
+        default:
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// decode changed ranges into the baselines and copy them to the live columns, returns 0 if malformed
+static uint ecsDeltaApplyRecords(EcsInstance* instance, const byte* data, const byte* end, uint recordCount)
+{
+    for (uint i = 0; i < recordCount; ++i)
+    {
+        EcsDeltaRecord record;
+        if ((size_t)(end - data) < sizeof(EcsDeltaRecord))
+            return 0;
+        memcpy(&record, data, sizeof(EcsDeltaRecord));
+        data += sizeof(EcsDeltaRecord);
+        if ((size_t)(end - data) < record.encodedSize || record.componentId >= ECS_MAX_COMPONENT_TYPES)
+            return 0;
+
+        EcsDeltaBaseline* baseline;
+        byte* components;
+        size_t liveSize;
+        size_t baselineSize;
+        if (record.archetypeId == ECS_INVALID_ID)
+        {
+            if (instance->SparseContainer.components[record.componentId] == 0)
+                return 0;
+            EcsSparseSet* set = &instance->SparseContainer.sets[record.componentId];
+            baseline = &instance->DeltaContainer.sparse[record.componentId];
+            components = set->components;
+            liveSize = set->stride * set->count;
+            baselineSize = set->stride * set->capacity;
+        }
+        else
+        {
+            if (record.archetypeId >= instance->ArchetypeContainer.count)
+                return 0;
+            EcsArchetype* archetype = &instance->ArchetypeContainer.archetypes[record.archetypeId];
+            EcsComponentArray* componentArray = &archetype->componentArrays[record.componentId];
+            if (componentArray->snapshotId == ECS_INVALID_ID)
+                return 0;
+            ecsFinishArchetypeGrowth(instance, archetype, &instance->ArchetypeContainer.signatures[record.archetypeId]);
+            baseline = ecsDeltaColumn(instance, componentArray->snapshotId);
+            components = componentArray->components;
+            liveSize = ecsComponentArraySize(componentArray, archetype->entityCount);
+            baselineSize = ecsComponentArraySize(componentArray, archetype->entityCapacity);
+        }
+        if (record.begin > liveSize || record.size > liveSize - record.begin)
+            return 0;
+
+        ecsDeltaGrowBaseline(instance, baseline, baselineSize);
+        if (ecsDeltaDecodeRange(baseline->data + record.begin, record.size, data, record.encodedSize) == 0)
+            return 0;
+        memcpy(components + record.begin, baseline->data + record.begin, record.size);
+        data += record.encodedSize;
+    }
+    return data == end;
+}
+
+uint ecsApplyDelta(EcsInstance* instance, const void* delta, size_t size)
+{
+    struct DeltaContainer_T* deltaContainer = &instance->DeltaContainer;
+    assert(deltaContainer->enabled && "see ecsEnableDelta");
+
+    EcsDeltaHeader header;
+    if (size < sizeof(EcsDeltaHeader))
+        return 0;
+    memcpy(&header, delta, sizeof(EcsDeltaHeader));
+    if (header.magic != ECS_DELTA_MAGIC || header.size != size || header.fromFrame != deltaContainer->frame ||
+        (size - sizeof(EcsDeltaHeader)) / sizeof(uint) < header.eventCount)
+        return 0;
+
+    const byte* data = (const byte*)delta + sizeof(EcsDeltaHeader);
+    const byte* end = (const byte*)delta + size;
+
+    // events may be unaligned in the caller's buffer, staged in the event array which is unused while applying
+    ++deltaContainer->depth;
+    deltaContainer->eventCount = 0;
+    uint bApplied = 1;
+    if (header.eventCount)
+    {
+        ecsDeltaAppend(instance, header.eventCount, data);
+        bApplied = ecsDeltaApplyEvents(instance, deltaContainer->events, header.eventCount);
+    }
+    deltaContainer->eventCount = 0;
+    data += sizeof(uint) * header.eventCount;
+    if (bApplied)
+        bApplied = ecsDeltaApplyRecords(instance, data, end, header.recordCount);
+    --deltaContainer->depth;
+
+    if (bApplied)
+        deltaContainer->frame = header.toFrame;
+    return bApplied;
+}
+
+uint ecsGetDeltaFrame(EcsInstance* instance)
+{
+    return instance->DeltaContainer.frame;
+}
+
+//=======================================================================
+// Capacity profile
+
+// capacity profile keys, the kind of container in the top byte and its archetypeId or componentId below
+#define ECS_PROFILE_KEY_KIND       0xFF000000u
+#define ECS_PROFILE_KEY_ENTITIES   0x01000000u
+#define ECS_PROFILE_KEY_ARCHETYPES 0x02000000u
+#define ECS_PROFILE_KEY_QUERIES    0x03000000u
+#define ECS_PROFILE_KEY_DESTROY    0x04000000u
+#define ECS_PROFILE_KEY_ARCHETYPE  0x05000000u
+#define ECS_PROFILE_KEY_SPARSE     0x06000000u
+
+// growths are counted by the instance, not by capacity changes seen between records
+static void ecsProfileRecord(CList* profile, uint key, uint peak, uint capacity, uint growthCount)
+{
+    ccapacityprofileRecord(profile, key, peak, capacity);
+    ccapacityprofileFind(profile, key)->GrowthCount = growthCount;
+}
+
+uint ecsSaveCapacityProfile(EcsInstance* instance, const char* path)
+{
+    const struct ProfileContainer_T* loaded = &instance->ProfileContainer;
+    CList profile = ccapacityprofileCreate(4 + instance->ArchetypeContainer.count + instance->SparseContainer.count);
+    const uint entityPeak = instance->EntityContainer.count > loaded->entityPeak ? instance->EntityContainer.count : loaded->entityPeak;
+    ecsProfileRecord(&profile, ECS_PROFILE_KEY_ENTITIES, entityPeak, instance->EntityContainer.capacity, loaded->entityGrowthCount);
+    ecsProfileRecord(&profile, ECS_PROFILE_KEY_ARCHETYPES, instance->ArchetypeContainer.count, instance->ArchetypeContainer.capacity, 0);
+    ecsProfileRecord(&profile, ECS_PROFILE_KEY_QUERIES, instance->QueryContainer.count, instance->QueryContainer.capacity, 0);
+    ecsProfileRecord(&profile, ECS_PROFILE_KEY_DESTROY, instance->ScratchContainer.capacity, instance->ScratchContainer.capacity, 0);
+    for (uint archId = 0; archId < instance->ArchetypeContainer.count; ++archId)
+    {
+        const EcsArchetype* archetype = instance->ArchetypeContainer.archetypes + archId;
+        uint peak = archetype->peakEntityCount;
+        if (archId < loaded->archetypeCount && loaded->archetypePeaks[archId] > peak)
+            peak = loaded->archetypePeaks[archId];
+        ecsProfileRecord(&profile, ECS_PROFILE_KEY_ARCHETYPE | archId, peak, archetype->entityCapacity, archetype->growthCount);
+    }
+    for (uint i = 0; i < instance->SparseContainer.count; ++i)
+    {
+        const uint componentId = instance->SparseContainer.ids[i];
+        const EcsSparseSet* set = &instance->SparseContainer.sets[componentId];
+        const uint peak = set->peakCount > loaded->sparsePeaks[componentId] ? set->peakCount : loaded->sparsePeaks[componentId];
+        ecsProfileRecord(&profile, ECS_PROFILE_KEY_SPARSE | componentId, peak, set->capacity, 0);
+    }
+    const uint bWritten = ccapacityprofileSave(&profile, path);
+    ccapacityprofileFree(&profile);
+    return bWritten;
+}
+
+uint ecsLoadCapacityProfile(EcsInstance* instance, const char* path)
+{
+    assert(instance->ArchetypeContainer.count == 0 && "load into a new instance");
+    CList entries = ccapacityprofileCreate(16);
+    if (ccapacityprofileLoad(&entries, path) == 0)
+    {
+        ccapacityprofileFree(&entries);
+        return 0;
+    }
+
+    const CCapacityProfileEntry* begin = (const CCapacityProfileEntry*)clistBegin(&entries);
+    const CCapacityProfileEntry* end = (const CCapacityProfileEntry*)clistEnd(&entries);
+    uint archetypeCount = 0;
+    uint bValid = 1;
+    for (const CCapacityProfileEntry* itr = begin; itr != end; ++itr)
+    {
+        const uint kind = itr->Key & ECS_PROFILE_KEY_KIND;
+        const uint id = itr->Key & ~ECS_PROFILE_KEY_KIND;
+        if (kind < ECS_PROFILE_KEY_ENTITIES || kind > ECS_PROFILE_KEY_SPARSE)
+            bValid = 0;
+        else if (kind == ECS_PROFILE_KEY_ARCHETYPE)
+            archetypeCount = id + 1 > archetypeCount ? id + 1 : archetypeCount;
+        else if (kind == ECS_PROFILE_KEY_SPARSE)
+            bValid &= id < ECS_MAX_COMPONENT_TYPES;
+        else
+            bValid &= id == 0;
+    }
+    if (bValid == 0)
+    {
+        ccapacityprofileFree(&entries);
+        return 0;
+    }
+
+    // archetype peaks are indexed by archetypeId, up to the largest recorded id
+    struct ProfileContainer_T* profile = &instance->ProfileContainer;
+    if (archetypeCount && profile->archetypePeaks == NULL)
+    {
+        ecsRealtimeAllocation(instance);
+        profile->archetypePeaks = (uint*)ecsAlloc(instance, sizeof(uint) * archetypeCount);
+        memset(profile->archetypePeaks, 0, sizeof(uint) * archetypeCount);
+        profile->archetypeCount = archetypeCount;
+    }
+    for (const CCapacityProfileEntry* itr = begin; itr != end; ++itr)
+    {
+        const uint id = itr->Key & ~ECS_PROFILE_KEY_KIND;
+        const uint peak = (uint)itr->PeakCount;
+        switch (itr->Key & ECS_PROFILE_KEY_KIND)
+        {
+        case ECS_PROFILE_KEY_ENTITIES:
+            profile->entityPeak = peak;
+            ecsReserveEntityCapacity(instance, peak);
+            break;
+        case ECS_PROFILE_KEY_ARCHETYPES: ecsReserveArchetypeCapacity(instance, peak); break;
+        case ECS_PROFILE_KEY_QUERIES: ecsReserveQueryCapacity(instance, peak); break;
+        case ECS_PROFILE_KEY_DESTROY: ecsReserveDestroyCapacity(instance, peak); break;
+        case ECS_PROFILE_KEY_ARCHETYPE:
+            if (id < profile->archetypeCount)
+                profile->archetypePeaks[id] = peak;
+            break;
+        default: profile->sparsePeaks[id] = peak; break;
+        }
+    }
+    ccapacityprofileFree(&entries);
+    return 1;
+}